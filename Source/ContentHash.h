@@ -0,0 +1,52 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+// 64-bit FNV-1a, for telling sources and cache entries apart - not for resisting tampering.
+// addSamples() folds in whole 64-bit words, so hashing minutes of audio stays in the milliseconds.
+struct ContentHash
+{
+ juce::uint64 hash = 14695981039346656037ull;
+
+ void add (const void* data, size_t numBytes) noexcept
+ {
+  auto* bytes = static_cast<const juce::uint8*> (data);
+  for (size_t i = 0; i < numBytes; ++i)
+   mix (bytes[i]);
+ }
+
+ template <typename T>
+ void addValue (T value) noexcept { add (&value, sizeof (value)); }
+
+ void addSamples (const float* samples, int numSamples) noexcept
+ {
+  int i = 0;
+  for (; i + 1 < numSamples; i += 2)
+  {
+   juce::uint64 word;
+   std::memcpy (&word, samples + i, sizeof (word));
+   mix (word);
+  }
+
+  if (i < numSamples)
+   addValue (samples[i]);
+ }
+
+ void addBuffer (const juce::AudioBuffer<float>& buffer) noexcept
+ {
+  addValue (buffer.getNumChannels());
+  addValue (buffer.getNumSamples());
+
+  for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+   addSamples (buffer.getReadPointer (channel), buffer.getNumSamples());
+ }
+
+ juce::String toString() const { return juce::String::toHexString ((juce::int64) hash).paddedLeft ('0', 16); }
+
+private:
+ void mix (juce::uint64 value) noexcept
+ {
+  hash ^= value;
+  hash *= 1099511628211ull;
+ }
+};
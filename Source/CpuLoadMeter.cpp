@@ -0,0 +1,121 @@
+#include "CpuLoadMeter.h"
+#include <cmath>
+
+namespace
+{
+ // Single writer: a plain load and store, no read-modify-write
+ template <typename Type>
+ void add (std::atomic<Type>& value, Type amount) noexcept
+ {
+  value.store (value.load (std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+ }
+}
+
+CpuLoadMeter::CpuLoadMeter()
+ : secondsPerTick (1.0 / (double) juce::Time::getHighResolutionTicksPerSecond())
+{
+ clear();
+}
+
+void CpuLoadMeter::prepare (double newSampleRate) noexcept
+{
+ sampleRate = newSampleRate > 0.0 ? newSampleRate : 44100.0;
+ resetRequested = false;
+ clear();
+}
+
+void CpuLoadMeter::record (juce::int64 elapsedTicks, int blockSamples) noexcept
+{
+ if (blockSamples <= 0)
+  return;
+
+ if (resetRequested.exchange (false, std::memory_order_acquire))
+  clear();
+
+ const double seconds = (double) elapsedTicks * secondsPerTick;
+ const double load = seconds * sampleRate / blockSamples;
+ const auto blocksSoFar = numBlocks.load (std::memory_order_relaxed);
+
+ add (buckets[(size_t) getBucket (load)], (juce::int64) 1);
+ add (numSamples, (juce::int64) blockSamples);
+ add (totalSeconds, seconds);
+ add (totalLoad, load);
+
+ if (load > 1.0)
+  add (numOverruns, (juce::int64) 1);
+
+ if (blocksSoFar == 0 || load < minLoad.load (std::memory_order_relaxed))
+  minLoad.store (load, std::memory_order_relaxed);
+
+ if (load > maxLoad.load (std::memory_order_relaxed))
+  maxLoad.store (load, std::memory_order_relaxed);
+
+ // Last, so a reader never sees a block counted before its load
+ numBlocks.store (blocksSoFar + 1, std::memory_order_release);
+}
+
+CpuLoadMeter::Stats CpuLoadMeter::getStats() const noexcept
+{
+ Stats stats;
+ stats.numBlocks = numBlocks.load (std::memory_order_acquire);
+
+ if (stats.numBlocks == 0)
+  return stats;
+
+ stats.numOverruns = numOverruns.load (std::memory_order_relaxed);
+ stats.minLoad = minLoad.load (std::memory_order_relaxed);
+ stats.maxLoad = maxLoad.load (std::memory_order_relaxed);
+ stats.averageLoad = totalLoad.load (std::memory_order_relaxed) / (double) stats.numBlocks;
+
+ const double seconds = totalSeconds.load (std::memory_order_relaxed);
+ stats.samplesPerSecond = seconds > 0.0 ? (double) numSamples.load (std::memory_order_relaxed) / seconds : 0.0;
+
+ // The counts can run a block ahead of numBlocks while the audio thread writes - a meter can live with that
+ juce::int64 total = 0;
+ for (auto& bucket : buckets)
+  total += bucket.load (std::memory_order_relaxed);
+
+ const auto target = (juce::int64) std::ceil (0.99 * (double) total);
+ juce::int64 count = 0;
+
+ for (int i = 0; i < numBuckets; ++i)
+ {
+  count += buckets[(size_t) i].load (std::memory_order_relaxed);
+
+  if (count >= target)
+  {
+   stats.p99Load = juce::jlimit (stats.minLoad, stats.maxLoad, getBucketUpperLoad (i));
+   break;
+  }
+ }
+
+ return stats;
+}
+
+int CpuLoadMeter::getBucket (double load) noexcept
+{
+ if (! (load > 0.0))
+  return 0;
+
+ const auto bucket = (int) std::floor ((std::log2 (load) - lowestOctave) * bucketsPerOctave);
+ return juce::jlimit (0, numBuckets - 1, bucket + 1);
+}
+
+double CpuLoadMeter::getBucketUpperLoad (int bucket) noexcept
+{
+ return std::exp2 (lowestOctave + (double) bucket / bucketsPerOctave);
+}
+
+void CpuLoadMeter::clear() noexcept
+{
+ for (auto& bucket : buckets)
+  bucket.store (0, std::memory_order_relaxed);
+
+ numOverruns.store (0, std::memory_order_relaxed);
+ numSamples.store (0, std::memory_order_relaxed);
+ totalLoad.store (0.0, std::memory_order_relaxed);
+ totalSeconds.store (0.0, std::memory_order_relaxed);
+ minLoad.store (0.0, std::memory_order_relaxed);
+ maxLoad.store (0.0, std::memory_order_relaxed);
+ numBlocks.store (0, std::memory_order_release);
+}
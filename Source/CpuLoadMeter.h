@@ -0,0 +1,88 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <atomic>
+
+// Per-block CPU load of the audio thread, as a fraction of each block's
+// real-time budget (numSamples / sampleRate): 0.25 means the block took a
+// quarter of the time the host allows it.
+//
+// The audio thread times each block with the high-resolution tick counter and
+// files the load into a histogram of logarithmic buckets (8 per octave, about
+// 9% apart), so a percentile costs a walk over the buckets rather than a sort.
+// There is exactly one writer: every counter is an atomic the audio thread
+// updates with plain relaxed loads and stores, and any other thread can read a
+// snapshot with getStats() without ever blocking it. A reset is requested from
+// any thread and carried out by the audio thread on its next block.
+class CpuLoadMeter
+{
+public:
+ struct Stats
+ {
+  juce::int64 numBlocks = 0;
+  juce::int64 numOverruns = 0; // Blocks that took longer than their budget
+
+  // Fractions of the block budget (1.0 = all of it)
+  double minLoad = 0.0;
+  double averageLoad = 0.0;
+  double p99Load = 0.0;  // Upper edge of the bucket holding the 99th percentile
+  double maxLoad = 0.0;
+
+  double samplesPerSecond = 0.0; // Throughput: samples processed per second spent processing
+ };
+
+ CpuLoadMeter();
+
+ // Not concurrently with the audio thread (prepareToPlay): sets the rate the budgets derive from, and resets
+ void prepare (double sampleRate) noexcept;
+
+ // Any thread: the statistics start over from the audio thread's next block
+ void reset() noexcept { resetRequested = true; }
+
+ // Audio thread: times the enclosing scope as one block of numSamples
+ class ScopedMeasurement
+ {
+ public:
+  ScopedMeasurement (CpuLoadMeter& meterToUse, int numSamplesToRecord) noexcept
+   : meter (meterToUse), numSamples (numSamplesToRecord), startTicks (juce::Time::getHighResolutionTicks()) {}
+
+  ~ScopedMeasurement() noexcept { meter.record (juce::Time::getHighResolutionTicks() - startTicks, numSamples); }
+
+ private:
+  CpuLoadMeter& meter;
+  const int numSamples;
+  const juce::int64 startTicks;
+
+  JUCE_DECLARE_NON_COPYABLE (ScopedMeasurement)
+ };
+
+ // Audio thread: one block of numSamples that took elapsedTicks (high-resolution ticks)
+ void record (juce::int64 elapsedTicks, int numSamples) noexcept;
+
+ // Any thread
+ Stats getStats() const noexcept;
+
+private:
+ static constexpr int bucketsPerOctave = 8;
+ static constexpr int lowestOctave = -14; // Loads under 2^-14 (0.006%) share bucket 0
+ static constexpr int numOctaves = 18;    // Up to 16x the budget
+ static constexpr int numBuckets = 1 + bucketsPerOctave * numOctaves;
+
+ static int getBucket (double load) noexcept;
+ static double getBucketUpperLoad (int bucket) noexcept;
+
+ void clear() noexcept;
+
+ double sampleRate = 44100.0;
+ double secondsPerTick;
+
+ std::atomic<bool> resetRequested { false };
+
+ std::array<std::atomic<juce::int64>, (size_t) numBuckets> buckets;
+ std::atomic<juce::int64> numBlocks { 0 }, numOverruns { 0 }, numSamples { 0 };
+ std::atomic<double> totalLoad { 0.0 }, totalSeconds { 0.0 };
+ std::atomic<double> minLoad { 0.0 }, maxLoad { 0.0 };
+
+ JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CpuLoadMeter)
+};
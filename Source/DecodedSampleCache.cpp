@@ -0,0 +1,57 @@
+#include "DecodedSampleCache.h"
+#include "ContentHash.h"
+
+DecodedSampleCache::DecodedSampleCache (const juce::File& cacheDirectory, juce::int64 maxBytesToKeep)
+ : files (cacheDirectory, maxBytesToKeep, "Decoded")
+{
+}
+
+juce::File DecodedSampleCache::getDefaultDirectory()
+{
+ return PcmFileCache::getUserCacheRoot().getChildFile ("Decoded");
+}
+
+bool DecodedSampleCache::isWorthCaching (const juce::File& sourceFile)
+{
+ return ! sourceFile.hasFileExtension ("wav;wave;aif;aiff");
+}
+
+juce::String DecodedSampleCache::makeKey (const juce::File& sourceFile) const
+{
+ juce::FileInputStream in (sourceFile);
+ if (in.failedToOpen())
+  return {};
+
+ ContentHash hash;
+ const auto path = sourceFile.getFullPathName();
+ hash.add (path.toRawUTF8(), path.getNumBytesAsUTF8());
+ hash.addValue (sourceFile.getSize());
+ hash.addValue (sourceFile.getLastModificationTime().toMilliseconds());
+
+ std::vector<char> block (1 << 16);
+ for (;;)
+ {
+  const int bytesRead = in.read (block.data(), (int) block.size());
+  if (bytesRead <= 0)
+   break;
+
+  hash.add (block.data(), (size_t) bytesRead);
+ }
+
+ return hash.toString();
+}
+
+SourceSample::Ptr DecodedSampleCache::find (const juce::String& key)
+{
+ PcmFileCache::Entry entry;
+ if (! files.find (key, entry))
+  return nullptr;
+
+ // SourceSample's buffer is const, so the mapping is never written through
+ return new SourceSample (std::move (entry.mapping), entry.channels, entry.numChannels, entry.numSamples, entry.sampleRate);
+}
+
+void DecodedSampleCache::store (const juce::String& key, const SourceSample& decoded)
+{
+ files.store (key, decoded.getBuffer(), decoded.getSampleRate());
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "RenderedSample.h"
+#include "PcmFileCache.h"
+
+// On-disk cache of decoded PCM for compressed sources (MP3, FLAC, Ogg...).
+//
+// Each entry is named after a hash of the source's path, size, modification
+// time and content, and find() memory-maps it straight into a SourceSample, so
+// a repeat load is a hash of the file and an mmap instead of a decode. Storage,
+// the size cap and LRU eviction are PcmFileCache's. One cache per loader thread.
+class DecodedSampleCache
+{
+public:
+ static constexpr juce::int64 defaultMaxBytes = (juce::int64) 1 << 30; // 1 GB
+
+ explicit DecodedSampleCache (const juce::File& cacheDirectory = getDefaultDirectory(),
+                              juce::int64 maxBytesToKeep = defaultMaxBytes);
+
+ static juce::File getDefaultDirectory();
+
+ // Uncompressed formats read about as fast as the cache would, so they skip it
+ static bool isWorthCaching (const juce::File& sourceFile);
+
+ // Hash of path, size, modification time and content - reads the whole file.
+ // Empty if the file can't be read.
+ juce::String makeKey (const juce::File& sourceFile) const;
+
+ // The cached decode for this key, mapped read-only, or nullptr on a miss
+ SourceSample::Ptr find (const juce::String& key);
+
+ // Writes decoded under key, then evicts down to the size cap
+ void store (const juce::String& key, const SourceSample& decoded);
+
+ // Deletes every entry - safe from any thread
+ void purge() const { files.purge(); }
+
+private:
+ PcmFileCache files;
+
+ JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DecodedSampleCache)
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <vector>
+
+// The cubic fade-in/fade-out gain for every position of a render, precomputed.
+// Only the fade regions are stored - everything between them is unity gain.
+// Immutable once built, so playback (through a RealtimeHandoff), export and the
+// waveform overlay all read the same tables, and export matches playback exactly.
+class FadeEnvelope : public juce::ReferenceCountedObject
+{
+public:
+ using Ptr = juce::ReferenceCountedObjectPtr<FadeEnvelope>;
+
+ // fadeIn / fadeOut are fractions of the render length
+ FadeEnvelope (int numSamplesToUse, float fadeInToUse, float fadeOutToUse)
+  : numSamples (juce::jmax (0, numSamplesToUse)), fadeIn (fadeInToUse), fadeOut (fadeOutToUse)
+ {
+  if (numSamples == 0)
+   return;
+
+  // Fade in with cubic curve for sharper fade
+  if (fadeIn > 0.0f)
+  {
+   fadeInTable.resize ((size_t) juce::jlimit (0, numSamples, (int) std::ceil (fadeIn * (float) numSamples)));
+
+   for (size_t i = 0; i < fadeInTable.size(); ++i)
+   {
+    float fadePos = ((float) i / (float) numSamples) / fadeIn;
+    fadeInTable[i] = fadePos * fadePos * fadePos;
+   }
+  }
+
+  // Fade out with cubic curve for sharper fade
+  if (fadeOut > 0.0f)
+  {
+   fadeOutStart = juce::jlimit (0, numSamples, (int) ((1.0f - fadeOut) * (float) numSamples));
+   fadeOutTable.resize ((size_t) (numSamples - fadeOutStart));
+
+   for (size_t i = 0; i < fadeOutTable.size(); ++i)
+   {
+    float samplePosition = (float) (fadeOutStart + (int) i) / (float) numSamples;
+    float fadeOutPos = juce::jmax (0.0f, (1.0f - samplePosition) / fadeOut);
+    fadeOutTable[i] = samplePosition > (1.0f - fadeOut) ? fadeOutPos * fadeOutPos * fadeOutPos : 1.0f;
+   }
+  }
+  else
+  {
+   fadeOutStart = numSamples;
+  }
+ }
+
+ bool matches (int length, float newFadeIn, float newFadeOut) const noexcept
+ {
+  return numSamples == length && fadeIn == newFadeIn && fadeOut == newFadeOut;
+ }
+
+ int getNumSamples() const noexcept { return numSamples; }
+
+ // Gain at one render position (out-of-range positions are silent)
+ float getGain (int position) const noexcept
+ {
+  if (position < 0 || position >= numSamples)
+   return 0.0f;
+
+  float gain = 1.0f;
+  if (position < (int) fadeInTable.size())
+   gain *= fadeInTable[(size_t) position];
+  if (position >= fadeOutStart)
+   gain *= fadeOutTable[(size_t) (position - fadeOutStart)];
+
+  return gain;
+ }
+
+ // Multiplies the gains for render positions [position, position + count) into gains.
+ // Table lookups only - vector multiplies over whatever part of the span is in a fade.
+ void applyTo (float* gains, int position, int count) const noexcept
+ {
+  const int fadeInEnd = juce::jmin (position + count, (int) fadeInTable.size());
+  if (position < fadeInEnd)
+   juce::FloatVectorOperations::multiply (gains, fadeInTable.data() + position, fadeInEnd - position);
+
+  const int outStart = juce::jmax (position, fadeOutStart);
+  const int outEnd = juce::jmin (position + count, numSamples);
+  if (outStart < outEnd)
+   juce::FloatVectorOperations::multiply (gains + (outStart - position), fadeOutTable.data() + (outStart - fadeOutStart), outEnd - outStart);
+ }
+
+ // Applies the envelope to every channel of a buffer of this length (export)
+ void applyTo (juce::AudioBuffer<float>& buffer) const
+ {
+  jassert (buffer.getNumSamples() == numSamples);
+  const int count = juce::jmin (numSamples, buffer.getNumSamples());
+
+  for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+   applyTo (buffer.getWritePointer (channel), 0, count);
+ }
+
+private:
+ const int numSamples;
+ const float fadeIn, fadeOut;
+
+ std::vector<float> fadeInTable;  // Positions [0, fadeInTable.size())
+ std::vector<float> fadeOutTable; // Positions [fadeOutStart, numSamples)
+ int fadeOutStart = 0;
+
+ JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FadeEnvelope)
+};
@@ -0,0 +1,305 @@
+#include "PartitionedConvolver.h"
+#include <atomic>
+#include <memory>
+
+namespace
+{
+ int orderForSize(int size)
+ {
+ int order = 0;
+ while ((1 << order) < size)
+ ++order;
+
+ jassert((1 << order) == size); // Block size must be a power of two
+ return order;
+ }
+}
+
+PartitionedConvolver::PartitionedConvolver(int blockSizeToUse)
+ : blockSize(blockSizeToUse),
+ fftOrder(orderForSize(2 * blockSizeToUse)),
+ fftSize(2 * blockSizeToUse),
+ numBins(blockSizeToUse + 1)
+{
+}
+
+void PartitionedConvolver::reset()
+{
+ partitions.clear();
+ numPartitions = 0;
+}
+
+void PartitionedConvolver::prepare(const juce::AudioBuffer<float>& impulseResponse)
+{
+ reset();
+
+ const int irLength = impulseResponse.getNumSamples();
+ if (irLength == 0 || impulseResponse.getNumChannels() == 0)
+ return;
+
+ numPartitions = (irLength + blockSize - 1) / blockSize;
+
+ juce::dsp::FFT fft(fftOrder);
+ std::vector<float> frame((size_t) (2 * fftSize));
+
+ for (int channel = 0; channel < impulseResponse.getNumChannels(); ++channel)
+ {
+ std::vector<float> spectra((size_t) (numPartitions * numBins * 2));
+ auto* ir = impulseResponse.getReadPointer(channel);
+
+ for (int p = 0; p < numPartitions; ++p)
+ {
+ // Partition p, zero-padded to the FFT size
+ std::fill(frame.begin(), frame.end(), 0.0f);
+ const int start = p * blockSize;
+ const int count = juce::jmin(blockSize, irLength - start);
+ std::copy(ir + start, ir + start + count, frame.begin());
+
+ fft.performRealOnlyForwardTransform(frame.data(), true);
+ std::copy(frame.begin(), frame.begin() + 2 * numBins, spectra.begin() + (size_t) (p * numBins * 2));
+ }
+
+ partitions.push_back(std::move(spectra));
+ }
+
+ DBG("PartitionedConvolver: " << numPartitions << " partitions of " << blockSize << " samples, "
+ << (int) partitions.size() << " IR channel(s)");
+}
+
+bool PartitionedConvolver::process(juce::AudioBuffer<float>& buffer,
+ juce::ThreadPool& pool,
+ const std::function<bool()>& isCancelled,
+ const std::function<void(float)>& reportProgress)
+{
+ if (! isPrepared())
+ {
+ buffer.clear();
+ return true;
+ }
+
+ const int numSamples = buffer.getNumSamples();
+ const int numChannels = buffer.getNumChannels();
+ const int numBlocks = (numSamples + blockSize - 1) / blockSize;
+
+ if (numBlocks == 0 || numChannels == 0)
+ return true;
+
+ const size_t spectrumFloats = (size_t) (numBins * 2);
+ std::vector<float> inputSpectra((size_t) (numChannels * numBlocks) * spectrumFloats);
+
+ // Pass 1: transform every input block together with the block before it (overlap-save frames)
+ auto transformInput = [&] (int item, JobScratch& scratch)
+ {
+ const int channel = item / numBlocks;
+ const int block = item % numBlocks;
+ auto* input = buffer.getReadPointer(channel);
+ auto& frame = scratch.frame;
+
+ std::fill(frame.begin(), frame.end(), 0.0f);
+ for (int i = 0; i < fftSize; ++i)
+ {
+ const int pos = (block - 1) * blockSize + i;
+ if (pos >= 0 && pos < numSamples)
+ frame[(size_t) i] = input[pos];
+ }
+
+ scratch.fft.performRealOnlyForwardTransform(frame.data(), true);
+ std::copy(frame.begin(), frame.begin() + (std::ptrdiff_t) spectrumFloats, inputSpectra.begin() + (std::ptrdiff_t) ((size_t) item * spectrumFloats));
+ };
+
+ if (! runInParallel(pool, numChannels * numBlocks, transformInput, isCancelled, reportProgress, 0.0f, 0.2f))
+ return false;
+
+ // Pass 2: Y[k] = sum over p of X[k - p] * H[p], back to the time domain, keep the last blockSize samples.
+ // Every input block has been read already, so the output can be written in place.
+ auto accumulateOutput = [&] (int item, JobScratch& scratch)
+ {
+ const int channel = item / numBlocks;
+ const int block = item % numBlocks;
+ const auto& irSpectra = partitions[(size_t) juce::jmin(channel, (int) partitions.size() - 1)];
+ auto& acc = scratch.accumulator;
+
+ std::fill(acc.begin(), acc.end(), 0.0f);
+
+ const int lastPartition = juce::jmin(block, numPartitions - 1);
+ for (int p = 0; p <= lastPartition; ++p)
+ {
+ const float* x = inputSpectra.data() + (size_t) (channel * numBlocks + block - p) * spectrumFloats;
+ const float* h = irSpectra.data() + (size_t) p * spectrumFloats;
+
+ for (int bin = 0; bin < numBins; ++bin)
+ {
+ const float xr = x[2 * bin], xi = x[2 * bin + 1];
+ const float hr = h[2 * bin], hi = h[2 * bin + 1];
+ acc[(size_t) (2 * bin)] += xr * hr - xi * hi;
+ acc[(size_t) (2 * bin + 1)] += xr * hi + xi * hr;
+ }
+ }
+
+ // Rebuild the negative frequencies from conjugate symmetry for the inverse transform
+ for (int bin = numBins; bin < fftSize; ++bin)
+ {
+ acc[(size_t) (2 * bin)] = acc[(size_t) (2 * (fftSize - bin))];
+ acc[(size_t) (2 * bin + 1)] = -acc[(size_t) (2 * (fftSize - bin) + 1)];
+ }
+
+ scratch.fft.performRealOnlyInverseTransform(acc.data());
+
+ auto* output = buffer.getWritePointer(channel);
+ const int start = block * blockSize;
+ const int count = juce::jmin(blockSize, numSamples - start);
+ std::copy(acc.begin() + blockSize, acc.begin() + blockSize + count, output + start);
+ };
+
+ return runInParallel(pool, numChannels * numBlocks, accumulateOutput, isCancelled, reportProgress, 0.2f, 1.0f);
+}
+
+PartitionedConvolver::Stream::Stream(const PartitionedConvolver& convolverToUse, int numChannels)
+ : owner(convolverToUse),
+ states((size_t) juce::jmax(0, numChannels)),
+ fft(convolverToUse.fftOrder),
+ frame((size_t) (2 * convolverToUse.fftSize)),
+ accumulator((size_t) (2 * convolverToUse.fftSize))
+{
+ for (auto& state : states)
+ {
+ state.previousBlock.assign((size_t) owner.blockSize, 0.0f);
+ state.inputSpectra.assign((size_t) (owner.numPartitions * owner.numBins * 2), 0.0f);
+ }
+}
+
+void PartitionedConvolver::Stream::process(float* const* channels, int numChannels, int numSamples)
+{
+ jassert(numChannels <= (int) states.size());
+
+ for (int channel = 0; channel < juce::jmin(numChannels, (int) states.size()); ++channel)
+ {
+ if (! owner.isPrepared())
+ {
+ juce::FloatVectorOperations::clear(channels[channel], numSamples);
+ continue;
+ }
+
+ const auto& irSpectra = owner.partitions[(size_t) juce::jmin(channel, (int) owner.partitions.size() - 1)];
+
+ for (int start = 0; start < numSamples; start += owner.blockSize)
+ processBlock(states[(size_t) channel], irSpectra, channels[channel] + start, juce::jmin(owner.blockSize, numSamples - start));
+ }
+}
+
+void PartitionedConvolver::Stream::processBlock(ChannelState& state, const std::vector<float>& irSpectra, float* data, int count)
+{
+ const int blockSize = owner.blockSize;
+ const int numBins = owner.numBins;
+ const int fftSize = owner.fftSize;
+ const size_t spectrumFloats = (size_t) (numBins * 2);
+
+ // Same overlap-save frame as process(): the previous block, then this one (zero-padded if short)
+ std::fill(frame.begin(), frame.end(), 0.0f);
+ std::copy(state.previousBlock.begin(), state.previousBlock.end(), frame.begin());
+ std::copy(data, data + count, frame.begin() + blockSize);
+
+ std::copy(frame.begin() + blockSize, frame.begin() + 2 * blockSize, state.previousBlock.begin());
+
+ fft.performRealOnlyForwardTransform(frame.data(), true);
+ std::copy(frame.begin(), frame.begin() + (std::ptrdiff_t) spectrumFloats,
+ state.inputSpectra.begin() + (std::ptrdiff_t) ((size_t) state.ringPosition * spectrumFloats));
+
+ // Y = sum over p of X[now - p] * H[p]; slots not written yet are still zero
+ std::fill(accumulator.begin(), accumulator.end(), 0.0f);
+
+ for (int p = 0; p < owner.numPartitions; ++p)
+ {
+ const int slot = (state.ringPosition - p + owner.numPartitions) % owner.numPartitions;
+ const float* x = state.inputSpectra.data() + (size_t) slot * spectrumFloats;
+ const float* h = irSpectra.data() + (size_t) p * spectrumFloats;
+
+ for (int bin = 0; bin < numBins; ++bin)
+ {
+ const float xr = x[2 * bin], xi = x[2 * bin + 1];
+ const float hr = h[2 * bin], hi = h[2 * bin + 1];
+ accumulator[(size_t) (2 * bin)] += xr * hr - xi * hi;
+ accumulator[(size_t) (2 * bin + 1)] += xr * hi + xi * hr;
+ }
+ }
+
+ state.ringPosition = (state.ringPosition + 1) % owner.numPartitions;
+
+ for (int bin = numBins; bin < fftSize; ++bin)
+ {
+ accumulator[(size_t) (2 * bin)] = accumulator[(size_t) (2 * (fftSize - bin))];
+ accumulator[(size_t) (2 * bin + 1)] = -accumulator[(size_t) (2 * (fftSize - bin) + 1)];
+ }
+
+ fft.performRealOnlyInverseTransform(accumulator.data());
+ std::copy(accumulator.begin() + blockSize, accumulator.begin() + blockSize + count, data);
+}
+
+bool PartitionedConvolver::runInParallel(juce::ThreadPool& pool, int numItems,
+ const std::function<void(int, JobScratch&)>& work,
+ const std::function<bool()>& isCancelled,
+ const std::function<void(float)>& reportProgress,
+ float progressStart, float progressEnd)
+{
+ if (numItems <= 0)
+ return true;
+
+ // A few ranges per thread keeps the pool busy when ranges finish unevenly
+ const int numRanges = juce::jmin(numItems, juce::jmax(1, pool.getNumThreads() * 4));
+
+ struct ParallelRun
+ {
+ std::atomic<int> nextRange { 0 }, rangesDone { 0 }, itemsDone { 0 };
+ std::atomic<bool> abort { false };
+ juce::WaitableEvent allDone;
+ };
+
+ auto run = std::make_shared<ParallelRun>();
+
+ // Runs the next unclaimed range; false once every range is claimed. A pool job that only
+ // starts after that touches nothing but run, so this frame may be gone by then.
+ auto runNextRange = [this, run, &work, numItems, numRanges]
+ {
+ const int range = run->nextRange++;
+ if (range >= numRanges)
+ return false;
+
+ const int begin = (int) ((juce::int64) numItems * range / numRanges);
+ const int end = (int) ((juce::int64) numItems * (range + 1) / numRanges);
+ JobScratch scratch(fftOrder, fftSize);
+
+ for (int item = begin; item < end && ! run->abort.load(); ++item)
+ {
+ work(item, scratch);
+ ++run->itemsDone;
+ }
+
+ if (++run->rangesDone == numRanges)
+ run->allDone.signal();
+
+ return true;
+ };
+
+ auto poll = [&]
+ {
+ if (isCancelled != nullptr && ! run->abort.load() && isCancelled())
+ run->abort = true;
+
+ if (reportProgress != nullptr)
+ reportProgress(progressStart + (progressEnd - progressStart) * (float) run->itemsDone.load() / (float) numItems);
+ };
+
+ for (int job = 1; job < numRanges; ++job)
+ pool.addJob([runNextRange] { while (runNextRange()) {} });
+
+ // This thread takes ranges too, so the work finishes even when every pool thread is
+ // busy - with bank slots rendering on the very pool they wait on, for instance
+ while (runNextRange())
+ poll();
+
+ // Ranges other threads claimed still reference this stack frame
+ while (! run->allDone.wait(20))
+ poll();
+
+ return ! run->abort.load() && ! (isCancelled != nullptr && isCancelled());
+}
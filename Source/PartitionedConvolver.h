@@ -0,0 +1,96 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <functional>
+#include <vector>
+
+// Offline, uniformly-partitioned FFT convolution (overlap-save).
+//
+// prepare() cuts the impulse response into equal blocks and transforms each one
+// once. process() then convolves a whole buffer in two passes: every input block
+// is transformed, and every output block is accumulated from those spectra and
+// the IR partitions and transformed back. Blocks are independent within a pass,
+// so both passes are split into ranges of blocks and run on a thread pool.
+//
+// Stream convolves a signal that never fits in memory at once: it keeps the
+// last blockSize input samples and a ring of recent input spectra per channel,
+// so it can be fed consecutive chunks and produces the same output as process().
+class PartitionedConvolver
+{
+public:
+ explicit PartitionedConvolver(int blockSizeToUse = 2048);
+
+ // One IR channel per output channel - a mono IR is used for every channel
+ void prepare(const juce::AudioBuffer<float>& impulseResponse);
+ void reset();
+
+ bool isPrepared() const { return ! partitions.empty(); }
+ int getBlockSize() const { return blockSize; }
+
+ // Convolves every channel of buffer in place, truncated to buffer's length.
+ // Returns false if isCancelled() returned true - buffer is then left untouched or half-processed.
+ bool process(juce::AudioBuffer<float>& buffer,
+ juce::ThreadPool& pool,
+ const std::function<bool()>& isCancelled = nullptr,
+ const std::function<void(float)>& reportProgress = nullptr);
+
+ class Stream
+ {
+ public:
+  // The convolver must stay prepared (and alive) while the stream is used
+  Stream(const PartitionedConvolver& convolverToUse, int numChannels);
+
+  // Convolves the next numSamples of every channel in place. numSamples must be a
+  // multiple of getBlockSize(), except on the last call, which is zero-padded.
+  void process(float* const* channels, int numChannels, int numSamples);
+
+ private:
+  struct ChannelState
+  {
+   std::vector<float> previousBlock;  // Last blockSize input samples
+   std::vector<float> inputSpectra;   // Ring of numPartitions input spectra
+   int ringPosition = 0;
+  };
+
+  void processBlock(ChannelState& state, const std::vector<float>& irSpectra, float* data, int count);
+
+  const PartitionedConvolver& owner;
+  std::vector<ChannelState> states;
+  juce::dsp::FFT fft;
+  std::vector<float> frame, accumulator;
+
+  JUCE_DECLARE_NON_COPYABLE(Stream)
+ };
+
+private:
+ // Per-job FFT and scratch space, so jobs never share mutable state
+ struct JobScratch
+ {
+  explicit JobScratch(int fftOrder, int fftSize)
+   : fft(fftOrder), frame((size_t) (2 * fftSize)), accumulator((size_t) (2 * fftSize)) {}
+
+  juce::dsp::FFT fft;
+  std::vector<float> frame;
+  std::vector<float> accumulator;
+ };
+
+ // Runs work(item, scratch) for every item in [0, numItems) on the pool and on the calling
+ // thread, and waits. Safe to call from a job on the same pool. Polls isCancelled between
+ // ranges and while waiting, and reports progress between progressStart and progressEnd.
+ bool runInParallel(juce::ThreadPool& pool, int numItems,
+ const std::function<void(int, JobScratch&)>& work,
+ const std::function<bool()>& isCancelled,
+ const std::function<void(float)>& reportProgress,
+ float progressStart, float progressEnd);
+
+ const int blockSize;
+ const int fftOrder;
+ const int fftSize;
+ const int numBins; // Non-negative frequency bins kept per spectrum
+
+ // partitions[channel] holds numPartitions spectra of numBins interleaved complex values
+ std::vector<std::vector<float>> partitions;
+ int numPartitions = 0;
+
+ JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PartitionedConvolver)
+};
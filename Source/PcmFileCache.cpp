@@ -0,0 +1,156 @@
+#include "PcmFileCache.h"
+
+namespace
+{
+ // Entry layout: magic, version, channels, samples, sample rate, padded to headerSize, then planar float32
+ constexpr int entryMagic = 0x43505252; // "RRPC"
+ constexpr int entryVersion = 1;
+ constexpr int headerSize = 32;
+}
+
+PcmFileCache::PcmFileCache (const juce::File& cacheDirectory, juce::int64 maxBytesToKeep, const juce::String& nameForLogging)
+ : directory (cacheDirectory),
+   maxBytes (maxBytesToKeep),
+   name (nameForLogging)
+{
+}
+
+juce::File PcmFileCache::getUserCacheRoot()
+{
+#if JUCE_MAC
+ return juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory).getChildFile ("Caches/ReverseReverb");
+#else
+ return juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory).getChildFile ("ReverseReverb/Cache");
+#endif
+}
+
+bool PcmFileCache::find (const juce::String& key, Entry& result)
+{
+ const auto entry = getEntryFile (key);
+ if (key.isEmpty() || ! entry.existsAsFile())
+  return false;
+
+ int numChannels = 0, numSamples = 0;
+ double sampleRate = 0.0;
+ {
+  juce::FileInputStream in (entry);
+  if (in.failedToOpen() || in.readInt() != entryMagic || in.readInt() != entryVersion)
+   return false;
+
+  numChannels = in.readInt();
+  numSamples = in.readInt();
+  sampleRate = in.readDouble();
+ }
+
+ const auto expectedSize = (juce::int64) headerSize + (juce::int64) numChannels * numSamples * (juce::int64) sizeof (float);
+ if (numChannels <= 0 || numChannels > 2 || numSamples <= 0 || sampleRate <= 0.0 || entry.getSize() != expectedSize)
+ {
+  DBG (name << " cache: dropping bad entry " << entry.getFileName());
+  entry.deleteFile();
+  return false;
+ }
+
+ // Read-only: a stray write faults instead of corrupting the cache
+ auto mapping = std::make_unique<juce::MemoryMappedFile> (entry, juce::MemoryMappedFile::readOnly, false);
+ if (mapping->getData() == nullptr || (juce::int64) mapping->getSize() < expectedSize)
+  return false;
+
+ auto* samples = reinterpret_cast<float*> (static_cast<char*> (mapping->getData()) + headerSize);
+
+ result.mapping = std::move (mapping);
+ result.channels[0] = samples;
+ result.channels[1] = samples + (numChannels > 1 ? numSamples : 0);
+ result.numChannels = numChannels;
+ result.numSamples = numSamples;
+ result.sampleRate = sampleRate;
+
+ entry.setLastAccessTime (juce::Time::getCurrentTime()); // Most recently used
+
+ DBG (name << " cache: hit " << entry.getFileName());
+ return true;
+}
+
+bool PcmFileCache::store (const juce::String& key, const juce::AudioBuffer<float>& audio, double sampleRate)
+{
+ if (key.isEmpty() || audio.getNumSamples() == 0 || audio.getNumChannels() == 0 || audio.getNumChannels() > 2
+     || directory.createDirectory().failed())
+  return false;
+
+ const auto entry = getEntryFile (key);
+ juce::TemporaryFile temp (entry);
+
+ {
+  juce::FileOutputStream out (temp.getFile());
+  if (out.failedToOpen())
+   return false;
+
+  out.writeInt (entryMagic);
+  out.writeInt (entryVersion);
+  out.writeInt (audio.getNumChannels());
+  out.writeInt (audio.getNumSamples());
+  out.writeDouble (sampleRate);
+  out.writeRepeatedByte (0, (size_t) (headerSize - out.getPosition()));
+
+  for (int channel = 0; channel < audio.getNumChannels(); ++channel)
+  {
+   if (! out.write (audio.getReadPointer (channel), (size_t) audio.getNumSamples() * sizeof (float)))
+   {
+    DBG (name << " cache: write failed (disk full?)");
+    return false;
+   }
+  }
+
+  out.flush();
+  if (out.getStatus().failed())
+   return false;
+ }
+
+ // Atomic rename, so another instance never maps a half-written entry
+ if (! temp.overwriteTargetFileWithTemporary())
+  return false;
+
+ DBG (name << " cache: stored " << entry.getFileName());
+ evict();
+ return true;
+}
+
+void PcmFileCache::purge() const
+{
+ int numDeleted = 0;
+ for (auto& entry : directory.findChildFiles (juce::File::findFiles, false, "*.pcm"))
+  if (entry.deleteFile())
+   ++numDeleted;
+
+ DBG (name << " cache: purged " << numDeleted << " entries");
+}
+
+void PcmFileCache::evict()
+{
+ auto entries = directory.findChildFiles (juce::File::findFiles, false, "*.pcm");
+
+ juce::int64 totalBytes = 0;
+ for (auto& entry : entries)
+  totalBytes += entry.getSize();
+
+ if (totalBytes <= maxBytes)
+  return;
+
+ // Least recently used first
+ std::sort (entries.begin(), entries.end(), [] (const juce::File& a, const juce::File& b)
+ {
+  return a.getLastAccessTime() < b.getLastAccessTime();
+ });
+
+ for (auto& entry : entries)
+ {
+  if (totalBytes <= maxBytes)
+   break;
+
+  const auto size = entry.getSize();
+  if (entry.deleteFile()) // Fails harmlessly on Windows while another instance has it mapped
+  {
+   totalBytes -= size;
+   DBG (name << " cache: evicted " << entry.getFileName());
+  }
+ }
+}
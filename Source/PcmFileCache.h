@@ -0,0 +1,50 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// A size-capped directory of memory-mappable audio files, the storage behind
+// the decoded-PCM and render caches.
+//
+// Each entry is one file named after its key: a short header, then planar
+// float32 that find() maps read-only. Entries past the size cap are evicted
+// least recently used first (a hit refreshes the entry's access time), and
+// are written to a temp file and renamed, so instances sharing the directory
+// never see half-written files. Not thread-safe - one instance per thread;
+// purge() only deletes files, so it can run from anywhere.
+class PcmFileCache
+{
+public:
+ struct Entry
+ {
+  std::unique_ptr<juce::MemoryMappedFile> mapping;
+  float* channels[2] = {}; // Into the mapping, read-only: the owner must keep the buffer const
+  int numChannels = 0, numSamples = 0;
+  double sampleRate = 0.0;
+ };
+
+ PcmFileCache (const juce::File& cacheDirectory, juce::int64 maxBytesToKeep, const juce::String& nameForLogging);
+
+ // Per-user cache location that every ReverseReverb cache lives under
+ static juce::File getUserCacheRoot();
+
+ const juce::File& getDirectory() const noexcept { return directory; }
+
+ // Maps the entry for this key into result. False on a miss (or a damaged entry, which is dropped).
+ bool find (const juce::String& key, Entry& result);
+
+ // Writes audio (1 or 2 channels) under key, then evicts down to the size cap
+ bool store (const juce::String& key, const juce::AudioBuffer<float>& audio, double sampleRate);
+
+ // Deletes every entry (mapped ones go once their last user lets go, or on the next purge on Windows)
+ void purge() const;
+
+private:
+ juce::File getEntryFile (const juce::String& key) const { return directory.getChildFile (key + ".pcm"); }
+ void evict();
+
+ const juce::File directory;
+ const juce::int64 maxBytes;
+ const juce::String name;
+
+ JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PcmFileCache)
+};
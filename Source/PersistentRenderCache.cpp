@@ -0,0 +1,46 @@
+#include "PersistentRenderCache.h"
+#include "ContentHash.h"
+
+PersistentRenderCache::PersistentRenderCache (const juce::File& cacheDirectory, juce::int64 maxBytesToKeep)
+ : files (cacheDirectory, maxBytesToKeep, "Render")
+{
+}
+
+juce::File PersistentRenderCache::getDefaultDirectory()
+{
+ return PcmFileCache::getUserCacheRoot().getChildFile ("Renders");
+}
+
+juce::String PersistentRenderCache::makeEntryName (const RenderCache::Key& key)
+{
+ // Field by field - the struct's padding bytes are not part of the key
+ ContentHash hash;
+ hash.addValue (renderVersion);
+ hash.addValue (key.sourceHash);
+ hash.addValue (key.impulseHash);
+ hash.addValue (key.reverbSize);
+ hash.addValue (key.reverbMix);
+ hash.addValue (key.tailSeconds);
+ hash.addValue (key.stereoWidth);
+ hash.addValue (key.lowCutFreq);
+ hash.addValue ((int) key.transitionMode);
+ hash.addValue (key.sampleRate);
+ hash.addValue ((int) key.engine);
+ return hash.toString();
+}
+
+RenderedSample::Ptr PersistentRenderCache::find (const RenderCache::Key& key)
+{
+ PcmFileCache::Entry entry;
+ if (! files.find (makeEntryName (key), entry))
+  return nullptr;
+
+ // RenderedSample's buffer is const, so the mapping is never written through
+ return RenderedSample::createMapped (std::move (entry.mapping), entry.channels, entry.numChannels, entry.numSamples);
+}
+
+void PersistentRenderCache::store (const RenderCache::Key& key, const RenderedSample& render)
+{
+ if (! render.isEmpty())
+  files.store (makeEntryName (key), render.getBuffer(), key.sampleRate);
+}
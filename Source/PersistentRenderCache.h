@@ -0,0 +1,41 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "PcmFileCache.h"
+#include "RenderCache.h"
+
+// Finished renders kept on disk across sessions, so a project full of
+// instances opens by mapping its renders back instead of re-rendering them.
+//
+// Entries are keyed by the source's content hash, the render parameters and
+// renderVersion, which must be bumped whenever a change to the render DSP
+// changes its output - older entries then simply stop matching and age out.
+// Hits come back as streamed renders straight over the cache file. Storage,
+// the size cap and LRU eviction are PcmFileCache's. Render worker thread only,
+// except purge().
+class PersistentRenderCache
+{
+public:
+ static constexpr int renderVersion = 1;
+ static constexpr juce::int64 defaultMaxBytes = (juce::int64) 2 << 30; // 2 GB
+
+ explicit PersistentRenderCache (const juce::File& cacheDirectory = getDefaultDirectory(),
+                                 juce::int64 maxBytesToKeep = defaultMaxBytes);
+
+ static juce::File getDefaultDirectory();
+
+ // The cached render, mapped read-only, or nullptr on a miss
+ RenderedSample::Ptr find (const RenderCache::Key& key);
+
+ void store (const RenderCache::Key& key, const RenderedSample& render);
+
+ // Deletes every entry - safe from any thread
+ void purge() const { files.purge(); }
+
+private:
+ static juce::String makeEntryName (const RenderCache::Key& key);
+
+ PcmFileCache files;
+
+ JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PersistentRenderCache)
+};
@@ -1,5 +1,6 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "RenderProfiler.h"
 
 #if __has_include("BinaryData.h")
  #include "BinaryData.h"
@@ -280,7 +281,7 @@ ReverseReverbAudioProcessorEditor::ReverseReverbAudioProcessorEditor (ReverseRev
  // addAndMakeVisible (titleLabel);
  
  // Drop zone label - lighter purple/grey - BIGGER!
- dropLabel.setText ("Drag & Drop Audio (WAV, MP3, AIFF, FLAC - Max 8s)", juce::dontSendNotification);
+ dropLabel.setText ("Drag & Drop Audio (WAV, MP3, AIFF, FLAC - Max 2 min)", juce::dontSendNotification);
  dropLabel.setFont (juce::Font (13.0f)); // Bigger font - was 11
  dropLabel.setJustificationType (juce::Justification::centred);
  dropLabel.setColour (juce::Label::textColourId, juce::Colour (0xffb8b8d0)); // Light purple-grey
@@ -490,6 +491,14 @@ ReverseReverbAudioProcessorEditor::ReverseReverbAudioProcessorEditor (ReverseRev
  addAndMakeVisible (transitionModeLabel);
  
  DBG("Transition mode button added and configured!");
+
+ // Reverb engine selector - opens a menu (Freeverb / Convolution / load IR)
+ engineButton.setColour (juce::TextButton::buttonColourId, juce::Colour (0xffffa500)); // Orange like Low Cut
+ engineButton.setColour (juce::TextButton::textColourOffId, juce::Colours::white);
+ engineButton.setLookAndFeel (modern3DLAF.get());
+ engineButton.addListener (this);
+ addAndMakeVisible (engineButton);
+ updateEngineButtonText();
  
  // About Button - Top-left corner - Light purple pill
  aboutButton.setButtonText("About");
@@ -713,8 +722,15 @@ ReverseReverbAudioProcessorEditor::ReverseReverbAudioProcessorEditor (ReverseRev
  // Add live waveform display
  addAndMakeVisible(*waveformDisplay);
 
+ // Debug CPU meter on top of the waveform
+ cpuLoadOverlay.onReset = [this] { audioProcessor.getCpuLoadMeter().reset(); };
+ addChildComponent(cpuLoadOverlay);
+
  DBG("Live waveform display added!");
  
+ // Failures from before the editor opened were already reported (or nobody was looking)
+ lastSeenLoadFailures = audioProcessor.getLoadFailureCount();
+
  // Start timer for animations AND throttled processing (30ms = 33fps for smooth animations)
  startTimer (30);
  
@@ -741,6 +757,7 @@ ReverseReverbAudioProcessorEditor::~ReverseReverbAudioProcessorEditor()
  lowCutSlider.setLookAndFeel(nullptr);
  playButton.setLookAndFeel(nullptr);
  transitionModeButton.setLookAndFeel(nullptr);
+ engineButton.setLookAndFeel(nullptr);
  aboutButton.setLookAndFeel(nullptr);
  
  // Tremolo controls
@@ -924,6 +941,8 @@ void ReverseReverbAudioProcessorEditor::resized()
  // Live waveform display takes the full top area
  waveformArea = area.removeFromTop(juce::roundToInt(210 * scaleFactor)).reduced(margin);
  waveformDisplay->setBounds(waveformArea);
+ cpuLoadOverlay.setBounds(waveformArea.getRight() - juce::roundToInt(170 * scaleFactor) - margin,
+  waveformArea.getY() + margin, juce::roundToInt(170 * scaleFactor), juce::roundToInt(80 * scaleFactor));
  
  statusLabel.setBounds(area.removeFromTop(juce::roundToInt(16 * scaleFactor)).reduced(margin));
  statusLabel.setFont(juce::Font(11.0f * scaleFactor));
@@ -933,13 +952,15 @@ void ReverseReverbAudioProcessorEditor::resized()
  // ==== MAIN CONTROLS AREA ====
  auto workArea = area.reduced(margin);
 
- // Row 1: Play (half) + Mode (half) side by side - tall pill buttons
+ // Row 1: Play + Mode + Engine side by side - tall pill buttons
  auto btnRow = workArea.removeFromTop(juce::roundToInt(42 * scaleFactor));
- auto btnHalf = (btnRow.getWidth() - spacing) / 2;
- playButton.setBounds(btnRow.removeFromLeft(btnHalf));
+ auto btnThird = (btnRow.getWidth() - 2 * spacing) / 3;
+ playButton.setBounds(btnRow.removeFromLeft(btnThird));
  btnRow.removeFromLeft(spacing);
  transitionModeLabel.setVisible(false);
- transitionModeButton.setBounds(btnRow);
+ transitionModeButton.setBounds(btnRow.removeFromLeft(btnThird));
+ btnRow.removeFromLeft(spacing);
+ engineButton.setBounds(btnRow);
 
  workArea.removeFromTop(spacing);
 
@@ -1174,34 +1195,10 @@ void ReverseReverbAudioProcessorEditor::filesDropped (const juce::StringArray& f
  {
  juce::File audioFile (files[0]);
  
- // Check file duration before loading
- std::unique_ptr<juce::AudioFormatReader> reader(
- audioProcessor.formatManager.createReaderFor(audioFile));
- 
- if (reader != nullptr)
- {
- auto duration = reader->lengthInSamples / reader->sampleRate;
- 
- if (duration > 8.0)
- {
- juce::AlertWindow::showMessageBoxAsync(
- juce::AlertWindow::WarningIcon,
- "File Too Long",
- "Please load a sample shorter than 8 seconds.\n\nThis file is " + 
- juce::String(duration, 1) + " seconds.",
- "OK"
- );
- updateStatus("Error: File too long (" + juce::String(duration, 1) + "s)");
- return;
- }
- }
- 
+ // Decoded in the background - the timer follows the load, then the render
  audioProcessor.loadAudioFile (audioFile);
- updateStatus ("Loaded & Processed: " + audioFile.getFileName());
- // Update waveform display
- updateWaveformWithTremolo();
- waveformNeedsUpdate = true;
- repaint();
+ pendingStatusMessage = "Loaded & Processed: " + audioFile.getFileName();
+ updateStatus ("Loading: " + audioFile.getFileName());
  }
 }
 
@@ -1211,7 +1208,7 @@ void ReverseReverbAudioProcessorEditor::sliderValueChanged (juce::Slider* slider
  {
  audioProcessor.setReverbSize ((float)slider->getValue());
  // Schedule processing for reverb size changes
- if (audioProcessor.isSampleLoaded())
+ if (audioProcessor.hasAnythingToRender())
  {
  processingScheduled = true;
  updateStatus ("Updating...");
@@ -1226,7 +1223,7 @@ void ReverseReverbAudioProcessorEditor::sliderValueChanged (juce::Slider* slider
  else if (slider == &tailDivisionSlider)
  {
  audioProcessor.setTailDivision((int)slider->getValue());
- if (audioProcessor.isSampleLoaded())
+ if (audioProcessor.hasAnythingToRender())
  {
  processingScheduled = true;
  updateStatus("Tail: " + tailDivisionSlider.getTextFromValue(slider->getValue()));
@@ -1235,7 +1232,7 @@ void ReverseReverbAudioProcessorEditor::sliderValueChanged (juce::Slider* slider
  else if (slider == &bpmSlider)
  {
  audioProcessor.setManualBpm((float)slider->getValue());
- if (audioProcessor.isSampleLoaded())
+ if (audioProcessor.hasAnythingToRender())
  {
  processingScheduled = true;
  updateStatus("BPM: " + juce::String((int)slider->getValue()));
@@ -1255,7 +1252,7 @@ void ReverseReverbAudioProcessorEditor::sliderValueChanged (juce::Slider* slider
  stereoWidthLabel.setText ("Stereo Width (Wide)", juce::dontSendNotification);
  
  // Schedule processing for stereo width changes
- if (audioProcessor.isSampleLoaded())
+ if (audioProcessor.hasAnythingToRender())
  {
  processingScheduled = true;
  updateStatus ("Updating...");
@@ -1266,7 +1263,7 @@ void ReverseReverbAudioProcessorEditor::sliderValueChanged (juce::Slider* slider
  audioProcessor.setLowCutFreq ((float)slider->getValue());
  
  // Schedule processing for low cut changes
- if (audioProcessor.isSampleLoaded())
+ if (audioProcessor.hasAnythingToRender())
  {
  processingScheduled = true;
  updateStatus ("Updating...");
@@ -1419,50 +1416,289 @@ void ReverseReverbAudioProcessorEditor::mouseDown (const juce::MouseEvent& event
  }
 }
 
-void ReverseReverbAudioProcessorEditor::openFileBrowser()
+void ReverseReverbAudioProcessorEditor::updateEngineButtonText()
+{
+ if (audioProcessor.getReverbEngine() == ReverbEngine::freeverb)
+ engineButton.setButtonText("FREEVERB");
+ else if (audioProcessor.getImpulseResponseName().isEmpty())
+ engineButton.setButtonText("CONVOLUTION");
+ else
+ engineButton.setButtonText("IR: " + audioProcessor.getImpulseResponseName().toUpperCase());
+}
+
+void ReverseReverbAudioProcessorEditor::showEngineMenu()
+{
+ const bool isConvolution = audioProcessor.getReverbEngine() == ReverbEngine::convolution;
+ const bool hasUserImpulse = audioProcessor.getImpulseResponseName().isNotEmpty();
+
+ juce::PopupMenu menu;
+ menu.addItem(1, "Freeverb", true, !isConvolution);
+ menu.addItem(2, "Convolution (generated tail)", true, isConvolution && !hasUserImpulse);
+ menu.addItem(3, "Convolution (load IR file...)", true, isConvolution && hasUserImpulse);
+ menu.addSeparator();
+ menu.addItem(4, "Clear disk caches");
+ menu.addSeparator();
+ menu.addItem(5, "Load kit folder into bank...");
+ menu.addItem(6, "Clear bank", audioProcessor.getSampleBank().getNumLoadedSlots() > 0);
+
+ // Per loaded slot: follow the main settings or keep its own, and its key range
+ auto& bank = audioProcessor.getSampleBank();
+ juce::PopupMenu slotsMenu;
+
+ for (int slot = 0; slot < SampleBank::maxSlots; ++slot)
+ {
+ if (!bank.isSlotLoaded(slot))
+ continue;
+
+ const int lowNote = bank.getSlotLowNote(slot);
+ const int highNote = bank.getSlotHighNote(slot);
+ const int itemId = bankSlotMenuBase + slot * 4;
+
+ auto keyRange = juce::MidiMessage::getMidiNoteName(lowNote, true, true, 3);
+ if (highNote > lowNote)
+ keyRange << "-" << juce::MidiMessage::getMidiNoteName(highNote, true, true, 3);
+
+ juce::PopupMenu slotMenu;
+ slotMenu.addItem(itemId, "Follow main settings", true, bank.doesSlotFollowMain(slot));
+ slotMenu.addItem(itemId + 1, "Use current settings for this slot only");
+ slotMenu.addSeparator();
+ slotMenu.addItem(itemId + 2, "Play on its own key", true, highNote == lowNote);
+ slotMenu.addItem(itemId + 3, "Play up to the next slot's key", true, highNote > lowNote);
+
+ slotsMenu.addSubMenu(juce::String(slot + 1) + ": " + bank.getSlotFile(slot).getFileNameWithoutExtension() + " (" + keyRange + ")", slotMenu);
+ }
+
+ if (slotsMenu.getNumItems() > 0)
+ menu.addSubMenu("Bank slots", slotsMenu);
+ menu.addSeparator();
+ menu.addItem(7, "Show CPU meter", true, cpuLoadOverlay.isVisible());
+
+ // The profiler is process-wide, so only the standalone app (one instance) drives it
+ if (audioProcessor.wrapperType == juce::AudioProcessor::wrapperType_Standalone)
+ {
+ menu.addItem(8, "Record render trace", true, RenderProfiler::isEnabled());
+ menu.addItem(9, "Save render trace...");
+ }
+
+ menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&engineButton),
+ [this](int result)
+ {
+ if (result == 0)
+ return;
+
+ if (result == 3)
+ {
+ openImpulseResponseBrowser();
+ return;
+ }
+
+ if (result == 4)
+ {
+ audioProcessor.purgeDiskCaches();
+ updateStatus("Disk caches cleared");
+ return;
+ }
+
+ if (result == 5)
+ {
+ openBankFolderBrowser();
+ return;
+ }
+
+ if (result == 6)
+ {
+ audioProcessor.clearBank();
+ updateStatus("Bank cleared");
+ return;
+ }
+
+ if (result == 7)
+ {
+ cpuLoadOverlay.setVisible(!cpuLoadOverlay.isVisible());
+ cpuLoadRefreshCounter = 0;
+ return;
+ }
+
+ if (result == 8)
+ {
+ // Unchanged stages come from the render cache, so only what a change re-renders shows up
+ const bool record = !RenderProfiler::isEnabled();
+ if (record)
+ RenderProfiler::clear();
+
+ RenderProfiler::setEnabled(record);
+ updateStatus(record ? "Recording render trace" : "Render trace stopped");
+ return;
+ }
+
+ if (result == 9)
+ {
+ saveRenderTrace();
+ return;
+ }
+
+ if (result >= bankSlotMenuBase)
+ {
+ handleBankSlotMenu((result - bankSlotMenuBase) / 4, (result - bankSlotMenuBase) % 4);
+ return;
+ }
+
+ audioProcessor.setReverbEngine(result == 1 ? ReverbEngine::freeverb : ReverbEngine::convolution);
+
+ if (result == 2)
+ audioProcessor.clearImpulseResponse();
+
+ updateEngineButtonText();
+
+ if (audioProcessor.hasAnythingToRender())
+ {
+ processingScheduled = true;
+ updateStatus("Updating engine...");
+ }
+ else
+ {
+ updateStatus(result == 1 ? "Freeverb (load sample)" : "Convolution (load sample)");
+ }
+ });
+}
+
+void ReverseReverbAudioProcessorEditor::openImpulseResponseBrowser()
 {
  auto chooser = std::make_shared<juce::FileChooser>(
- "Select an audio file...",
+ "Select an impulse response...",
  juce::File::getSpecialLocation(juce::File::userHomeDirectory),
- "*.wav;*.mp3;*.aiff;*.flac");
+ "*.wav;*.aiff;*.flac");
 
  auto flags = juce::FileBrowserComponent::openMode |
  juce::FileBrowserComponent::canSelectFiles;
 
  chooser->launchAsync(flags, [this, chooser](const juce::FileChooser& fc)
  {
- auto audioFile = fc.getResult();
+ auto irFile = fc.getResult();
 
- if (audioFile == juce::File{})
+ if (irFile == juce::File{})
  return;
 
- // Check file duration before loading
- std::unique_ptr<juce::AudioFormatReader> reader(
- audioProcessor.formatManager.createReaderFor(audioFile));
+ // The processor re-renders once the IR is decoded (a failure shows up like a failed sample load)
+ audioProcessor.setReverbEngine(ReverbEngine::convolution);
+ audioProcessor.loadImpulseResponse(irFile);
+ pendingStatusMessage = "Loaded IR: " + irFile.getFileName();
 
- if (reader != nullptr)
- {
- auto duration = reader->lengthInSamples / reader->sampleRate;
+ if (audioProcessor.hasAnythingToRender())
+ updateStatus("Loading IR: " + irFile.getFileName());
+ else
+ updateStatus("Loading IR: " + irFile.getFileName() + " (load sample)");
+ });
+}
+
+void ReverseReverbAudioProcessorEditor::openBankFolderBrowser()
+{
+ auto chooser = std::make_shared<juce::FileChooser>(
+ "Select a folder of samples...",
+ juce::File::getSpecialLocation(juce::File::userHomeDirectory));
 
- if (duration > 8.0)
+ auto flags = juce::FileBrowserComponent::openMode |
+ juce::FileBrowserComponent::canSelectDirectories;
+
+ chooser->launchAsync(flags, [this, chooser](const juce::FileChooser& fc)
  {
- juce::AlertWindow::showMessageBoxAsync(
- juce::AlertWindow::WarningIcon,
- "File Too Long",
- "Please load a sample shorter than 8 seconds.\n\nThis file is " +
- juce::String(duration, 1) + " seconds.",
- "OK"
- );
- updateStatus("Error: File too long (" + juce::String(duration, 1) + "s)");
+ auto folder = fc.getResult();
+
+ if (folder == juce::File{})
  return;
+
+ const int count = audioProcessor.loadBankFolder(folder);
+
+ if (count == 0)
+ updateStatus("Error: No audio files in " + folder.getFileName());
+ else
+ updateStatus("Bank: " + juce::String(count) + " samples from C1 (rendering...)");
+ });
+}
+
+void ReverseReverbAudioProcessorEditor::handleBankSlotMenu(int slot, int action)
+{
+ auto& bank = audioProcessor.getSampleBank();
+ const auto slotName = "Slot " + juce::String(slot + 1);
+
+ if (action == 0)
+ {
+ // Turning following off keeps the settings the slot has now
+ const bool follow = !bank.doesSlotFollowMain(slot);
+ audioProcessor.setBankSlotFollowsMain(slot, follow);
+ updateStatus(slotName + (follow ? " follows the main settings" : " keeps its settings"));
+ }
+ else if (action == 1)
+ {
+ audioProcessor.setBankSlotOwnSettings(slot);
+ updateStatus(slotName + ": current settings (rendering...)");
+ }
+ else
+ {
+ const int lowNote = bank.getSlotLowNote(slot);
+ int highNote = lowNote;
+
+ if (action == 3)
+ {
+ // Up to the key below the next slot up, or the top of the keyboard
+ highNote = 127;
+ for (int other = 0; other < SampleBank::maxSlots; ++other)
+ if (other != slot && bank.isSlotLoaded(other) && bank.getSlotLowNote(other) > lowNote)
+ highNote = juce::jmin(highNote, bank.getSlotLowNote(other) - 1);
  }
+
+ audioProcessor.setBankSlotKeyRange(slot, lowNote, highNote);
+ updateStatus(slotName + ": " + juce::MidiMessage::getMidiNoteName(lowNote, true, true, 3)
+ + (highNote > lowNote ? "-" + juce::MidiMessage::getMidiNoteName(highNote, true, true, 3) : juce::String()));
  }
+}
+
+void ReverseReverbAudioProcessorEditor::saveRenderTrace()
+{
+ auto chooser = std::make_shared<juce::FileChooser>(
+ "Save render trace...",
+ juce::File::getSpecialLocation(juce::File::userDesktopDirectory).getChildFile("Reverse Reverb Trace.json"),
+ "*.json");
+
+ auto flags = juce::FileBrowserComponent::saveMode |
+ juce::FileBrowserComponent::canSelectFiles |
+ juce::FileBrowserComponent::warnAboutOverwriting;
+
+ chooser->launchAsync(flags, [this, chooser](const juce::FileChooser& fc)
+ {
+ auto traceFile = fc.getResult();
+
+ if (traceFile == juce::File{})
+ return;
+
+ if (RenderProfiler::writeChromeTrace(traceFile))
+ updateStatus("Trace saved: " + traceFile.getFileName());
+ else
+ updateStatus("Error: Can't write " + traceFile.getFileName());
+ });
+}
+
+void ReverseReverbAudioProcessorEditor::openFileBrowser()
+{
+ auto chooser = std::make_shared<juce::FileChooser>(
+ "Select an audio file...",
+ juce::File::getSpecialLocation(juce::File::userHomeDirectory),
+ "*.wav;*.mp3;*.aiff;*.flac");
+
+ auto flags = juce::FileBrowserComponent::openMode |
+ juce::FileBrowserComponent::canSelectFiles;
+
+ chooser->launchAsync(flags, [this, chooser](const juce::FileChooser& fc)
+ {
+ auto audioFile = fc.getResult();
+
+ if (audioFile == juce::File{})
+ return;
 
+ // Decoded in the background - the timer follows the load, then the render
  audioProcessor.loadAudioFile(audioFile);
- updateStatus("Loaded & Processed: " + audioFile.getFileName());
- updateWaveformWithTremolo();
- waveformNeedsUpdate = true;
- repaint();
+ pendingStatusMessage = "Loaded & Processed: " + audioFile.getFileName();
+ updateStatus("Loading: " + audioFile.getFileName());
  });
 }
 
@@ -1574,7 +1810,7 @@ void ReverseReverbAudioProcessorEditor::mouseDoubleClick (const juce::MouseEvent
  {
  reverbSizeSlider.setValue(defaultReverbSize); // Default
  audioProcessor.setReverbSize(defaultReverbSize);
- if (audioProcessor.isSampleLoaded())
+ if (audioProcessor.hasAnythingToRender())
  {
  processingScheduled = true;
  updateStatus("Reset Room Size");
@@ -1597,7 +1833,7 @@ void ReverseReverbAudioProcessorEditor::mouseDoubleClick (const juce::MouseEvent
  {
  tailDivisionSlider.setValue(defaultTailDivision);
  audioProcessor.setTailDivision(defaultTailDivision);
- if (audioProcessor.isSampleLoaded())
+ if (audioProcessor.hasAnythingToRender())
  {
  processingScheduled = true;
  updateStatus("Reset Tail Length");
@@ -1611,7 +1847,7 @@ void ReverseReverbAudioProcessorEditor::mouseDoubleClick (const juce::MouseEvent
  stereoWidthSlider.setValue(defaultStereoWidth);
  audioProcessor.setStereoWidth(defaultStereoWidth);
  stereoWidthLabel.setText("Stereo Width (Normal)", juce::dontSendNotification);
- if (audioProcessor.isSampleLoaded())
+ if (audioProcessor.hasAnythingToRender())
  {
  processingScheduled = true;
  updateStatus("Reset Stereo Width");
@@ -1624,7 +1860,7 @@ void ReverseReverbAudioProcessorEditor::mouseDoubleClick (const juce::MouseEvent
  {
  lowCutSlider.setValue(defaultLowCut);
  audioProcessor.setLowCutFreq(defaultLowCut);
- if (audioProcessor.isSampleLoaded())
+ if (audioProcessor.hasAnythingToRender())
  {
  processingScheduled = true;
  updateStatus("Reset Low Cut");
@@ -1696,7 +1932,7 @@ void ReverseReverbAudioProcessorEditor::buttonClicked (juce::Button* button)
  transitionModeButton.setButtonText("REVERSE ONLY");
  }
  
- if (audioProcessor.isSampleLoaded())
+ if (audioProcessor.hasAnythingToRender())
  {
  processingScheduled = true;
  updateStatus("Updating mode...");
@@ -1713,6 +1949,10 @@ void ReverseReverbAudioProcessorEditor::buttonClicked (juce::Button* button)
  DBG("No sample loaded - mode saved but not processed yet");
  }
  }
+ else if (button == &engineButton)
+ {
+ showEngineMenu();
+ }
  else if (button == &tremoloEnableButton)
  {
  bool isEnabled = tremoloEnableButton.getToggleState();
@@ -1918,8 +2158,19 @@ void ReverseReverbAudioProcessorEditor::timerCallback()
  tremoloDepthSlider.repaint();
  tremoloRateSlider.repaint();
 
- // Update waveform playback position indicator
+ // Update waveform playback position indicator and fade overlay
  waveformDisplay->setPlaybackProgress(audioProcessor.getPlaybackProgress());
+ waveformDisplay->setFadeEnvelope(audioProcessor.getFadeEnvelope());
+
+ // Free renders the audio thread has swapped out (never freed on the audio thread)
+ audioProcessor.releaseRetiredRenders();
+
+ // CPU meter: a snapshot every ~300ms (10 frames @ 30ms) while it's shown
+ if (cpuLoadOverlay.isVisible() && ++cpuLoadRefreshCounter >= 10)
+ {
+ cpuLoadRefreshCounter = 0;
+ cpuLoadOverlay.setStats(audioProcessor.getCpuLoadMeter().getStats());
+ }
 
  // THROTTLED PROCESSING: Only check every ~150ms (5 frames @ 30ms)
  processingThrottleCounter++;
@@ -1927,33 +2178,58 @@ void ReverseReverbAudioProcessorEditor::timerCallback()
  {
  processingThrottleCounter = 0;
  
- // Only process if scheduled and not already processing
- if (processingScheduled && !isCurrentlyProcessing.load())
+ if (processingScheduled)
  {
- DBG("Timer: Processing scheduled! Starting background processing...");
+ DBG("Timer: Processing scheduled! Queuing background render...");
  
  processingScheduled = false;
- isCurrentlyProcessing.store(true);
  
- // Process in background thread
- juce::Thread::launch([this]()
- {
- DBG("Background thread: Calling processReverseReverb()...");
+ // Hand the newest settings to the render worker - it cancels any stale render
  audioProcessor.processReverseReverb();
- DBG("Background thread: processReverseReverb() completed!");
- 
- // Update UI on message thread
- juce::MessageManager::callAsync([this]()
+ }
+ }
+
+ // A user IR (or a restored one) lands in the background - setButtonText ignores an unchanged text
+ updateEngineButtonText();
+
+ // Follow the sample loader: report failed loads (too long, unreadable...)
+ auto loadFailures = audioProcessor.getLoadFailureCount();
+ if (loadFailures != lastSeenLoadFailures)
+ {
+ lastSeenLoadFailures = loadFailures;
+ pendingStatusMessage = "Updated";
+
+ juce::AlertWindow::showMessageBoxAsync(
+ juce::AlertWindow::WarningIcon,
+ "Can't Load File",
+ audioProcessor.getLastLoadError(),
+ "OK"
+ );
+ updateStatus("Error: file not loaded");
+ }
+
+ // Follow the render worker: show progress while rendering, refresh when a render lands
+ auto renderedGeneration = audioProcessor.getRenderedGeneration();
+ if (renderedGeneration != lastSeenRenderGeneration)
  {
- isCurrentlyProcessing.store(false);
+ lastSeenRenderGeneration = renderedGeneration;
  waveformNeedsUpdate = true;
  updateWaveformWithTremolo();
- updateStatus ("Updated");
+ auto renderTime = audioProcessor.wasLastRenderCached() ? juce::String ("cached")
+                                                         : juce::String (audioProcessor.getLastRenderMilliseconds(), 0) + " ms";
+ updateStatus (pendingStatusMessage + " (" + renderTime + ", cache hits "
+               + juce::String (juce::roundToInt (audioProcessor.getRenderCacheHitRate() * 100.0f)) + "%)");
+ pendingStatusMessage = "Updated";
  repaint();
  DBG("UI updated after processing!");
- });
- });
  }
+ else if (audioProcessor.isLoading())
+ {
+ updateStatus ("Loading... " + juce::String (juce::roundToInt (audioProcessor.getLoadProgress() * 100.0f)) + "%");
+ }
+ else if (audioProcessor.isRendering())
+ {
+ updateStatus ("Rendering... " + juce::String (juce::roundToInt (audioProcessor.getRenderProgress() * 100.0f)) + "%");
  }
 }
 
@@ -1961,13 +2237,14 @@ void ReverseReverbAudioProcessorEditor::updateWaveformWithTremolo()
 {
  if (!audioProcessor.isSampleLoaded())
  {
- waveformDisplay->setAudioBuffer(nullptr);
+ waveformDisplay->setSummary({}, {});
  return;
  }
 
- // Generate display buffer with tremolo modulation applied
- audioProcessor.getDisplayBufferWithTremolo(tremoloDisplayBuffer);
- waveformDisplay->setAudioBuffer(&tremoloDisplayBuffer);
+ // Summarise the render with tremolo modulation applied
+ std::vector<float> mins, maxs;
+ audioProcessor.getDisplaySummaryWithTremolo(waveformDisplay->getSummaryWidth(), mins, maxs);
+ waveformDisplay->setSummary(std::move(mins), std::move(maxs));
  waveformDisplay->setGain(audioProcessor.getDryWet());
 }
 
@@ -1996,12 +2273,14 @@ void ReverseReverbAudioProcessorEditor::paintWaveform(juce::Graphics& g)
  return;
  }
  
- // Get the processed buffer
- auto* processedBuffer = audioProcessor.getProcessedBuffer();
+ // Get the processed buffer (hold a reference so a re-render can't free it mid-paint)
+ auto processedSample = audioProcessor.getProcessedSample();
  
- if (processedBuffer == nullptr || processedBuffer->getNumSamples() == 0)
+ if (processedSample == nullptr || processedSample->isEmpty())
  return;
  
+ auto* processedBuffer = &processedSample->getBuffer();
+ 
  auto numSamples = processedBuffer->getNumSamples();
  auto numChannels = processedBuffer->getNumChannels();
  
@@ -241,7 +241,7 @@ public:
 
   g.setColour(juce::Colours::grey.withAlpha(0.35f + 0.25f * textPulse));
   g.setFont(11.0f);
-  g.drawText("Or click here - WAV / MP3 / AIFF / FLAC - Max 8s",
+  g.drawText("Or click here - WAV / MP3 / AIFF / FLAC - Max 2 min",
    bounds, juce::Justification::centredTop);
   return;
  }
@@ -288,6 +288,23 @@ public:
  g.setColour(juce::Colour(0xffff006e).withAlpha(0.6f));
  g.strokePath(waveBottom, juce::PathStrokeType(1.0f));
 
+ // Fade envelope overlay (the same gain tables playback and export use)
+ if (hasFadeCurve && (int)cachedFade.size() == numPoints)
+ {
+  juce::Path fadeCurve;
+  for (int i = 0; i < numPoints; ++i)
+  {
+   float x = area.getX() + (float)i;
+   float y = area.getBottom() - cachedFade[(size_t)i] * height;
+
+   if (i == 0) fadeCurve.startNewSubPath(x, y);
+   else fadeCurve.lineTo(x, y);
+  }
+
+  g.setColour(juce::Colours::white.withAlpha(0.45f));
+  g.strokePath(fadeCurve, juce::PathStrokeType(1.0f));
+ }
+
  // Draw playback position indicator
  if (playbackProgress > 0.0f && playbackProgress < 1.0f)
  {
@@ -297,45 +314,27 @@ public:
  }
  }
 
- // Thread-safe: takes a snapshot of the buffer data into local arrays.
- // Call ONLY from the message thread when the buffer is known to be stable.
- void setAudioBuffer(const juce::AudioBuffer<float>* buffer)
- {
- int width = getWidth() - 12; // match area.reduced(6)
- if (width <= 0 || buffer == nullptr || buffer->getNumSamples() == 0)
- {
-  cachedMin.clear();
-  cachedMax.clear();
-  repaint();
-  return;
- }
+ // Columns a summary should have to fill the display (see WaveformSummary)
+ int getSummaryWidth() const { return getWidth() - 12; } // match area.reduced(6)
 
- auto numSamples = buffer->getNumSamples();
- auto numChannels = buffer->getNumChannels();
- float samplesPerPixel = (float)numSamples / (float)width;
-
- cachedMin.resize((size_t)width);
- cachedMax.resize((size_t)width);
-
- for (int px = 0; px < width; ++px)
+ // Message thread: takes over a summary built for getSummaryWidth() (empty vectors for none)
+ void setSummary(std::vector<float>&& mins, std::vector<float>&& maxs)
  {
-  int sampleStart = (int)(px * samplesPerPixel);
-  int sampleEnd = juce::jmin((int)((px + 1) * samplesPerPixel), numSamples);
+ cachedMin = std::move(mins);
+ cachedMax = std::move(maxs);
 
-  float minVal = 0.0f, maxVal = 0.0f;
-  for (int s = sampleStart; s < sampleEnd; ++s)
-  {
-   float v = 0.0f;
-   for (int ch = 0; ch < numChannels; ++ch)
-    v += buffer->getSample(ch, s);
-   v /= numChannels;
-   minVal = juce::jmin(minVal, v);
-   maxVal = juce::jmax(maxVal, v);
-  }
-  cachedMin[(size_t)px] = minVal;
-  cachedMax[(size_t)px] = maxVal;
+ updateFadeCurve();
+ repaint();
  }
 
+ // Message thread: follow the processor's fade envelope (cheap when unchanged)
+ void setFadeEnvelope(FadeEnvelope::Ptr envelope)
+ {
+ if (envelope == fadeEnvelope)
+  return;
+
+ fadeEnvelope = envelope;
+ updateFadeCurve();
  repaint();
  }
 
@@ -361,9 +360,31 @@ public:
  }
 
 private:
+ // One fade gain per pixel column, sampled from the envelope
+ void updateFadeCurve()
+ {
+ hasFadeCurve = false;
+ cachedFade.assign(cachedMax.size(), 1.0f);
+
+ if (fadeEnvelope == nullptr || fadeEnvelope->getNumSamples() == 0 || cachedFade.empty())
+  return;
+
+ const auto length = (juce::int64)fadeEnvelope->getNumSamples();
+ const auto numPoints = (juce::int64)cachedFade.size();
+
+ for (juce::int64 px = 0; px < numPoints; ++px)
+ {
+  cachedFade[(size_t)px] = fadeEnvelope->getGain((int)(px * length / numPoints));
+  hasFadeCurve = hasFadeCurve || cachedFade[(size_t)px] < 1.0f;
+ }
+ }
+
  // Thread-safe cached waveform data (owned by this component, no shared pointers)
  std::vector<float> cachedMin;
  std::vector<float> cachedMax;
+ std::vector<float> cachedFade;
+ FadeEnvelope::Ptr fadeEnvelope;
+ bool hasFadeCurve = false;
  float cachedGain = 1.0f;
  float playbackProgress = 0.0f;
  bool isDragOver = false;
@@ -638,6 +659,59 @@ private:
  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DragVisualizer)
 };
 
+// CpuLoadOverlay - debug readout of the audio thread's load per block (see CpuLoadMeter).
+// Shown from the engine menu; a click resets the statistics.
+class CpuLoadOverlay : public juce::Component
+{
+public:
+ std::function<void()> onReset;
+
+ void setStats(const CpuLoadMeter::Stats& newStats)
+ {
+ stats = newStats;
+ repaint();
+ }
+
+ void paint(juce::Graphics& g) override
+ {
+ auto bounds = getLocalBounds().toFloat();
+ g.setColour(juce::Colours::black.withAlpha(0.8f));
+ g.fillRoundedRectangle(bounds, 4.0f);
+
+ // Hot pink once any block has overrun its budget
+ g.setColour(stats.numOverruns > 0 ? juce::Colour(0xffff006e) : juce::Colour(0xffb537f2).withAlpha(0.6f));
+ g.drawRoundedRectangle(bounds.reduced(0.5f), 4.0f, 1.0f);
+
+ auto percent = [](double load) { return juce::String(load * 100.0, 1) + "%"; };
+ const juce::String lines[] = {
+  "CPU / block budget",
+  "avg " + percent(stats.averageLoad) + "  p99 " + percent(stats.p99Load),
+  "min " + percent(stats.minLoad) + "  max " + percent(stats.maxLoad),
+  "overruns " + juce::String(stats.numOverruns) + " of " + juce::String(stats.numBlocks),
+  juce::String(stats.samplesPerSecond / 1.0e6, 2) + " M samples/s"
+ };
+
+ auto area = getLocalBounds().reduced(6, 4);
+ const int lineHeight = area.getHeight() / (int) std::size(lines);
+ g.setFont(juce::Font(juce::Font::getDefaultMonospacedFontName(), (float) lineHeight * 0.8f, juce::Font::plain));
+ g.setColour(juce::Colours::white.withAlpha(0.85f));
+
+ for (auto& line : lines)
+  g.drawText(line, area.removeFromTop(lineHeight), juce::Justification::centredLeft, false);
+ }
+
+ void mouseDown(const juce::MouseEvent&) override
+ {
+ if (onReset != nullptr)
+  onReset();
+ }
+
+private:
+ CpuLoadMeter::Stats stats;
+
+ JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CpuLoadOverlay)
+};
+
 // Glowing Knob LookAndFeel - legacy compatibility
 class GlowingKnobLookAndFeel : public juce::LookAndFeel_V4
 {
@@ -745,6 +819,9 @@ private:
  
  juce::TextButton transitionModeButton;
  juce::Label transitionModeLabel;
+
+ // Reverb engine selector (Freeverb / convolution with generated or user IR)
+ juce::TextButton engineButton;
  
  // About button
  juce::TextButton aboutButton;
@@ -765,10 +842,16 @@ private:
  juce::Path cachedWaveformPath;
  bool waveformNeedsUpdate = true;
  
- // Throttled processing
+ // CPU meter overlay over the waveform (hidden until enabled from the engine menu)
+ CpuLoadOverlay cpuLoadOverlay;
+ int cpuLoadRefreshCounter = 0;
+
+ // Throttled processing (renders themselves run on the processor's render worker)
  bool processingScheduled = false;
- std::atomic<bool> isCurrentlyProcessing { false };
  int processingThrottleCounter = 0;
+ juce::uint32 lastSeenRenderGeneration = 0;
+ juce::uint32 lastSeenLoadFailures = 0;
+ juce::String pendingStatusMessage { "Updated" }; // Shown when the next render lands
  
  // Shared animation phase for synchronized animations
  float animationPhase = 0.0f;
@@ -820,13 +903,17 @@ private:
  
  void paintWaveform(juce::Graphics& g);
  void openFileBrowser();
+ void showEngineMenu();
+ void openImpulseResponseBrowser();
+ void openBankFolderBrowser(); // Kit folder -> one bank slot per file, from C1 up
+ void saveRenderTrace(); // Standalone only: the render profiler's events as a Chrome trace
+ void handleBankSlotMenu(int slot, int action); // One of the engine menu's per-slot items (see showEngineMenu)
+ static constexpr int bankSlotMenuBase = 100; // Engine menu ids from here on: 4 per bank slot
+ void updateEngineButtonText();
  void performDragToDAW();
  void drawCircuitBoardPattern(juce::Graphics& g, juce::Rectangle<int> area);
  void updateWaveformWithTremolo(); // Update waveform display with tremolo preview
 
- // Buffer for tremolo-modulated waveform display
- juce::AudioBuffer<float> tremoloDisplayBuffer;
-
  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ReverseReverbAudioProcessorEditor)
 };
 
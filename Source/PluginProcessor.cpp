@@ -1,5 +1,7 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "WaveformSummary.h"
+#include <algorithm>
 #include <cmath>
 
 ReverseReverbAudioProcessor::ReverseReverbAudioProcessor()
@@ -16,20 +18,15 @@ ReverseReverbAudioProcessor::ReverseReverbAudioProcessor()
 {
  // Register audio formats (WAV, AIFF, MP3, FLAC, etc.)
  formatManager.registerBasicFormats();
- 
- // Setup reverb parameters
- reverbParams.roomSize = reverbSize;
- reverbParams.damping = 0.5f;
- reverbParams.wetLevel = reverbMix;
- reverbParams.dryLevel = 0.0f;
- reverbParams.width = 1.0f;
- reverbParams.freezeMode = 0.0f;
- 
- reverb.setParameters(reverbParams);
+
+ readAheadThread.addTimeSliceClient(&renderPrefetcher);
+ readAheadThread.startThread();
 }
 
 ReverseReverbAudioProcessor::~ReverseReverbAudioProcessor()
 {
+ readAheadThread.removeTimeSliceClient(&renderPrefetcher);
+ readAheadThread.stopThread(1000);
 }
 
 const juce::String ReverseReverbAudioProcessor::getName() const
@@ -94,21 +91,9 @@ void ReverseReverbAudioProcessor::changeProgramName (int index, const juce::Stri
 
 void ReverseReverbAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
+ const bool sampleRateChanged = sampleRate != currentSampleRate;
  currentSampleRate = sampleRate;
 
- // Reset reverb completely
- reverb.reset();
- reverb.setSampleRate(sampleRate);
-
- // Set initial reverb parameters
- reverbParams.roomSize = reverbSize;
- reverbParams.damping = 0.5f;
- reverbParams.wetLevel = reverbMix;
- reverbParams.dryLevel = 0.0f;
- reverbParams.width = 1.0f;
- reverbParams.freezeMode = 0.0f;
- reverb.setParameters(reverbParams);
-
  // Initialize delay buffers for stereo width effect (max 2000 samples delay)
  int maxDelaySamples = 2000;
  delayBufferLeft.setSize(1, maxDelaySamples, false, true, false);
@@ -117,15 +102,22 @@ void ReverseReverbAudioProcessor::prepareToPlay (double sampleRate, int samplesP
  delayBufferRight.clear();
  delayWritePosition = 0;
 
- // Reset filter state
- lowCutPrevInputL = 0.0f;
- lowCutPrevInputR = 0.0f;
- lowCutPrevOutputL = 0.0f;
- lowCutPrevOutputR = 0.0f;
+ // Reset voices (and their tremolo state), 5ms declick fade on release
+ voices.stopAll();
+ voices.setReleaseSamples((int)(0.005 * sampleRate));
+
+ // Block budgets follow the new rate; the load statistics start over
+ cpuLoad.prepare(sampleRate);
+
+ // Streamed renders: keep 2 seconds ahead of every voice resident
+ renderPrefetcher.setReadAheadSamples((int)(2.0 * sampleRate));
 
- // Reset tremolo state
- tremoloPhase = 0.0f;
- tremoloSampleCounter = 0;
+ // The current renders are at the old rate: redo them (resampling the sources) in the background
+ if (sampleRateChanged)
+ {
+ processReverseReverb();
+ sampleBank.setSampleRate(sampleRate);
+ }
 }
 
 void ReverseReverbAudioProcessor::releaseResources()
@@ -156,6 +148,7 @@ bool ReverseReverbAudioProcessor::isBusesLayoutSupported (const BusesLayout& lay
 void ReverseReverbAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
  juce::ScopedNoDenormals noDenormals;
+ const CpuLoadMeter::ScopedMeasurement cpuMeasurement(cpuLoad, buffer.getNumSamples()); // Times the whole block
  auto totalNumInputChannels = getTotalNumInputChannels();
  auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -167,819 +160,396 @@ void ReverseReverbAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer
  for (int i = 0; i < totalNumOutputChannels; ++i)
  buffer.clear(i, 0, buffer.getNumSamples());
 
- // Check for MIDI note triggers
- for (const auto metadata : midiMessages)
- {
- auto message = metadata.getMessage();
- if (message.isNoteOn())
+ // Pick up the newest finished render and fade tables (lock-free, never blocks on the renderer)
+ auto* render = renderHandoff.acquire();
+ auto* fades = fadeHandoff.acquire();
+
+ if (render != playbackSample)
  {
- triggerSample();
+ retargetVoices(-1, playbackSample, render);
+ playbackSample = render;
  }
- else if (message.isNoteOff())
+
+ // Bank slots publish independently - each one is picked up the same way
+ int bankNumChannels = 0;
+ for (int slot = 0; slot < SampleBank::maxSlots; ++slot)
  {
- isPlaying = false;
+ auto* slotRender = sampleBank.acquire(slot);
+ auto& slotPlayback = bankPlaybackSamples[(size_t) slot];
+
+ if (slotRender != slotPlayback)
+ {
+ retargetVoices(slot, slotPlayback, slotRender);
+ slotPlayback = slotRender;
  }
+
+ if (slotRender != nullptr)
+ bankNumChannels = juce::jmax(bankNumChannels, slotRender->getNumChannels());
  }
 
- // Playback processed sample if triggered
- // Capture atomic state once per block for consistency (avoid reading mid-change)
- bool currentlyPlaying = isPlaying.load();
- int processedNumSamples = processedSample.getNumSamples();
- int processedNumChannels = processedSample.getNumChannels();
+ // A new main sample only stops the main sample's voices
+ if (stopRequested.exchange(false))
+ voices.stopSlot(-1);
+
+ if (triggerRequested.exchange(false))
+ startPlayback(-1, 1.0f);
 
- if (currentlyPlaying && processedNumSamples > 0 && processedNumChannels > 0)
+ // Playback parameters, tremolo and host transport, read once for the whole block
+ blockPlayback.tremoloEnabled = tremoloEnabled;
+ blockPlayback.releaseSamples = voices.getReleaseSamples();
+
+ if (tremoloEnabled)
  {
- auto numChannels = juce::jmin(buffer.getNumChannels(), processedNumChannels);
- auto numSamples = buffer.getNumSamples();
- auto totalSamples = processedNumSamples;
- 
- for (int i = 0; i < numSamples; ++i)
+ auto& tremolo = blockPlayback.tremolo;
+ tremolo.depth = tremoloDepth;
+ tremolo.rate = tremoloRate;
+ tremolo.waveform = tremoloWaveform;
+ tremolo.syncEnabled = tremoloSyncEnabled;
+ tremolo.syncDivision = tremoloSyncDivision;
+ tremolo.rateRampEnabled = tremoloRateRampEnabled;
+ tremolo.startDivision = tremoloStartDivision;
+ tremolo.endDivision = tremoloEndDivision;
+ tremolo.sampleRate = currentSampleRate;
+
+ if (tremoloSyncEnabled || tremoloRateRampEnabled)
+ blockPlayback.transport = TransportSnapshot::read(getPlayHead());
+ }
+
+ // Playback processed sample: every active voice adds into the (cleared) output
+ int processedNumSamples = render != nullptr ? render->getNumSamples() : 0;
+ int processedNumChannels = render != nullptr ? render->getNumChannels() : 0;
+ const bool hasRender = processedNumSamples > 0 && processedNumChannels > 0;
+
+ if (! hasRender)
+ voices.stopSlot(-1);
+
+ // Sample-accurate MIDI: render up to each event, then apply it, so a note-on
+ // starts exactly at its timestamp whatever the host buffer size
+ const int blockSamples = buffer.getNumSamples();
+ int renderedUpTo = 0;
+
+ auto renderVoicesUpTo = [&](int endSample)
  {
- // : 
- if (currentPlaybackPosition >= 0 && currentPlaybackPosition < totalSamples && isPlaying.load())
+ if (endSample > renderedUpTo)
+ for (auto& voice : voices)
+ if (voice.active)
+ if (auto* voiceRender = getVoiceRender(voice); voiceRender != nullptr && ! voiceRender->isEmpty())
+ VoicePlayback::render(voice, *voiceRender, voice.slot < 0 ? fades : nullptr, blockPlayback, buffer, renderedUpTo, endSample - renderedUpTo);
+
+ renderedUpTo = juce::jmax(renderedUpTo, endSample);
+ };
+
+ // Check for MIDI note triggers - each note-on gets its own voice, note-offs only release their note
+ for (const auto metadata : midiMessages)
  {
- // Calculate fade gain for this position
- float fadeGain = 1.0f;
- float samplePosition = (float)currentPlaybackPosition / totalSamples;
- 
- // Apply fade in with cubic curve for sharper fade
- if (fadeIn > 0.0f && samplePosition < fadeIn)
+ renderVoicesUpTo(juce::jlimit(0, blockSamples, metadata.samplePosition));
+
+ auto message = metadata.getMessage();
+ if (message.isNoteOn())
  {
- float fadePos = samplePosition / fadeIn;
- fadeGain *= fadePos * fadePos * fadePos; // Cubic curve
+ startPlayback(message.getNoteNumber(), message.getFloatVelocity());
  }
- 
- // Apply fade out with cubic curve for sharper fade
- if (fadeOut > 0.0f && samplePosition > (1.0f - fadeOut))
+ else if (message.isNoteOff())
  {
- float fadeOutPos = (1.0f - samplePosition) / fadeOut;
- fadeGain *= fadeOutPos * fadeOutPos * fadeOutPos; // Cubic curve
+ voices.noteOff(message.getNoteNumber());
  }
- 
- for (int channel = 0; channel < numChannels; ++channel)
+ else if (message.isAllNotesOff() || message.isAllSoundOff())
  {
- auto* outputData = buffer.getWritePointer(channel);
- auto* sampleData = processedSample.getReadPointer(channel);
- 
- float sample = sampleData[currentPlaybackPosition];
- 
- // Remove denormals more aggressively
- if (std::abs(sample) < 1e-10f)
- sample = 0.0f;
- 
- // Apply fade and output gain
- float outputSample = sample * fadeGain * dryWet;
- if (outputSample > 0.99f)
- outputSample = 0.99f;
- else if (outputSample < -0.99f)
- outputSample = -0.99f;
- 
- outputData[i] = outputSample;
+ for (auto& voice : voices)
+ voices.release(voice);
  }
- 
- currentPlaybackPosition++;
  }
- else
+
+ renderVoicesUpTo(blockSamples);
+
+ if (hasRender || bankNumChannels > 0)
  {
- isPlaying = false;
- 
- // Reset tremolo sample counter when playback stops
- tremoloSampleCounter = 0;
- 
+ // Apply output gain, then clip the mix
+ auto numChannels = juce::jmin(buffer.getNumChannels(), juce::jmax(processedNumChannels, bankNumChannels));
  for (int channel = 0; channel < numChannels; ++channel)
  {
- buffer.getWritePointer(channel)[i] = 0.0f;
- }
- }
+ auto* outputData = buffer.getWritePointer(channel);
+ juce::FloatVectorOperations::multiply(outputData, dryWet, blockSamples);
+ juce::FloatVectorOperations::clip(outputData, outputData, -0.99f, 0.99f, blockSamples);
  }
- 
- // Apply Tremolo at the end of the signal chain (if enabled)
- if (tremoloEnabled && isPlaying.load())
- {
- // Debug at start of tremolo application
- static bool firstTime = true;
- if (firstTime && tremoloRateRampEnabled && tremoloSyncEnabled)
- {
- DBG(" TREMOLO LOOP STARTED with Rate Ramp!");
- DBG(" Num samples in buffer: " << numSamples);
- DBG(" Initial counter: " << tremoloSampleCounter);
- firstTime = false;
  }
- 
- // : 
- int samplesToProcess = numSamples; // Process all samples in the buffer
 
- for (int i = 0; i < samplesToProcess; ++i)
- {
- // Safety: skip if playback stopped mid-block
- if (!isPlaying.load())
- break;
- 
- float tremoloGain = calculateTremoloLFO();
- 
- for (int channel = 0; channel < numChannels; ++channel)
- {
- auto* channelData = buffer.getWritePointer(channel);
- channelData[i] *= tremoloGain;
- }
- 
- // Increment sample counter for Rate Ramp tracking AFTER applying tremolo
- // Works with or without sync enabled
- if (tremoloRateRampEnabled)
+ isPlaying = voices.isAnyVoiceActive();
+
+ // Tell the read-ahead thread where every voice is
+ int voiceIndex = 0;
+ for (auto& voice : voices)
+ renderPrefetcher.setVoicePosition(voiceIndex++, voice.slot, voice.active ? voice.position : -1);
+
+ // Publish progress for the editor's playhead (it follows the newest voice of the main sample)
+ auto* newestVoice = voices.getNewestVoice(-1);
+ playbackProgress = (newestVoice != nullptr && processedNumSamples > 0) ? (float)newestVoice->position / (float)processedNumSamples : 0.0f;
+}
+
+void ReverseReverbAudioProcessor::retargetVoices(int slot, const RenderedSample* oldRender, const RenderedSample* newRender)
+{
+ // A re-render landed mid-playback: keep every voice playing, scaled to the new length
+ int oldLength = oldRender != nullptr ? oldRender->getNumSamples() : 0;
+ int newLength = newRender != nullptr ? newRender->getNumSamples() : 0;
+
+ for (auto& voice : voices)
  {
- tremoloSampleCounter++;
+ if (voice.slot != slot)
+ continue;
 
- // Reset counter when we reach the end of the sample (prevent overflow)
- int sampleLength = isSampleLoaded() ? processedSample.getNumSamples() : 0;
- if (sampleLength > 0 && tremoloSampleCounter >= sampleLength)
+ if (oldLength > 0 && newLength > 0 && voice.position > 0)
  {
- DBG(" Counter reached end! Resetting from " << tremoloSampleCounter << " to 0");
- tremoloSampleCounter = 0;
+ float progress = (float)voice.position / (float)oldLength;
+ voice.position = juce::jlimit(0, newLength - 1, (int)(progress * newLength));
+ voice.tremolo.sampleCounter = voice.position;
  }
- else if (sampleLength <= 0)
+ else
  {
- tremoloSampleCounter = 0; // Safety reset
- }
- }
+ voice.position = 0;
+ voice.tremolo.sampleCounter = 0;
  }
  }
- else if (!isPlaying)
+
+ if (newLength == 0)
+ voices.stopSlot(slot);
+}
+
+FadeEnvelope::Ptr ReverseReverbAudioProcessor::refreshFadeEnvelope(int renderLength)
+{
+ if (renderLength < 0)
  {
- // Reset flag when playback stops
- static bool firstTime_reset = true;
- firstTime_reset = true;
- }
+ auto rendered = renderHandoff.getLatest();
+ renderLength = rendered != nullptr ? rendered->getNumSamples() : 0;
  }
 
+ const juce::ScopedLock sl(fadeEnvelopeLock);
+
+ auto current = fadeHandoff.getLatest();
+ if (current != nullptr && current->matches(renderLength, fadeIn, fadeOut))
+ return current;
+
+ FadeEnvelope::Ptr envelope = new FadeEnvelope(renderLength, fadeIn, fadeOut);
+ fadeHandoff.publish(envelope);
+ return envelope;
 }
 
 void ReverseReverbAudioProcessor::loadAudioFile(const juce::File& file)
 {
- if (!file.existsAsFile())
- return;
- 
- std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
- 
- if (reader == nullptr)
- return;
+ // Decoding (MP3 and FLAC included) happens on the loader thread - a newer file cancels this one
+ sampleLoader.requestLoad(file);
+}
 
- // Validate sample rate to prevent division by zero
- if (reader->sampleRate <= 0.0)
+int ReverseReverbAudioProcessor::loadBankFolder(const juce::File& folder, int firstNote)
+{
+ auto files = folder.findChildFiles(juce::File::findFiles, false, formatManager.getWildcardForAllFormats());
+
+ // Natural order, so "Kick 2" comes before "Kick 10"
+ std::sort(files.begin(), files.end(), [](const juce::File& a, const juce::File& b)
  {
- DBG("Invalid sample rate: " << reader->sampleRate);
- return;
- }
+ return a.getFileName().compareNatural(b.getFileName()) < 0;
+ });
+
+ sampleBank.clearAll();
+
+ // Every slot follows the current settings; the slots decode and render in parallel
+ const auto settings = getRenderSettings();
+ const int count = juce::jmin(files.size(), SampleBank::maxSlots, 128 - firstNote);
+
+ for (int i = 0; i < count; ++i)
+ sampleBank.loadSlot(i, files.getReference(i), firstNote + i, firstNote + i, settings, true);
 
- auto duration = reader->lengthInSamples / reader->sampleRate;
+ DBG("Sample bank: " << count << " samples from " << folder.getFileName());
+ return juce::jmax(0, count);
+}
 
- // Limit to 8 seconds as requested
- if (duration > 8.0 || duration <= 0.0)
+void ReverseReverbAudioProcessor::publishSource(SourceSample::Ptr source, const juce::File& file)
+{
+ // The current sample keeps playing (and exporting under its own name) until this one's render lands
  {
- DBG("File too long or invalid: " << duration << " seconds");
- return;
+ const juce::SpinLock::ScopedLockType sl(sourceLock);
+ requestedSample = source;
+ requestedFile = file;
  }
- 
- // Save the original file name (without extension) for export naming
- loadedFileName = file.getFileNameWithoutExtension();
- DBG(" Loaded file name: " + loadedFileName);
- 
- // Stop playback before loading new sample
- isPlaying = false;
- currentPlaybackPosition = 0;
- 
- // Reset tremolo sample counter
- tremoloSampleCounter = 0;
- 
- // Load the sample
- auto numChannels = juce::jmin((int)reader->numChannels, 2); // Max stereo
- auto numSamples = (int)reader->lengthInSamples;
- 
- if (numSamples <= 0 || numChannels <= 0)
- return;
- 
- originalSample.setSize(numChannels, numSamples, false, true, false);
- 
- if (!reader->read(&originalSample, 0, numSamples, 0, true, true))
- {
- DBG("Failed to read audio file");
- originalSample.setSize(0, 0);
- loadedFileName = ""; // Clear file name on failure
- return;
- }
- 
- // Automatically process when loaded
+
+ DBG(" Loaded file name: " + file.getFileNameWithoutExtension());
+
+ // Automatically process when loaded (rendered on the worker thread)
  processReverseReverb();
 }
 
-void ReverseReverbAudioProcessor::processReverseReverb()
+juce::String ReverseReverbAudioProcessor::getLoadedFileName() const
 {
- if (originalSample.getNumSamples() == 0 || originalSample.getNumChannels() == 0)
- return;
+ const juce::SpinLock::ScopedLockType sl(sourceLock);
+ return loadedFile.getFileNameWithoutExtension();
+}
 
- // Save playback state so we can resume after reprocessing
- bool wasPlaying = isPlaying.load();
- int savedPlaybackPos = currentPlaybackPosition;
- int oldSampleLength = processedSample.getNumSamples();
+RenderSettings ReverseReverbAudioProcessor::getRenderSettings() const
+{
+ RenderSettings settings;
+ settings.reverbSize = reverbSize;
+ settings.reverbMix = reverbMix;
+ settings.tailSeconds = getTailDurationSeconds();
+ settings.stereoWidth = stereoWidth;
+ settings.lowCutFreq = lowCutFreq;
+ settings.transitionMode = transitionMode;
+ settings.sampleRate = currentSampleRate;
+ settings.engine = reverbEngine;
+ settings.scratchDirectory = getScratchDirectory();
+ settings.outOfCoreSeconds = streamingThresholdSeconds;
 
- // Stop playback during processing - MUST happen before any buffer operations
- isPlaying = false;
- currentPlaybackPosition = 0;
+ {
+ const juce::SpinLock::ScopedLockType sl(sourceLock);
+ settings.impulseResponse = impulseResponse;
+ settings.impulseResponseFile = impulseResponseFile;
+ }
 
- // Reset tremolo sample counter
- tremoloSampleCounter = 0;
+ return settings;
+}
 
- // Small delay to ensure audio thread has completed current block
- // This prevents race condition where processBlock reads buffers mid-resize
- juce::Thread::sleep(10);
+void ReverseReverbAudioProcessor::loadImpulseResponse(const juce::File& file)
+{
+ // Decoded on the loader thread like a sample (failures show up in getLoadFailureCount())
+ sampleLoader.requestLoad(file, SampleLoader::Target::impulseResponse);
+}
 
- try
- {
- // Step 1: Create a copy and normalize input to prevent clipping
- reverbBuffer.makeCopyOf(originalSample);
- 
- if (reverbBuffer.getNumSamples() == 0)
- return;
- 
- // OPTIMIZATION: Use getMagnitude() for faster peak finding
- float maxLevel = 0.0f;
- for (int channel = 0; channel < reverbBuffer.getNumChannels(); ++channel)
- {
- maxLevel = juce::jmax(maxLevel, reverbBuffer.getMagnitude(channel, 0, reverbBuffer.getNumSamples()));
- }
- 
- // Scale down to 50% to prevent reverb clipping
- if (maxLevel > 0.001f)
+void ReverseReverbAudioProcessor::publishImpulseResponse(SourceSample::Ptr impulse, const juce::File& file)
+{
  {
- float scaleFactor = 0.5f / maxLevel;
- reverbBuffer.applyGain(scaleFactor); // Apply to all channels at once
+ const juce::SpinLock::ScopedLockType sl(sourceLock);
+ impulseResponse = impulse;
+ impulseResponseFile = file;
  }
- 
- // Step 2: Reset and configure reverb with beat-synced tail length
- reverb.reset();
- reverb.setSampleRate(currentSampleRate);
- 
- // Calculate tail duration from BPM + division
- float tailDuration = getTailDurationSeconds();
- float normalizedFeedback = juce::jlimit(0.0f, 1.0f, tailDuration / 10.0f);
 
- // Adjust room size based on tail duration - longer tail = larger room
- float adjustedRoomSize = juce::jlimit(0.0f, 1.0f, reverbSize + (normalizedFeedback * 0.3f));
+ DBG("Loaded impulse response: " << file.getFileName());
 
- reverbParams.roomSize = adjustedRoomSize;
- reverbParams.damping = juce::jlimit(0.1f, 0.9f, 0.5f - (normalizedFeedback * 0.3f));
- reverbParams.wetLevel = juce::jlimit(0.0f, 1.0f, reverbMix) * 0.7f;
- reverbParams.dryLevel = 0.0f;
+ if (reverbEngine == ReverbEngine::convolution)
+ processReverseReverb();
+}
 
- // Adjust stereo width in reverb parameters
- reverbParams.width = stereoWidth;
- reverbParams.freezeMode = 0.0f;
- reverb.setParameters(reverbParams);
+void ReverseReverbAudioProcessor::clearImpulseResponse()
+{
+ sampleLoader.cancel(SampleLoader::Target::impulseResponse); // An IR still decoding would land after this
 
- DBG("Processing with tail duration: " << tailDuration << "s (BPM: " << getEffectiveBpm() << ")");
- DBG("Adjusted room size: " << adjustedRoomSize);
- DBG("Damping: " << reverbParams.damping);
- DBG("Stereo width: " << stereoWidth);
+ const juce::SpinLock::ScopedLockType sl(sourceLock);
+ impulseResponse = nullptr;
+ impulseResponseFile = juce::File();
+}
 
- // Step 3: Add silence at the end based on tail duration to let reverb tail ring out
- int extraSamples = (int)(tailDuration * currentSampleRate);
+juce::String ReverseReverbAudioProcessor::getImpulseResponseName() const
+{
+ const juce::SpinLock::ScopedLockType sl(sourceLock);
+ return impulseResponse != nullptr ? impulseResponseFile.getFileNameWithoutExtension() : juce::String();
+}
+
+void ReverseReverbAudioProcessor::processReverseReverb()
+{
+ const auto settings = getRenderSettings();
+
+ // Slots following the main settings re-render with them, main sample or not
+ sampleBank.setMainSettings(settings);
+
+ RenderWorker::Request request;
+ request.settings = settings;
 
- DBG("Adding extra samples: " << extraSamples << " (" << tailDuration << " seconds)");
- 
- if (extraSamples > 0)
- {
- juce::AudioBuffer<float> extendedBuffer(reverbBuffer.getNumChannels(), 
- reverbBuffer.getNumSamples() + extraSamples);
- extendedBuffer.clear();
- 
- // Copy original samples
- for (int channel = 0; channel < reverbBuffer.getNumChannels(); ++channel)
- {
- extendedBuffer.copyFrom(channel, 0, reverbBuffer, channel, 0, reverbBuffer.getNumSamples());
- }
- 
- reverbBuffer.setSize(extendedBuffer.getNumChannels(), extendedBuffer.getNumSamples(), false, false, true);
- reverbBuffer.makeCopyOf(extendedBuffer);
- 
- DBG("Extended buffer size: " << reverbBuffer.getNumSamples() << " samples");
- }
- 
- // Step 4: Apply reverb in smaller chunks to prevent distortion
- const int chunkSize = 512;
- 
- if (reverbBuffer.getNumChannels() == 1)
- {
- // Mono - convert to stereo
- juce::AudioBuffer<float> stereoBuffer(2, reverbBuffer.getNumSamples());
- stereoBuffer.clear();
- stereoBuffer.copyFrom(0, 0, reverbBuffer, 0, 0, reverbBuffer.getNumSamples());
- stereoBuffer.copyFrom(1, 0, reverbBuffer, 0, 0, reverbBuffer.getNumSamples());
- 
- // Process in chunks
- for (int pos = 0; pos < stereoBuffer.getNumSamples(); pos += chunkSize)
- {
- int samplesToProcess = juce::jmin(chunkSize, stereoBuffer.getNumSamples() - pos);
- reverb.processStereo(stereoBuffer.getWritePointer(0) + pos, 
- stereoBuffer.getWritePointer(1) + pos, 
- samplesToProcess);
- }
- 
- reverbBuffer.setSize(2, stereoBuffer.getNumSamples(), false, false, true);
- reverbBuffer.makeCopyOf(stereoBuffer);
- }
- else
- {
- // Stereo - process in chunks
- for (int pos = 0; pos < reverbBuffer.getNumSamples(); pos += chunkSize)
- {
- int samplesToProcess = juce::jmin(chunkSize, reverbBuffer.getNumSamples() - pos);
- reverb.processStereo(reverbBuffer.getWritePointer(0) + pos, 
- reverbBuffer.getWritePointer(1) + pos, 
- samplesToProcess);
- }
- }
- 
- // Step 4.5: Apply additional stereo width using Haas effect (delay-based)
- if (stereoWidth != 0.5f && reverbBuffer.getNumChannels() >= 2)
- {
- // Calculate delay time based on width (0-20ms range)
- // 0.5 = no delay (normal), 0.0 = mono, 1.0 = max width
- float delayMs = 0.0f;
- 
- if (stereoWidth < 0.5f)
- {
- // Narrowing: move towards mono
- float monoAmount = 1.0f - (stereoWidth * 2.0f);
- 
- for (int i = 0; i < reverbBuffer.getNumSamples(); ++i)
- {
- float left = reverbBuffer.getSample(0, i);
- float right = reverbBuffer.getSample(1, i);
- float mono = (left + right) * 0.5f;
- 
- // Blend towards mono
- left = left * (1.0f - monoAmount) + mono * monoAmount;
- right = right * (1.0f - monoAmount) + mono * monoAmount;
- 
- reverbBuffer.setSample(0, i, left);
- reverbBuffer.setSample(1, i, right);
- }
- }
- else if (stereoWidth > 0.5f)
- {
- // Widening: apply Haas effect
- delayMs = (stereoWidth - 0.5f) * 40.0f; // 0-20ms
- int delaySamples = (int)(delayMs * 0.001f * currentSampleRate);
- 
- if (delaySamples > 0 && delaySamples < 2000) // Max 2000 samples
- {
- juce::AudioBuffer<float> wideBuffer(2, reverbBuffer.getNumSamples());
- wideBuffer.makeCopyOf(reverbBuffer);
- 
- // Delay the right channel slightly for width
- for (int i = delaySamples; i < wideBuffer.getNumSamples(); ++i)
- {
- float delayedSample = reverbBuffer.getSample(1, i - delaySamples);
- wideBuffer.setSample(1, i, delayedSample);
- }
- 
- // Also add some subtle cross-feed for more natural sound
- float crossfeed = 0.15f;
- for (int i = 0; i < wideBuffer.getNumSamples(); ++i)
- {
- float left = wideBuffer.getSample(0, i);
- float right = wideBuffer.getSample(1, i);
- 
- wideBuffer.setSample(0, i, left - (right * crossfeed));
- wideBuffer.setSample(1, i, right - (left * crossfeed));
- }
- 
- reverbBuffer.makeCopyOf(wideBuffer);
- }
- }
- }
- 
- // Step 5: Clean up the reverb output
- // OPTIMIZATION: Simplified cleanup - removed DC offset calculation
- for (int channel = 0; channel < reverbBuffer.getNumChannels(); ++channel)
- {
- auto* data = reverbBuffer.getWritePointer(channel);
- 
- // Apply cleanup with soft clipping and denormal removal
- for (int i = 0; i < reverbBuffer.getNumSamples(); ++i)
- {
- float sample = data[i];
- 
- // Soft clip to prevent harsh distortion
- if (sample > 0.95f)
- sample = 0.95f + 0.05f * std::tanh((sample - 0.95f) / 0.05f);
- else if (sample < -0.95f)
- sample = -0.95f + 0.05f * std::tanh((sample + 0.95f) / 0.05f);
- 
- // Remove denormals
- if (std::abs(sample) < 1e-10f)
- sample = 0.0f;
- 
- data[i] = sample;
- }
- }
- 
- // Step 6: Reverse the audio OR Create transition
- if (transitionMode)
- {
- // TRANSITION MODE: Reversed reverb -> Original sample WITH reverb
- // This creates a smooth transition effect where the original also has reverb!
- 
- // First, reverse the reverb buffer
- for (int channel = 0; channel < reverbBuffer.getNumChannels(); ++channel)
- {
- auto* data = reverbBuffer.getWritePointer(channel);
- std::reverse(data, data + reverbBuffer.getNumSamples());
- }
- 
- // Now create a FORWARD reverb for the original sample
- juce::AudioBuffer<float> originalWithReverb;
- originalWithReverb.makeCopyOf(originalSample);
- 
- // Reset reverb for forward processing
- reverb.reset();
- reverb.setSampleRate(currentSampleRate);
- 
- // IDENTICAL reverb settings - create SYMMETRY!
- // Use THE SAME settings as the reversed reverb for visual balance
- juce::Reverb::Parameters forwardReverbParams;
- forwardReverbParams.roomSize = adjustedRoomSize; // SAME as reversed!
- forwardReverbParams.damping = reverbParams.damping; // SAME damping!
- forwardReverbParams.wetLevel = reverbParams.wetLevel; // SAME wet level!
- forwardReverbParams.dryLevel = 0.0f; // 0% dry - PURE reverb like the reversed!
- forwardReverbParams.width = stereoWidth; // SAME
- forwardReverbParams.freezeMode = 0.0f;
- reverb.setParameters(forwardReverbParams);
- 
- // Add extra silence for tail (capped at 4s for transition mode)
- float forwardTailDuration = juce::jmin(tailDuration, 4.0f);
- int extraSamplesForward = (int)(forwardTailDuration * currentSampleRate);
- 
- if (extraSamplesForward > 0)
- {
- // Extend original sample with silence to match reversed reverb tail
- juce::AudioBuffer<float> extendedOriginal(originalWithReverb.getNumChannels(), 
- originalWithReverb.getNumSamples() + extraSamplesForward);
- extendedOriginal.clear();
- 
- // Copy original to beginning
- for (int channel = 0; channel < originalWithReverb.getNumChannels(); ++channel)
- {
- extendedOriginal.copyFrom(channel, 0, originalWithReverb, channel, 0, originalWithReverb.getNumSamples());
- }
- 
- // Replace originalWithReverb with extended version
- originalWithReverb = std::move(extendedOriginal);
- }
- 
- DBG(" SYMMETRICAL reverb settings:");
- DBG(" Room size: " + juce::String(adjustedRoomSize, 3));
- DBG(" Damping: " + juce::String(reverbParams.damping, 3));
- DBG(" Wet level: " + juce::String(reverbParams.wetLevel, 3));
- DBG(" Extra samples: " + juce::String(extraSamplesForward));
- 
- // Process original sample with reverb
- if (originalWithReverb.getNumChannels() == 1)
- {
- reverb.processMono(originalWithReverb.getWritePointer(0), originalWithReverb.getNumSamples());
- }
- else if (originalWithReverb.getNumChannels() >= 2)
- {
- reverb.processStereo(originalWithReverb.getWritePointer(0), 
- originalWithReverb.getWritePointer(1), 
- originalWithReverb.getNumSamples());
- }
- 
- // Get lengths for blending calculation
- int reversedReverbLength = reverbBuffer.getNumSamples();
- int originalLength = originalWithReverb.getNumSamples();
- 
- // NOW CREATE A SMOOTH OVERLAP/BLEND - NO GAP!
- // Instead of putting original at the END, we OVERLAP them!
- 
- // Overlap length - how much the two buffers overlap (50% of original or reverb, whichever is shorter)
- int overlapLength = juce::jmin(originalLength / 2, reversedReverbLength / 2);
- 
- // Total length is LESS than sum because of overlap!
- int totalLength = reversedReverbLength + originalLength - overlapLength;
- 
- // Start position for original sample (overlaps with end of reversed reverb)
- int originalStartPos = reversedReverbLength - overlapLength;
- 
- // Create output buffer
- processedSample.setSize(reverbBuffer.getNumChannels(), 
- totalLength, 
- false, false, true);
- processedSample.clear();
- 
- // 1 Copy reversed reverb to the beginning (full length)
- for (int channel = 0; channel < processedSample.getNumChannels(); ++channel)
- {
- processedSample.copyFrom(channel, 0, reverbBuffer, channel, 0, reversedReverbLength);
- }
- 
- // 2 Blend original sample WITH REVERB starting BEFORE reverb ends
- for (int channel = 0; channel < juce::jmin(processedSample.getNumChannels(), originalWithReverb.getNumChannels()); ++channel)
- {
- auto* destData = processedSample.getWritePointer(channel);
- auto* srcData = originalWithReverb.getReadPointer(channel);
- 
- for (int i = 0; i < originalLength; ++i)
- {
- int destPos = originalStartPos + i;
- if (destPos >= 0 && destPos < totalLength)
- {
- // Calculate blend factor based on position in overlap
- float blend = 1.0f; // Default: full original volume
- 
- if (i < overlapLength)
- {
- // We're in the overlap zone - crossfade!
- float fadePos = (float)i / overlapLength;
- 
- // Smooth S-curve for better blending
- fadePos = fadePos * fadePos * (3.0f - 2.0f * fadePos); // Smoothstep
- 
- // Original fades IN, reverb already there will fade OUT naturally
- blend = fadePos;
- }
- 
- // Mix the samples
- destData[destPos] = destData[destPos] * (1.0f - blend) + srcData[i] * blend;
- }
- }
- }
- 
- DBG(" TRANSITION MODE: Reversed reverb -> Original WITH reverb");
- DBG(" Overlap length: " + juce::String(overlapLength) + " samples (" + juce::String(overlapLength / currentSampleRate, 2) + "s)");
- DBG(" Total length: " + juce::String(totalLength) + " samples");
- }
- else
- {
- // REVERSE ONLY MODE: Standard reverse reverb
- processedSample.setSize(reverbBuffer.getNumChannels(), 
- reverbBuffer.getNumSamples(), 
- false, false, true);
- processedSample.makeCopyOf(reverbBuffer);
- 
- // Reverse the entire buffer
- for (int channel = 0; channel < processedSample.getNumChannels(); ++channel)
- {
- auto* data = processedSample.getWritePointer(channel);
- std::reverse(data, data + processedSample.getNumSamples());
- }
- 
- DBG(" REVERSE ONLY MODE: Reversed reverb only (length: " + juce::String(processedSample.getNumSamples()) + " samples)");
- }
- 
- // Step 6.5: Apply Low Cut Filter (simple 1-pole high-pass)
- if (lowCutFreq > 20.0f && currentSampleRate > 0.0)
- {
- // Calculate filter coefficient
- float RC = 1.0f / (juce::MathConstants<float>::twoPi * lowCutFreq);
- float dt = 1.0f / static_cast<float>(currentSampleRate);
- float alpha = RC / (RC + dt);
- 
- // Reset filter state
- lowCutPrevInputL = 0.0f;
- lowCutPrevInputR = 0.0f;
- lowCutPrevOutputL = 0.0f;
- lowCutPrevOutputR = 0.0f;
- 
- // Apply filter to left channel
- if (processedSample.getNumChannels() >= 1)
- {
- auto* dataL = processedSample.getWritePointer(0);
- for (int i = 0; i < processedSample.getNumSamples(); ++i)
- {
- float input = dataL[i];
- float output = alpha * (lowCutPrevOutputL + input - lowCutPrevInputL);
- lowCutPrevInputL = input;
- lowCutPrevOutputL = output;
- dataL[i] = output;
- }
- }
- 
- // Apply filter to right channel
- if (processedSample.getNumChannels() >= 2)
- {
- auto* dataR = processedSample.getWritePointer(1);
- for (int i = 0; i < processedSample.getNumSamples(); ++i)
- {
- float input = dataR[i];
- float output = alpha * (lowCutPrevOutputR + input - lowCutPrevInputR);
- lowCutPrevInputR = input;
- lowCutPrevOutputR = output;
- dataR[i] = output;
- }
- }
- 
- DBG("Applied Low Cut filter at " << lowCutFreq << " Hz");
- }
- 
- // Step 7: Final gentle normalization to -3dB
- // OPTIMIZATION: Use getMagnitude() instead of manual loop
- maxLevel = processedSample.getMagnitude(0, processedSample.getNumSamples());
- 
- // Normalize to -3dB (0.707) instead of 0dB to prevent clipping
- if (maxLevel > 0.001f)
- {
- float targetLevel = 0.707f; // -3dB
- float scaleFactor = targetLevel / maxLevel;
- processedSample.applyGain(scaleFactor); // Apply to all channels at once
- }
- 
- // Note: Fades are NOT applied here - they're applied during playback/export only
- // This keeps the processed buffer "clean" for fade adjustments
- 
- // Restore playback if it was playing before reprocessing
- if (wasPlaying && processedSample.getNumSamples() > 0)
- {
- int newSampleLength = processedSample.getNumSamples();
- if (oldSampleLength > 0 && savedPlaybackPos > 0)
- {
- // Scale position proportionally if sample length changed
- float progress = (float)savedPlaybackPos / (float)oldSampleLength;
- currentPlaybackPosition = juce::jlimit(0, newSampleLength - 1,
- (int)(progress * newSampleLength));
- }
- else
- {
- currentPlaybackPosition = 0;
- }
- // Restore tremolo counter proportionally too
- tremoloSampleCounter = currentPlaybackPosition;
- isPlaying = true;
- DBG("Playback restored at position: " + juce::String(currentPlaybackPosition));
- }
- else
- {
- currentPlaybackPosition = 0;
- tremoloSampleCounter = 0;
- }
- }
- catch (const std::bad_alloc& e)
  {
- DBG("Memory allocation failed in processReverseReverb: " << e.what());
- processedSample.setSize(0, 0);
- reverbBuffer.setSize(0, 0);
- isPlaying = false;
- currentPlaybackPosition = 0;
- tremoloSampleCounter = 0;
+ const juce::SpinLock::ScopedLockType sl(sourceLock);
+ request.source = requestedSample;
+ request.sourceFile = requestedFile;
  }
- catch (const std::exception& e)
+
+ if (request.source == nullptr || request.source->isEmpty())
+ return;
+
+ // Coalesced on the worker: a newer request cancels the render in flight
+ renderWorker.requestRender(std::move(request));
+}
+
+RenderedSample::Ptr ReverseReverbAudioProcessor::streamIfLong(RenderedSample::Ptr rendered, double sampleRate) const
+{
+ // Long renders play from a memory-mapped temp file instead of RAM
+ // (out-of-core renders already do). sampleRate is the render's own - this runs on render threads.
+ if (! rendered->isStreamed() && rendered->getNumSamples() > (int)(streamingThresholdSeconds * sampleRate))
  {
- DBG("Exception in processReverseReverb: " << e.what());
- processedSample.setSize(0, 0);
- reverbBuffer.setSize(0, 0);
- isPlaying = false;
- currentPlaybackPosition = 0;
- tremoloSampleCounter = 0;
+ auto tempDir = getScratchDirectory();
+ tempDir.createDirectory();
+
+ auto streamed = RenderedSample::createStreamed(rendered->getBuffer(), RenderedSample::getUniqueScratchFile(tempDir, "render"));
+ if (streamed != nullptr)
+ return streamed;
  }
- catch (...)
+
+ return rendered;
+}
+
+RenderedSample::Ptr ReverseReverbAudioProcessor::publishRender(RenderedSample::Ptr rendered, const RenderWorker::Request& request)
+{
+ rendered = streamIfLong(rendered, request.settings.sampleRate);
+
+ // The render's source becomes the loaded one only now, together with the render itself
+ bool isNewSource;
  {
- DBG("Unknown exception in processReverseReverb");
- processedSample.setSize(0, 0);
- reverbBuffer.setSize(0, 0);
- isPlaying = false;
- currentPlaybackPosition = 0;
- tremoloSampleCounter = 0;
+ const juce::SpinLock::ScopedLockType sl(sourceLock);
+ isNewSource = request.source != originalSample;
+ originalSample = request.source;
+ loadedFile = request.sourceFile;
  }
+
+ refreshFadeEnvelope(rendered->getNumSamples()); // Fade tables for the new length go out first
+
+ // A new sample stops the old one's voices instead of carrying them over (the audio
+ // thread picks this up on the block it adopts the render, or the one before)
+ if (isNewSource)
+ stopRequested = true;
+
+ renderHandoff.publish(rendered);
+ ++renderedGeneration;
+ return rendered;
+}
+
+juce::File ReverseReverbAudioProcessor::getScratchDirectory()
+{
+ return juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("ReverseReverb");
+}
+
+bool ReverseReverbAudioProcessor::isSampleLoaded() const
+{
+ auto latest = renderHandoff.getLatest();
+ return latest != nullptr && !latest->isEmpty();
 }
 
 void ReverseReverbAudioProcessor::triggerSample()
 {
- if (processedSample.getNumSamples() > 0 && processedSample.getNumChannels() > 0)
- {
- currentPlaybackPosition = 0;
- isPlaying = true;
- 
- // Reset tremolo sample counter for Rate Ramp
- tremoloSampleCounter = 0;
- 
- DBG(" ");
- DBG(" SAMPLE TRIGGERED!");
- DBG(" Sample length: " << processedSample.getNumSamples() << " samples");
- DBG(" Tremolo enabled: " << (tremoloEnabled ? "YES" : "NO"));
- DBG(" Sync enabled: " << (tremoloSyncEnabled ? "YES" : "NO"));
- DBG(" Rate Ramp enabled: " << (tremoloRateRampEnabled ? "YES" : "NO"));
- if (tremoloRateRampEnabled)
+ // Playback state belongs to the audio thread - just ask it to start
+ if (isSampleLoaded())
+ triggerRequested = true;
+}
+
+void ReverseReverbAudioProcessor::startPlayback(int note, float velocity)
+{
+ // Keys inside a loaded bank slot's range play that slot, every other key the main sample
+ const int slot = note >= 0 ? sampleBank.findSlotForNote(note) : -1;
+ auto* target = slot >= 0 ? bankPlaybackSamples[(size_t) slot] : playbackSample;
+
+ if (target != nullptr && !target->isEmpty())
  {
- DBG(" Start division: " << tremoloStartDivision);
- DBG(" End division: " << tremoloEndDivision);
- }
- DBG(" Counter reset to: " << tremoloSampleCounter);
- DBG(" ");
+ // New voice from the top - voices already playing keep going (no DBG: this is the audio thread)
+ voices.startVoice(note, velocity, slot);
  }
 }
 
 bool ReverseReverbAudioProcessor::exportProcessedAudio(const juce::File& file)
 {
- DBG(" exportProcessedAudio called!");
- DBG(" File path: " + file.getFullPathName());
- DBG(" Num samples: " + juce::String(processedSample.getNumSamples()));
- DBG(" Num channels: " + juce::String(processedSample.getNumChannels()));
- 
- if (processedSample.getNumSamples() == 0 || processedSample.getNumChannels() == 0)
+ auto rendered = renderHandoff.getLatest();
+
+ if (rendered == nullptr || rendered->isEmpty())
  {
  DBG(" No processed sample to export!");
  return false;
  }
- 
- // Create a copy with fades applied
- juce::AudioBuffer<float> exportBuffer;
- exportBuffer.makeCopyOf(processedSample);
- 
- // Apply fades to the export buffer
- if (fadeIn > 0.0f || fadeOut > 0.0f)
- {
- auto totalSamples = exportBuffer.getNumSamples();
- 
- for (int channel = 0; channel < exportBuffer.getNumChannels(); ++channel)
- {
- auto* data = exportBuffer.getWritePointer(channel);
- 
- for (int i = 0; i < totalSamples; ++i)
- {
- float fadeGain = 1.0f;
- float samplePosition = (float)i / totalSamples;
- 
- // Apply fade in with cubic curve for sharper fade
- if (fadeIn > 0.0f && samplePosition < fadeIn)
- {
- float fadePos = samplePosition / fadeIn;
- fadeGain *= fadePos * fadePos * fadePos; // Cubic curve
- }
- 
- // Apply fade out with cubic curve for sharper fade
- if (fadeOut > 0.0f && samplePosition > (1.0f - fadeOut))
- {
- float fadeOutPos = (1.0f - samplePosition) / fadeOut;
- fadeGain *= fadeOutPos * fadeOutPos * fadeOutPos; // Cubic curve
- }
- 
- data[i] *= fadeGain;
- }
- }
- }
- 
- // Delete existing file if it exists
- if (file.exists())
- {
- DBG(" Deleting existing file...");
- file.deleteFile();
- }
- 
- // Create WAV file
- DBG(" Creating output stream...");
- std::unique_ptr<juce::FileOutputStream> outputStream(file.createOutputStream());
- 
- if (outputStream == nullptr)
- {
- DBG(" Failed to create output stream!");
- return false;
- }
- 
- // Create WAV writer
- DBG(" Creating WAV writer...");
- juce::WavAudioFormat wavFormat;
- std::unique_ptr<juce::AudioFormatWriter> writer(
- wavFormat.createWriterFor(outputStream.get(),
- currentSampleRate,
- exportBuffer.getNumChannels(),
- 24, // 24-bit
- {},
- 0));
- 
- if (writer == nullptr)
- {
- DBG(" Failed to create WAV writer!");
- // outputStream still owns the stream, it will be cleaned up automatically
- return false;
- }
 
- // Writer successfully created - it now owns the stream, so release our ownership
- outputStream.release();
- 
- // Write the export buffer with fades applied
- DBG(" Writing audio data to file...");
- DBG(" Samples to write: " + juce::String(exportBuffer.getNumSamples()));
- bool writeSuccess = writer->writeFromAudioSampleBuffer(exportBuffer, 0, exportBuffer.getNumSamples());
- 
- if (!writeSuccess)
- {
- DBG(" Failed to write audio data!");
- return false;
- }
- 
- DBG(" Export successful!");
- DBG(" File size: " + juce::String(file.getSize()) + " bytes");
- 
- return true;
+ // 24-bit WAV with the same fade tables playback reads
+ auto fades = refreshFadeEnvelope(rendered->getNumSamples());
+ return RenderExport::writeWav(rendered->getBuffer(), fades.get(), currentSampleRate, file);
 }
 
 bool ReverseReverbAudioProcessor::hasEditor() const
@@ -1002,6 +572,42 @@ void ReverseReverbAudioProcessor::getStateInformation (juce::MemoryBlock& destDa
  xml->setAttribute("tailDivision", tailDivision);
  xml->setAttribute("manualBpm", (double)manualBpm);
  xml->setAttribute("stereoWidth", stereoWidth);
+ xml->setAttribute("reverbEngine", (int)reverbEngine);
+
+ {
+ const juce::SpinLock::ScopedLockType sl(sourceLock);
+ // The newest load, even if its render hasn't landed yet
+ if (requestedFile != juce::File())
+ xml->setAttribute("sourceFile", requestedFile.getFullPathName());
+
+ if (impulseResponse != nullptr && impulseResponseFile != juce::File())
+ xml->setAttribute("impulseResponseFile", impulseResponseFile.getFullPathName());
+ }
+
+ // Bank slots: file, keys and the render parameters each one was given
+ for (int i = 0; i < SampleBank::maxSlots; ++i)
+ {
+ if (!sampleBank.isSlotLoaded(i))
+ continue;
+
+ const auto settings = sampleBank.getSlotSettings(i);
+ auto* slotXml = xml->createNewChildElement("BankSlot");
+ slotXml->setAttribute("index", i);
+ slotXml->setAttribute("file", sampleBank.getSlotFile(i).getFullPathName());
+ slotXml->setAttribute("lowNote", sampleBank.getSlotLowNote(i));
+ slotXml->setAttribute("highNote", sampleBank.getSlotHighNote(i));
+ slotXml->setAttribute("reverbSize", (double)settings.reverbSize);
+ slotXml->setAttribute("tailSeconds", (double)settings.tailSeconds);
+ slotXml->setAttribute("stereoWidth", (double)settings.stereoWidth);
+ slotXml->setAttribute("lowCutFreq", (double)settings.lowCutFreq);
+ slotXml->setAttribute("transitionMode", settings.transitionMode ? 1 : 0);
+ slotXml->setAttribute("reverbEngine", (int)settings.engine);
+
+ if (settings.impulseResponse != nullptr && settings.impulseResponseFile != juce::File())
+ slotXml->setAttribute("impulseResponseFile", settings.impulseResponseFile.getFullPathName());
+ slotXml->setAttribute("followsMain", sampleBank.doesSlotFollowMain(i) ? 1 : 0);
+ }
+
  copyXmlToBinary(*xml, destData);
 }
 
@@ -1020,7 +626,50 @@ void ReverseReverbAudioProcessor::setStateInformation (const void* data, int siz
  reverbSize = 1.0f;
  tailDivision = xmlState->getIntAttribute("tailDivision", 3);
  manualBpm = (float)xmlState->getDoubleAttribute("manualBpm", 120.0);
+ reverbEngine = xmlState->getIntAttribute("reverbEngine", 0) == 1 ? ReverbEngine::convolution : ReverbEngine::freeverb;
  dryWet = 1.0f;
+
+ // The user IR decodes in the background too, and re-renders when it lands
+ clearImpulseResponse();
+ auto impulsePath = xmlState->getStringAttribute("impulseResponseFile");
+ if (impulsePath.isNotEmpty() && juce::File::isAbsolutePath(impulsePath))
+ loadImpulseResponse(juce::File(impulsePath));
+
+ // Reload the sample in the background (a compressed file comes back from the decoded cache)
+ auto sourcePath = xmlState->getStringAttribute("sourceFile");
+ if (sourcePath.isNotEmpty() && juce::File::isAbsolutePath(sourcePath))
+ loadAudioFile(juce::File(sourcePath));
+
+ // Bank slots decode and render in parallel on the shared render pool
+ sampleBank.clearAll();
+
+ for (auto* slotXml : xmlState->getChildWithTagNameIterator("BankSlot"))
+ {
+ const int index = slotXml->getIntAttribute("index", -1);
+ const auto slotPath = slotXml->getStringAttribute("file");
+
+ if (!juce::isPositiveAndBelow(index, SampleBank::maxSlots) || !juce::File::isAbsolutePath(slotPath))
+ continue;
+
+ auto settings = getRenderSettings();
+ settings.reverbSize = (float)slotXml->getDoubleAttribute("reverbSize", settings.reverbSize);
+ settings.tailSeconds = (float)slotXml->getDoubleAttribute("tailSeconds", settings.tailSeconds);
+ settings.stereoWidth = (float)slotXml->getDoubleAttribute("stereoWidth", settings.stereoWidth);
+ settings.lowCutFreq = (float)slotXml->getDoubleAttribute("lowCutFreq", settings.lowCutFreq);
+ settings.transitionMode = slotXml->getIntAttribute("transitionMode", 0) != 0;
+ settings.engine = slotXml->getIntAttribute("reverbEngine", 0) == 1 ? ReverbEngine::convolution : ReverbEngine::freeverb;
+
+ // The slot's job decodes its own IR before rendering (see SampleBank)
+ const auto slotImpulsePath = slotXml->getStringAttribute("impulseResponseFile");
+ settings.impulseResponse = nullptr;
+ settings.impulseResponseFile = juce::File::isAbsolutePath(slotImpulsePath) ? juce::File(slotImpulsePath) : juce::File();
+
+ // Slots saved before following existed kept their own settings
+ const bool followsMain = slotXml->getIntAttribute("followsMain", 0) != 0;
+
+ sampleBank.loadSlot(index, juce::File(slotPath), slotXml->getIntAttribute("lowNote", 0),
+ slotXml->getIntAttribute("highNote", -1), followsMain ? getRenderSettings() : settings, followsMain);
+ }
  }
  }
 }
@@ -1048,215 +697,47 @@ double ReverseReverbAudioProcessor::getEffectiveBpm() const
 // Convert tail division + BPM to duration in seconds
 float ReverseReverbAudioProcessor::getTailDurationSeconds() const
 {
- double bpm = getEffectiveBpm();
- if (bpm <= 0.0) bpm = 120.0;
- float beats = divisionBeats[juce::jlimit(0, 8, tailDivision)];
- return (float)((60.0 / bpm) * (double)beats);
+ return RenderSettings::getTailSeconds(tailDivision, getEffectiveBpm());
 }
 
-// Calculate Tremolo LFO value (returns gain multiplier between 0.0 and 1.0)
-float ReverseReverbAudioProcessor::calculateTremoloLFO()
+void ReverseReverbAudioProcessor::getDisplaySummaryWithTremolo(int width, std::vector<float>& mins, std::vector<float>& maxs) const
 {
- float lfoValue = 0.0f;
-
- // Calculate the LFO frequency based on mode
- float currentFrequency = tremoloRate;
-
- // Division multiplier table (shared between sync and non-sync modes)
- static const float divisionMultipliers[] = {
- 0.125f, // 0: 2 Bar
- 0.25f, // 1: 1 Bar
- 1.0f, // 2: 1/1
- 2.0f, // 3: 1/2
- 4.0f, // 4: 1/4
- 8.0f, // 5: 1/8
- 16.0f, // 6: 1/16
- 32.0f, // 7: 1/32
- 64.0f // 8: 1/64
- };
-
- // Rate Ramp (works with or without sync!)
- if (tremoloRateRampEnabled && isSampleLoaded() && this->isPlaying.load())
- {
- // Calculate progress through the sample (0.0 to 1.0)
- float progress = static_cast<float>(tremoloSampleCounter) /
- static_cast<float>(processedSample.getNumSamples());
- progress = juce::jlimit(0.0f, 1.0f, progress);
-
- // Get start and end division multipliers
- float startMultiplier = divisionMultipliers[juce::jlimit(0, 8, tremoloStartDivision)];
- float endMultiplier = divisionMultipliers[juce::jlimit(0, 8, tremoloEndDivision)];
-
- // Interpolate between start and end
- float divisionMultiplier = startMultiplier + (endMultiplier - startMultiplier) * progress;
-
- // Get BPM (from host or fallback 120)
- double effectiveBpm = 120.0;
- auto playHead = getPlayHead();
- if (playHead != nullptr)
- {
- auto positionInfo = playHead->getPosition();
- if (positionInfo.hasValue())
- {
- auto bpm = positionInfo->getBpm();
- if (bpm.hasValue() && *bpm > 0.0)
- effectiveBpm = *bpm;
- }
- }
-
- // Calculate frequency: BPM * (subdivision / 60)
- currentFrequency = static_cast<float>((effectiveBpm / 60.0) * divisionMultiplier);
-
- // Debug output every 10000 samples
- static int debugCounter = 0;
- if (++debugCounter >= 10000)
- {
- DBG(" RATE RAMP ACTIVE! Progress: " << juce::String(progress, 3)
- << " Freq: " << juce::String(currentFrequency, 2) << " Hz"
- << " BPM: " << effectiveBpm);
- debugCounter = 0;
- }
- }
- else if (tremoloSyncEnabled)
- {
- // Host Sync mode (without rate ramp)
- auto playHead = getPlayHead();
- if (playHead != nullptr)
- {
- auto positionInfo = playHead->getPosition();
-
- if (positionInfo.hasValue())
+ auto rendered = renderHandoff.getLatest();
+ if (rendered == nullptr || rendered->isEmpty())
  {
- auto bpm = positionInfo->getBpm();
- auto ppqPosition = positionInfo->getPpqPosition();
- auto isPlayingHost = positionInfo->getIsPlaying();
-
- double effectiveBpm = (bpm.hasValue() && *bpm > 0.0) ? *bpm : 120.0;
- bool useHostTransport = isPlayingHost && bpm.hasValue();
-
- if (effectiveBpm > 0.0)
- {
- float divisionMultiplier = divisionMultipliers[juce::jlimit(0, 8, tremoloSyncDivision)];
- currentFrequency = static_cast<float>((effectiveBpm / 60.0) * divisionMultiplier);
-
- // Reset phase on transport for tight sync
- if (useHostTransport && ppqPosition.hasValue())
- {
- double currentPpq = *ppqPosition;
- if (currentPpq != lastPosInfo)
- {
- double phaseOffset = std::fmod(currentPpq * divisionMultiplier, 1.0);
- tremoloPhase = static_cast<float>(phaseOffset * juce::MathConstants<double>::twoPi);
- lastPosInfo = currentPpq;
- }
- }
- }
- }
- }
- }
- // else: use tremoloRate (Hz) as-is (free-running mode)
-
- // Calculate LFO waveform
- switch (tremoloWaveform)
- {
- case 0: // Sine
- lfoValue = std::sin(tremoloPhase);
- break;
-
- case 1: // Triangle
- lfoValue = (2.0f / juce::MathConstants<float>::pi) * std::asin(std::sin(tremoloPhase));
- break;
-
- case 2: // Square
- lfoValue = (tremoloPhase < juce::MathConstants<float>::pi) ? 1.0f : -1.0f;
- break;
-
- default:
- lfoValue = std::sin(tremoloPhase);
- break;
+ mins.clear();
+ maxs.clear();
+ return;
  }
 
- // Advance phase
- float phaseIncrement = (juce::MathConstants<float>::twoPi * currentFrequency) / static_cast<float>(currentSampleRate);
- tremoloPhase += phaseIncrement;
-
- // Wrap phase
- if (tremoloPhase >= juce::MathConstants<float>::twoPi)
- tremoloPhase = std::fmod(tremoloPhase, juce::MathConstants<float>::twoPi);
-
- // Convert LFO from [-1, 1] to gain multiplier [1-depth, 1]
- float gainMultiplier = 1.0f - (tremoloDepth * 0.5f * (1.0f - lfoValue));
-
- return gainMultiplier;
-}
-
-void ReverseReverbAudioProcessor::getDisplayBufferWithTremolo(juce::AudioBuffer<float>& displayBuffer) const
-{
- if (processedSample.getNumSamples() == 0 || !tremoloEnabled)
+ if (!tremoloEnabled)
  {
- displayBuffer.makeCopyOf(processedSample);
+ WaveformSummary::compute(rendered->getBuffer(), width, mins, maxs);
  return;
  }
 
- displayBuffer.makeCopyOf(processedSample);
- int numSamples = displayBuffer.getNumSamples();
- int numChannels = displayBuffer.getNumChannels();
-
- // Division multiplier table
- static const float divisionMultipliers[] = {
- 0.125f, 0.25f, 1.0f, 2.0f, 4.0f, 8.0f, 16.0f, 32.0f, 64.0f
- };
-
- // Simulate the LFO across the entire buffer for visualization
- float phase = 0.0f;
- float sampleRate = (float)currentSampleRate;
- if (sampleRate <= 0.0f) sampleRate = 44100.0f;
+ const int numSamples = rendered->getNumSamples();
 
- for (int i = 0; i < numSamples; ++i)
- {
- // Determine frequency at this sample position
- float freq = tremoloRate;
+ // Simulate the LFO across the entire buffer with the playback engine (120 BPM, transport stopped)
+ TremoloLfo::Settings settings;
+ settings.depth = tremoloDepth;
+ settings.rate = tremoloRate;
+ settings.waveform = tremoloWaveform;
+ settings.syncEnabled = tremoloSyncEnabled;
+ settings.syncDivision = tremoloSyncDivision;
+ settings.rateRampEnabled = tremoloRateRampEnabled;
+ settings.startDivision = tremoloStartDivision;
+ settings.endDivision = tremoloEndDivision;
+ settings.sampleRate = currentSampleRate > 0.0 ? currentSampleRate : 44100.0;
 
- if (tremoloRateRampEnabled)
- {
- // Rate Ramp: interpolate based on position in sample
- float progress = (float)i / (float)numSamples;
- float startMult = divisionMultipliers[juce::jlimit(0, 8, tremoloStartDivision)];
- float endMult = divisionMultipliers[juce::jlimit(0, 8, tremoloEndDivision)];
- float divMult = startMult + (endMult - startMult) * progress;
- // Use 120 BPM as default for visualization
- freq = (120.0f / 60.0f) * divMult;
- }
- else if (tremoloSyncEnabled)
- {
- float divMult = divisionMultipliers[juce::jlimit(0, 8, tremoloSyncDivision)];
- freq = (120.0f / 60.0f) * divMult;
- }
+ TremoloState state;
+ const TransportSnapshot transport;
 
- // Calculate LFO value
- float lfoValue = 0.0f;
- switch (tremoloWaveform)
+ // The summary asks for gains block by block, in order - exactly how the LFO runs
+ WaveformSummary::compute(rendered->getBuffer(), width, mins, maxs, [&](int, int count, float* gains)
  {
- case 0: lfoValue = std::sin(phase); break;
- case 1: lfoValue = (2.0f / juce::MathConstants<float>::pi) * std::asin(std::sin(phase)); break;
- case 2: lfoValue = (phase < juce::MathConstants<float>::pi) ? 1.0f : -1.0f; break;
- default: lfoValue = std::sin(phase); break;
- }
-
- // Convert to gain
- float gain = 1.0f - (tremoloDepth * 0.5f * (1.0f - lfoValue));
-
- // Apply to all channels
- for (int ch = 0; ch < numChannels; ++ch)
- {
- displayBuffer.setSample(ch, i, displayBuffer.getSample(ch, i) * gain);
- }
-
- // Advance phase
- phase += (juce::MathConstants<float>::twoPi * freq) / sampleRate;
- if (phase >= juce::MathConstants<float>::twoPi)
- phase = std::fmod(phase, juce::MathConstants<float>::twoPi);
- }
+ TremoloLfo::render(state, settings, transport, gains, count, 0, numSamples);
+ });
 }
 
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
@@ -1,6 +1,17 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "RealtimeHandoff.h"
+#include "RenderedSample.h"
+#include "FadeEnvelope.h"
+#include "RenderWorker.h"
+#include "SampleLoader.h"
+#include "SampleBank.h"
+#include "VoicePool.h"
+#include "VoicePlayback.h"
+#include "RenderExport.h"
+#include "CpuLoadMeter.h"
+#include "RenderPrefetcher.h"
 
 class ReverseReverbAudioProcessor : public juce::AudioProcessor
 {
@@ -34,25 +45,60 @@ public:
  void getStateInformation (juce::MemoryBlock& destData) override;
  void setStateInformation (const void* data, int sizeInBytes) override;
 
+ // Longest sample loadAudioFile() accepts. Renders past streamingThresholdSeconds play from disk
+ // (and sources whose reverb runs past it render out of core).
+ static constexpr double maxSampleSeconds = 120.0;
+ static constexpr double streamingThresholdSeconds = 20.0;
+
  // Custom methods for our plugin
- void loadAudioFile(const juce::File& file);
- void processReverseReverb();
- void triggerSample();
- bool isSampleLoaded() const { return processedSample.getNumSamples() > 0; }
+ void loadAudioFile(const juce::File& file); // Decodes on the loader thread, then renders
+ void loadImpulseResponse(const juce::File& file); // User IR for the convolution engine: decodes on the loader thread, then re-renders
+ void clearImpulseResponse(); // Back to the generated IR
+ void processReverseReverb(); // Queues a background re-render with the current settings, of the main sample and every bank slot following them (returns immediately)
+ RenderSettings getRenderSettings() const; // Snapshot of the parameters the render reads
+ void triggerSample(); // Safe from any thread - a new voice starts on the next audio block
+ bool isSampleLoaded() const;
+ bool hasAnythingToRender() const { return isSampleLoaded() || sampleBank.getNumLoadedSlots() > 0; } // A settings change re-renders something
  bool exportProcessedAudio(const juce::File& file);
- const juce::AudioBuffer<float>* getProcessedBuffer() const { return &processedSample; }
+ RenderedSample::Ptr getProcessedSample() const { return renderHandoff.getLatest(); }
+ void releaseRetiredRenders() { renderHandoff.collectGarbage(); fadeHandoff.collectGarbage(); sampleBank.collectGarbage(); } // Frees renders (and fade tables) the audio thread has let go of
+ FadeEnvelope::Ptr getFadeEnvelope() const { return fadeHandoff.getLatest(); } // Fade gains playback is using (may be null)
+
+ // Waveform overview of the current render with tremolo modulation applied, width columns (see WaveformSummary).
+ // Reads the render a block at a time - a streamed render is never copied into RAM.
+ void getDisplaySummaryWithTremolo(int width, std::vector<float>& mins, std::vector<float>& maxs) const;
+
+ // Background load state (for the editor)
+ bool isLoading() const { return sampleLoader.isLoading(); }
+ float getLoadProgress() const { return sampleLoader.getProgress(); }
+ juce::uint32 getLoadFailureCount() const { return sampleLoader.getFailureCount(); } // Bumped on every failed load
+ juce::String getLastLoadError() const { return sampleLoader.getLastError(); }
+
+ // Key-mapped sample bank: extra samples on their own key ranges. A slot renders with the main
+ // settings and follows them until it is given its own (a copy of the settings at that moment).
+ // The main sample plays on every other key.
+ SampleBank& getSampleBank() noexcept { return sampleBank; }
+ int loadBankFolder(const juce::File& folder, int firstNote = 36); // One slot per audio file, one key each from firstNote (C1) up; returns how many
+ void clearBank() { sampleBank.clearAll(); }
+ void setBankSlotOwnSettings(int slot) { sampleBank.setSlotSettings(slot, getRenderSettings()); } // The current settings become the slot's own
+ void setBankSlotFollowsMain(int slot, bool shouldFollow) { sampleBank.setSlotFollowsMain(slot, shouldFollow, getRenderSettings()); }
+ void setBankSlotKeyRange(int slot, int lowNote, int highNote) { sampleBank.setSlotKeyRange(slot, lowNote, highNote); }
+
+ // Background render state (for the editor)
+ bool isRendering() const { return renderWorker.isRendering(); }
+ float getRenderProgress() const { return renderWorker.getProgress(); }
+ double getLastRenderMilliseconds() const { return renderWorker.getLastRenderMilliseconds(); }
+ bool wasLastRenderCached() const { return renderWorker.wasLastRenderCached(); }
+ float getRenderCacheHitRate() const { return renderWorker.getCacheHitRate(); } // 0.0 to 1.0
+ void purgeDiskCaches() const { renderWorker.purgeDiskCache(); sampleLoader.purgeDiskCache(); } // Persisted renders and decodes
+ juce::uint32 getRenderedGeneration() const { return renderedGeneration.load(); } // Bumped on every published render
 
- // Generate a display buffer with tremolo modulation applied (for waveform visualization)
- void getDisplayBufferWithTremolo(juce::AudioBuffer<float>& displayBuffer) const;
+ // Audio-thread load per block, against the block's real-time budget (for the editor's CPU meter)
+ CpuLoadMeter& getCpuLoadMeter() noexcept { return cpuLoad; }
 
  // Playback state getters
  bool getIsPlaying() const { return isPlaying.load(); }
- float getPlaybackProgress() const
- {
-  if (!isPlaying.load() || processedSample.getNumSamples() == 0)
-   return 0.0f;
-  return (float)currentPlaybackPosition / (float)processedSample.getNumSamples();
- }
+ float getPlaybackProgress() const { return isPlaying.load() ? playbackProgress.load() : 0.0f; }
 
  // Parameter getters
  float getReverbSize() const { return reverbSize; }
@@ -66,7 +112,9 @@ public:
  float getStereoWidth() const { return stereoWidth; }
  float getLowCutFreq() const { return lowCutFreq; }
  bool getTransitionMode() const { return transitionMode; }
- juce::String getLoadedFileName() const { return loadedFileName; } // Get original file name
+ ReverbEngine getReverbEngine() const { return reverbEngine; }
+ juce::String getImpulseResponseName() const; // Empty when the IR is generated
+ juce::String getLoadedFileName() const; // Get original file name
  
  // Tremolo getters
  bool getTremoloEnabled() const { return tremoloEnabled; }
@@ -87,11 +135,12 @@ public:
  void setDryWet(float value) { dryWet = value; }
  void setTailDivision(int value) { tailDivision = juce::jlimit(0, 8, value); }
  void setManualBpm(float value) { manualBpm = juce::jlimit(20.0f, 300.0f, value); }
- void setFadeIn(float value) { fadeIn = value; }
- void setFadeOut(float value) { fadeOut = value; }
+ void setFadeIn(float value) { fadeIn = value; refreshFadeEnvelope(); }
+ void setFadeOut(float value) { fadeOut = value; refreshFadeEnvelope(); }
  void setStereoWidth(float value) { stereoWidth = value; }
  void setLowCutFreq(float value) { lowCutFreq = value; }
  void setTransitionMode(bool value) { transitionMode = value; }
+ void setReverbEngine(ReverbEngine value) { reverbEngine = value; }
  
  // Tremolo setters
  void setTremoloEnabled(bool value) { tremoloEnabled = value; }
@@ -110,18 +159,54 @@ public:
  juce::AudioFormatManager formatManager;
 
 private:
- // Audio buffers
- juce::AudioBuffer<float> originalSample;
- juce::AudioBuffer<float> processedSample;
- juce::AudioBuffer<float> reverbBuffer;
- 
- // Playback state
- int currentPlaybackPosition = 0;
- std::atomic<bool> isPlaying { false };
+ // Decoded source samples (swapped whole, never edited in place), guarded by sourceLock.
+ // The requested one is the newest load and is what every render request uses; it only
+ // becomes originalSample (with loadedFile) once its render is published.
+ SourceSample::Ptr originalSample;
+ SourceSample::Ptr requestedSample;
+ juce::File requestedFile;
+ juce::SpinLock sourceLock; // Never taken by the audio thread
+
+ // Finished renders are handed to the audio thread through an atomic pointer swap
+ RealtimeHandoff<RenderedSample> renderHandoff;
+ std::atomic<juce::uint32> renderedGeneration { 0 };
+
+ // Fade gain tables, rebuilt off the audio thread when the fades or the render length change
+ RealtimeHandoff<FadeEnvelope> fadeHandoff;
+ juce::CriticalSection fadeEnvelopeLock; // Serialises rebuilds from the editor and the render worker
+
+ // One pool for every render's parallel work - convolution, the forward pass and bank slot jobs
+ // (declared before everything that queues on it)
+ juce::ThreadPool renderPool { juce::jmax(1, juce::SystemStats::getNumCpus() - 1) };
+
+ // Long-lived render thread (declared after the handoff it publishes into)
+ RenderWorker renderWorker { renderPool, [this] (RenderedSample::Ptr rendered, const RenderWorker::Request& request) { return publishRender(rendered, request); } };
+
+ // Long-lived decode thread (declared after the render worker it hands sources to)
+ SampleLoader sampleLoader { formatManager, maxSampleSeconds,
+                             [this] (SourceSample::Ptr source, const juce::File& file, SampleLoader::Target target)
+                             {
+                              if (target == SampleLoader::Target::impulseResponse)
+                               publishImpulseResponse(source, file);
+                              else
+                               publishSource(source, file);
+                             } };
+
+ // Bank slots render on the shared render pool and publish through their own handoffs
+ SampleBank sampleBank { formatManager, renderPool, maxSampleSeconds, [this] (RenderedSample::Ptr rendered, const RenderSettings& settings) { return streamIfLong(rendered, settings.sampleRate); } };
+
+ // Keeps the pages of a streamed render resident ahead of every voice
+ RenderPrefetcher renderPrefetcher { renderHandoff, sampleBank };
+ juce::TimeSliceThread readAheadThread { "Render read-ahead" };
  
- // Reverb engine
- juce::Reverb reverb;
- juce::Reverb::Parameters reverbParams;
+ // Playback state (voices are owned by the audio thread)
+ VoicePool voices;
+ RenderedSample* playbackSample = nullptr; // Render the voice positions refer to
+ std::array<RenderedSample*, (size_t) SampleBank::maxSlots> bankPlaybackSamples {}; // Same, per bank slot
+ std::atomic<bool> isPlaying { false }; // Any voice active
+ std::atomic<float> playbackProgress { 0.0f };
+ std::atomic<bool> triggerRequested { false };
+ std::atomic<bool> stopRequested { false };
  
  // Parameters
  float reverbSize = 1.0f;
@@ -130,23 +215,16 @@ private:
  int tailDivision = 3;        // 0=8Bar,1=4Bar,2=2Bar,3=1Bar,4=1/2,5=1/4,6=1/8,7=1/16,8=1/32
  float manualBpm = 120.0f;    // Manual BPM for standalone mode
 
- // Beats per division (assumes 4/4 time)
- static constexpr float divisionBeats[9] = {
-     32.0f,   // 0: 8 Bar
-     16.0f,   // 1: 4 Bar
-     8.0f,    // 2: 2 Bar
-     4.0f,    // 3: 1 Bar
-     2.0f,    // 4: 1/2
-     1.0f,    // 5: 1/4
-     0.5f,    // 6: 1/8
-     0.25f,   // 7: 1/16
-     0.125f   // 8: 1/32
- };
  float fadeIn = 0.0f; // 0.0 to 0.5 (percentage)
  float fadeOut = 0.0f; // 0.0 to 0.5 (percentage)
  float stereoWidth = 0.5f; // 0.0 = mono, 0.5 = normal, 1.0 = max width
  float lowCutFreq = 20.0f; // 20Hz to 500Hz
  bool transitionMode = false;
+ ReverbEngine reverbEngine = ReverbEngine::freeverb;
+
+ // User impulse response for the convolution engine (null = generated from the tail length)
+ SourceSample::Ptr impulseResponse; // Guarded by sourceLock
+ juce::File impulseResponseFile;    // Guarded by sourceLock - saved with the state
  
  // Tremolo parameters
  bool tremoloEnabled = false;
@@ -161,16 +239,11 @@ private:
  int tremoloStartDivision = 5; // Start division (default 1/8)
  int tremoloEndDivision = 7; // End division (default 1/32)
  
- // Tremolo state
- float tremoloPhase = 0.0f;
- double lastPosInfo = -1.0;
- int tremoloSampleCounter = 0; // Track samples processed for Rate Ramp
+ // Audio thread: playback parameters (tremolo and transport included) for the current block
+ VoicePlayback::Settings blockPlayback;
  
- // Low cut filter coefficients
- float lowCutPrevInputL = 0.0f;
- float lowCutPrevInputR = 0.0f;
- float lowCutPrevOutputL = 0.0f;
- float lowCutPrevOutputR = 0.0f;
+ // Written by the audio thread only; read from anywhere
+ CpuLoadMeter cpuLoad;
  
  // Stereo delay buffers for width effect
  juce::AudioBuffer<float> delayBufferLeft;
@@ -180,11 +253,32 @@ private:
  // Sample rate
  double currentSampleRate = 44100.0;
  
- // Track original loaded file name for export naming
- juce::String loadedFileName = "";
+ // File the playing render was made from, for export naming
+ juce::File loadedFile; // Guarded by sourceLock
+
+ // Sample loader thread: makes a fully decoded source the requested one and queues its render
+ void publishSource(SourceSample::Ptr source, const juce::File& file);
+
+ // Sample loader thread: swaps in a decoded user IR and re-renders with it
+ void publishImpulseResponse(SourceSample::Ptr impulse, const juce::File& file);
  
- // Tremolo LFO calculation
- float calculateTremoloLFO();
+ // Render worker thread: spills long renders to a streamed temp file, then hands the render to the audio thread.
+ // Returns the render as published.
+ RenderedSample::Ptr publishRender(RenderedSample::Ptr rendered, const RenderWorker::Request& request);
+ RenderedSample::Ptr streamIfLong(RenderedSample::Ptr rendered, double sampleRate) const; // Moves long in-memory renders to a streamed temp file
+ static juce::File getScratchDirectory(); // Streamed and out-of-core render files
+
+ // Audio thread: start a new voice from the top of the current render (note -1 = play button).
+ // A note inside a bank slot's key range plays that slot instead of the main sample.
+ void startPlayback(int note, float velocity);
+
+ // Audio thread: a slot's render was swapped (-1 = the main sample) - keep its voices playing, scaled to the new length
+ void retargetVoices(int slot, const RenderedSample* oldRender, const RenderedSample* newRender);
+ const RenderedSample* getVoiceRender(const SampleVoice& voice) const noexcept { return voice.slot < 0 ? playbackSample : bankPlaybackSamples[(size_t) voice.slot]; }
+
+ // Non-realtime threads: the fade envelope for this render length (-1 = the latest render),
+ // rebuilt and published only if the fades or the length changed
+ FadeEnvelope::Ptr refreshFadeEnvelope(int renderLength = -1);
  
  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ReverseReverbAudioProcessor)
 };
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+
+// Lock-free handoff of immutable, reference-counted objects to the audio thread.
+//
+// - Any non-realtime thread calls publish() with a finished object.
+// - The audio thread calls acquire() once per block and gets the newest object.
+// - Objects the audio thread lets go of are parked in a lock-free FIFO and
+//   released by collectGarbage() on a non-realtime thread, so the audio thread
+//   never blocks, never races with a writer and never frees memory.
+template <typename ObjectType>
+class RealtimeHandoff
+{
+public:
+ using Ptr = juce::ReferenceCountedObjectPtr<ObjectType>;
+
+ RealtimeHandoff() = default;
+
+ ~RealtimeHandoff()
+ {
+  // The audio callback has stopped by the time the owner is destroyed
+  if (auto* p = pending.exchange (nullptr))
+   p->decReferenceCount();
+
+  if (current != nullptr)
+   current->decReferenceCount();
+
+  collectGarbage();
+ }
+
+ // Non-realtime threads: make a new object the one the audio thread plays next.
+ // Must not be null - publish an empty object to clear.
+ void publish (Ptr newObject)
+ {
+  jassert (newObject != nullptr);
+
+  {
+   const juce::SpinLock::ScopedLockType sl (latestLock);
+   latest = newObject;
+  }
+
+  // The pending slot owns one reference until the audio thread adopts it
+  newObject->incReferenceCount();
+  if (auto* superseded = pending.exchange (newObject.get(), std::memory_order_acq_rel))
+   superseded->decReferenceCount(); // never seen by the audio thread
+
+  collectGarbage();
+ }
+
+ // Non-realtime threads: the most recently published object (may be null)
+ Ptr getLatest() const
+ {
+  const juce::SpinLock::ScopedLockType sl (latestLock);
+  return latest;
+ }
+
+ // Audio thread only: adopt the newest published object, if any, and return
+ // the object to use for this block (may be null before the first publish).
+ ObjectType* acquire() noexcept
+ {
+  if (pending.load (std::memory_order_acquire) == nullptr)
+   return current;
+
+  // Keep the old object alive until there is room to retire it
+  if (current != nullptr && retired.getFreeSpace() == 0)
+   return current;
+
+  if (auto* incoming = pending.exchange (nullptr, std::memory_order_acq_rel))
+  {
+   if (current != nullptr)
+   {
+    const auto scope = retired.write (1);
+    if (scope.blockSize1 > 0) retiredSlots[(size_t) scope.startIndex1] = current;
+    else                      retiredSlots[(size_t) scope.startIndex2] = current;
+   }
+
+   current = incoming;
+  }
+
+  return current;
+ }
+
+ // Audio thread only: the object returned by the last acquire()
+ ObjectType* getCurrent() const noexcept { return current; }
+
+ // Non-realtime threads: release objects the audio thread has finished with
+ void collectGarbage()
+ {
+  const juce::SpinLock::ScopedLockType sl (collectLock);
+
+  const auto numReady = retired.getNumReady();
+  if (numReady == 0)
+   return;
+
+  const auto scope = retired.read (numReady);
+  for (int i = 0; i < scope.blockSize1; ++i)
+   retiredSlots[(size_t) (scope.startIndex1 + i)]->decReferenceCount();
+  for (int i = 0; i < scope.blockSize2; ++i)
+   retiredSlots[(size_t) (scope.startIndex2 + i)]->decReferenceCount();
+ }
+
+private:
+ static constexpr int retiredCapacity = 16;
+
+ std::atomic<ObjectType*> pending { nullptr }; // owns one reference
+ ObjectType* current = nullptr;                 // audio thread, owns one reference
+
+ juce::AbstractFifo retired { retiredCapacity };
+ std::array<ObjectType*, (size_t) retiredCapacity> retiredSlots {};
+ juce::SpinLock collectLock;
+
+ Ptr latest;
+ juce::SpinLock latestLock;
+
+ JUCE_DECLARE_NON_COPYABLE (RealtimeHandoff)
+};
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <tuple>
+#include <vector>
+#include "ReverseReverbRenderer.h"
+
+// Memory-budgeted LRU of finished renders, so A/B-ing settings (transition mode
+// on and off, two tail divisions, an undone width change) lands instantly
+// instead of re-rendering.
+//
+// Keyed by the source's content hash and every parameter the render reads.
+// The tail is keyed by its resolved length, which covers both the tail
+// division and the effective BPM. Entries are the renders as published, so a
+// streamed one costs its temp file rather than RAM. Either way the budget
+// counts the full sample size. Owned by the render worker thread; only the
+// hit counters are read from elsewhere.
+class RenderCache
+{
+public:
+ struct Key
+ {
+  juce::uint64 sourceHash = 0;
+  juce::uint64 impulseHash = 0; // 0 = generated IR (or Freeverb)
+  float reverbSize = 0.0f, reverbMix = 0.0f, tailSeconds = 0.0f, stereoWidth = 0.0f, lowCutFreq = 0.0f;
+  bool transitionMode = false;
+  double sampleRate = 0.0;
+  ReverbEngine engine = ReverbEngine::freeverb;
+
+  auto tie() const { return std::tie (sourceHash, impulseHash, reverbSize, reverbMix, tailSeconds, stereoWidth, lowCutFreq, transitionMode, sampleRate, engine); }
+  bool operator== (const Key& o) const { return tie() == o.tie(); }
+ };
+
+ static constexpr size_t defaultBudgetBytes = (size_t) 256 * 1024 * 1024;
+
+ explicit RenderCache (size_t budgetBytesToUse = defaultBudgetBytes) : budgetBytes (budgetBytesToUse) {}
+
+ static Key makeKey (const SourceSample& source, const RenderSettings& settings)
+ {
+  Key key;
+  key.sourceHash = source.getContentHash();
+  key.impulseHash = settings.engine == ReverbEngine::convolution && settings.impulseResponse != nullptr
+                      ? settings.impulseResponse->getContentHash() : 0;
+  key.reverbSize = settings.reverbSize;
+  key.reverbMix = settings.reverbMix;
+  key.tailSeconds = settings.tailSeconds;
+  key.stereoWidth = settings.stereoWidth;
+  key.lowCutFreq = settings.lowCutFreq;
+  key.transitionMode = settings.transitionMode;
+  key.sampleRate = settings.sampleRate;
+  key.engine = settings.engine;
+  return key;
+ }
+
+ // The render for this key (now the most recently used), or nullptr. Counts towards the hit rate.
+ RenderedSample::Ptr find (const Key& key)
+ {
+  ++lookups;
+
+  for (auto it = entries.begin(); it != entries.end(); ++it)
+  {
+   if (it->key == key)
+   {
+    auto render = it->render;
+    std::rotate (entries.begin(), it, it + 1); // Most recently used first
+    ++hits;
+    return render;
+   }
+  }
+
+  return nullptr;
+ }
+
+ // Adds (or refreshes) a finished render, then evicts least recently used entries down to the budget
+ void insert (const Key& key, RenderedSample::Ptr render)
+ {
+  if (render == nullptr || render->isEmpty() || getSizeInBytes (*render) > budgetBytes)
+   return;
+
+  entries.erase (std::remove_if (entries.begin(), entries.end(), [&key] (const Entry& e) { return e.key == key; }), entries.end());
+  entries.insert (entries.begin(), { key, render });
+
+  size_t total = 0;
+  for (size_t i = 0; i < entries.size(); ++i)
+  {
+   total += getSizeInBytes (*entries[i].render);
+   if (total > budgetBytes)
+   {
+    entries.resize (i); // Dropping the last references frees them (or deletes their temp files)
+    break;
+   }
+  }
+ }
+
+ void clear() { entries.clear(); }
+
+ // Any thread
+ float getHitRate() const noexcept
+ {
+  const auto total = lookups.load();
+  return total > 0 ? (float) hits.load() / (float) total : 0.0f;
+ }
+
+private:
+ struct Entry
+ {
+  Key key;
+  RenderedSample::Ptr render;
+ };
+
+ static size_t getSizeInBytes (const RenderedSample& render)
+ {
+  return (size_t) render.getNumChannels() * (size_t) render.getNumSamples() * sizeof (float);
+ }
+
+ const size_t budgetBytes;
+ std::vector<Entry> entries; // Most recently used first
+ std::atomic<juce::uint32> lookups { 0 }, hits { 0 };
+
+ JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderCache)
+};
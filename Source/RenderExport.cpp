@@ -0,0 +1,48 @@
+#include "RenderExport.h"
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <memory>
+
+bool RenderExport::writeWav (const juce::AudioBuffer<float>& render, const FadeEnvelope* fades, double sampleRate,
+                             const juce::File& file, int bitDepth)
+{
+ if (render.getNumSamples() == 0 || render.getNumChannels() == 0)
+  return false;
+
+ // Fades go on a copy - the render itself keeps playing unfaded through the voices' gain tables
+ juce::AudioBuffer<float> exportBuffer;
+ exportBuffer.makeCopyOf (render);
+
+ if (fades != nullptr)
+  fades->applyTo (exportBuffer);
+
+ if (file.exists())
+  file.deleteFile();
+
+ std::unique_ptr<juce::FileOutputStream> outputStream (file.createOutputStream());
+
+ if (outputStream == nullptr)
+ {
+  DBG ("Export: can't create " + file.getFullPathName());
+  return false;
+ }
+
+ juce::WavAudioFormat wavFormat;
+ std::unique_ptr<juce::AudioFormatWriter> writer (wavFormat.createWriterFor (outputStream.get(), sampleRate,
+                                                                            (unsigned int) exportBuffer.getNumChannels(),
+                                                                            bitDepth, {}, 0));
+ if (writer == nullptr)
+ {
+  DBG ("Export: can't create a WAV writer");
+  return false;
+ }
+
+ outputStream.release(); // The writer owns it now
+
+ if (! writer->writeFromAudioSampleBuffer (exportBuffer, 0, exportBuffer.getNumSamples()))
+ {
+  DBG ("Export: write failed");
+  return false;
+ }
+
+ return true;
+}
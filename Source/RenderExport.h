@@ -0,0 +1,14 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "FadeEnvelope.h"
+
+// Writes a finished render to disk the way the plugin exports it: the fade
+// tables playback reads applied to a copy, as a WAV file.
+class RenderExport
+{
+public:
+ // Replaces file. fades may be null (no fades). Returns false if nothing could be written.
+ static bool writeWav (const juce::AudioBuffer<float>& render, const FadeEnvelope* fades, double sampleRate,
+                       const juce::File& file, int bitDepth = 24);
+};
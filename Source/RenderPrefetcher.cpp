@@ -0,0 +1,138 @@
+#include "RenderPrefetcher.h"
+#include <algorithm>
+
+RenderPrefetcher::~RenderPrefetcher()
+{
+ // The read-ahead thread has been stopped by now
+ unlockAll();
+}
+
+int RenderPrefetcher::useTimeSlice()
+{
+ // Index 0 is the main render, slot i is index i + 1
+ std::array<RenderedSample::Ptr, 1 + SampleBank::maxSlots> renders;
+ bool anyStreamed = false;
+
+ for (int i = 0; i < (int) renders.size(); ++i)
+ {
+  auto render = i == 0 ? handoff.getLatest() : bank.getSlotRender (i - 1);
+  if (render != nullptr && render->isStreamed())
+  {
+   renders[(size_t) i] = std::move (render);
+   anyStreamed = true;
+  }
+ }
+
+ if (! anyStreamed)
+ {
+  unlockAll();
+  return 100;
+ }
+
+ const int readAhead = readAheadSamples.load();
+ PageRanges wanted;
+
+ auto want = [&wanted] (const RenderedSample& render, int startSample, int numSamples)
+ {
+  for (int channel = 0; channel < render.getNumChannels(); ++channel)
+  {
+   const auto pages = render.getPageRange (channel, startSample, numSamples);
+   if (! pages.isEmpty())
+    wanted.push_back (pages);
+  }
+ };
+
+ // A new note always starts from the top. A quarter of the window is plenty there:
+ // the next slice, a few ms later, pins the rest behind the voice's position.
+ for (auto& render : renders)
+  if (render != nullptr)
+   want (*render, 0, readAhead / 4);
+
+ for (auto& voicePosition : voicePositions)
+ {
+  const auto packed = voicePosition.load (std::memory_order_relaxed);
+  const int slot = (int) (packed >> 32) - 1;
+  const int position = (int) (juce::uint32) packed - 1;
+
+  if (position >= 0 && juce::isPositiveAndBelow (slot + 1, (int) renders.size()) && renders[(size_t) (slot + 1)] != nullptr)
+   want (*renders[(size_t) (slot + 1)], position, readAhead);
+ }
+
+ merge (wanted);
+
+ // Pin the new pages before letting go of the old ones, so a voice is never left uncovered
+ PageRanges failed;
+ for (auto& pages : subtract (wanted, lockedPages))
+ {
+  if (! RenderedSample::lockPages (pages))
+  {
+   RenderedSample::touchPages (pages);
+   failed.push_back (pages);
+  }
+ }
+
+ for (auto& pages : subtract (lockedPages, wanted))
+  RenderedSample::unlockPages (pages);
+
+ if (! failed.empty() && ! reportedLockFailure)
+ {
+  DBG ("Render read-ahead: can't pin streamed pages in RAM (memlock limit?) - touching them instead");
+  reportedLockFailure = true;
+ }
+
+ // Failed pages are retried next slice
+ lockedPages = subtract (wanted, failed);
+ lockedRenders.assign (renders.begin(), renders.end());
+
+ return 20; // ms - far shorter than the read-ahead window
+}
+
+void RenderPrefetcher::merge (PageRanges& ranges)
+{
+ std::sort (ranges.begin(), ranges.end(), [] (const auto& a, const auto& b) { return a.getStart() < b.getStart(); });
+
+ PageRanges merged;
+ for (auto& range : ranges)
+ {
+  if (! merged.empty() && range.getStart() <= merged.back().getEnd())
+   merged.back() = merged.back().getUnionWith (range);
+  else
+   merged.push_back (range);
+ }
+
+ ranges = std::move (merged);
+}
+
+RenderPrefetcher::PageRanges RenderPrefetcher::subtract (const PageRanges& ranges, const PageRanges& rangesToRemove)
+{
+ PageRanges result;
+ size_t next = 0; // First range to remove that could still overlap
+
+ for (auto range : ranges)
+ {
+  while (next < rangesToRemove.size() && rangesToRemove[next].getEnd() <= range.getStart())
+   ++next;
+
+  for (auto i = next; i < rangesToRemove.size() && rangesToRemove[i].getStart() < range.getEnd(); ++i)
+  {
+   if (rangesToRemove[i].getStart() > range.getStart())
+    result.push_back ({ range.getStart(), rangesToRemove[i].getStart() });
+
+   range.setStart (juce::jmin (range.getEnd(), rangesToRemove[i].getEnd()));
+  }
+
+  if (! range.isEmpty())
+   result.push_back (range);
+ }
+
+ return result;
+}
+
+void RenderPrefetcher::unlockAll()
+{
+ for (auto& pages : lockedPages)
+  RenderedSample::unlockPages (pages);
+
+ lockedPages.clear();
+ lockedRenders.clear();
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <vector>
+#include "RealtimeHandoff.h"
+#include "RenderedSample.h"
+#include "SampleBank.h"
+#include "VoicePool.h"
+
+// Read-ahead for streamed renders, run by a TimeSliceThread.
+//
+// The audio thread publishes each voice's slot and render position once per
+// block (one relaxed atomic store, position -1 for a free voice). Every slice this
+// client works out the window each voice will read next - the next couple of
+// seconds of the mapped file behind its position - plus the start of the main
+// render and of every bank slot's render for the next note-on, pins those pages
+// in RAM (RenderedSample::lockPages) and unpins the ones the voices have left
+// behind, so the audio thread never takes a page fault on a streamed render.
+// Where the memlock limit runs out the remaining pages are only touched.
+class RenderPrefetcher : public juce::TimeSliceClient
+{
+public:
+ RenderPrefetcher (const RealtimeHandoff<RenderedSample>& handoffToWatch, const SampleBank& bankToWatch)
+  : handoff (handoffToWatch), bank (bankToWatch)
+ {
+  for (auto& position : voicePositions)
+   position = pack (-1, -1);
+ }
+
+ // Audio thread: slot is the voice's bank slot (-1 for the main render), position -1 for a free voice
+ void setVoicePosition (int voiceIndex, int slot, int position) noexcept
+ {
+  voicePositions[(size_t) voiceIndex].store (pack (slot, position), std::memory_order_relaxed);
+ }
+
+ // Non-realtime: how far ahead of each position to keep pages resident
+ void setReadAheadSamples (int numSamples) noexcept { readAheadSamples = juce::jmax (1, numSamples); }
+
+ ~RenderPrefetcher() override;
+
+ int useTimeSlice() override;
+
+private:
+ using PageRanges = std::vector<juce::Range<juce::int64>>; // Sorted, disjoint, non-adjacent
+
+ static void merge (PageRanges& ranges);
+ static PageRanges subtract (const PageRanges& ranges, const PageRanges& rangesToRemove);
+ void unlockAll();
+
+ // Slot and position in one atomic, so the read-ahead thread never pairs one voice's slot with another's position
+ static juce::int64 pack (int slot, int position) noexcept
+ {
+  return (juce::int64) (((juce::uint64) (juce::uint32) (slot + 1) << 32) | (juce::uint32) (position + 1));
+ }
+
+ const RealtimeHandoff<RenderedSample>& handoff;
+ const SampleBank& bank;
+ std::array<std::atomic<juce::int64>, VoicePool::maxVoices> voicePositions;
+ std::atomic<int> readAheadSamples { 88200 };
+
+ // Read-ahead thread only: what is pinned now, and the renders it lies in (kept mapped until unpinned)
+ PageRanges lockedPages;
+ std::vector<RenderedSample::Ptr> lockedRenders;
+ bool reportedLockFailure = false;
+
+ JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderPrefetcher)
+};
@@ -0,0 +1,134 @@
+#include "RenderProfiler.h"
+
+std::atomic<bool> RenderProfiler::enabled { false };
+std::atomic<juce::uint64> RenderProfiler::nextIndex { 0 }, RenderProfiler::firstIndex { 0 };
+std::array<RenderProfiler::Slot, (size_t) RenderProfiler::capacity> RenderProfiler::slots;
+
+namespace
+{
+ // Thread names by thread index, for the trace's metadata events
+ juce::CriticalSection threadNamesLock;
+ juce::StringArray threadNames;
+}
+
+void RenderProfiler::clear() noexcept
+{
+ firstIndex.store (nextIndex.load (std::memory_order_acquire), std::memory_order_release);
+}
+
+void RenderProfiler::record (Event event) noexcept
+{
+ event.threadIndex = getThreadIndex();
+
+ const auto index = nextIndex.fetch_add (1, std::memory_order_relaxed);
+ auto& slot = slots[(size_t) (index % (juce::uint64) capacity)];
+
+ // Readers skip the slot until the new sequence number is in
+ slot.sequence.store (0, std::memory_order_relaxed);
+ std::atomic_thread_fence (std::memory_order_release);
+ slot.event = event;
+ slot.sequence.store (index + 1, std::memory_order_release);
+}
+
+int RenderProfiler::getThreadIndex()
+{
+ // Registered on a thread's first event - render threads only, never the audio thread
+ thread_local int threadIndex = -1;
+
+ if (threadIndex < 0)
+ {
+  auto* thread = juce::Thread::getCurrentThread();
+  const auto name = thread != nullptr ? thread->getThreadName() : juce::String ("Main thread");
+
+  const juce::ScopedLock sl (threadNamesLock);
+  threadIndex = threadNames.size();
+  threadNames.add (name);
+ }
+
+ return threadIndex;
+}
+
+std::vector<RenderProfiler::Event> RenderProfiler::getEvents()
+{
+ const auto end = nextIndex.load (std::memory_order_acquire);
+ const auto begin = juce::jmax (firstIndex.load (std::memory_order_acquire), end > (juce::uint64) capacity ? end - (juce::uint64) capacity : 0);
+
+ std::vector<Event> events;
+ events.reserve ((size_t) (end - begin));
+
+ for (auto index = begin; index < end; ++index)
+ {
+  auto& slot = slots[(size_t) (index % (juce::uint64) capacity)];
+
+  if (slot.sequence.load (std::memory_order_acquire) != index + 1)
+   continue; // Still being written, or already overwritten
+
+  const auto event = slot.event;
+  std::atomic_thread_fence (std::memory_order_acquire);
+
+  if (slot.sequence.load (std::memory_order_relaxed) == index + 1)
+   events.push_back (event);
+ }
+
+ return events;
+}
+
+juce::String RenderProfiler::toChromeTrace()
+{
+ const auto events = getEvents();
+ const double microsecondsPerTick = 1.0e6 / (double) juce::Time::getHighResolutionTicksPerSecond();
+
+ juce::int64 origin = 0;
+ for (size_t i = 0; i < events.size(); ++i)
+  origin = i == 0 ? events[i].startTicks : juce::jmin (origin, events[i].startTicks);
+
+ juce::Array<juce::var> traceEvents;
+ const int processId = 1;
+
+ {
+  const juce::ScopedLock sl (threadNamesLock);
+
+  for (int i = 0; i < threadNames.size(); ++i)
+  {
+   juce::DynamicObject::Ptr args = new juce::DynamicObject();
+   args->setProperty ("name", threadNames[i]);
+
+   juce::DynamicObject::Ptr metadata = new juce::DynamicObject();
+   metadata->setProperty ("name", "thread_name");
+   metadata->setProperty ("ph", "M");
+   metadata->setProperty ("pid", processId);
+   metadata->setProperty ("tid", i);
+   metadata->setProperty ("args", args.get());
+   traceEvents.add (metadata.get());
+  }
+ }
+
+ for (auto& event : events)
+ {
+  juce::DynamicObject::Ptr args = new juce::DynamicObject();
+  args->setProperty ("bytesTouched", event.bytesTouched);
+  args->setProperty ("bytesAllocated", event.bytesAllocated);
+
+  juce::DynamicObject::Ptr traceEvent = new juce::DynamicObject();
+  traceEvent->setProperty ("name", juce::String (event.name));
+  traceEvent->setProperty ("cat", "render");
+  traceEvent->setProperty ("ph", "X");
+  traceEvent->setProperty ("ts", (double) (event.startTicks - origin) * microsecondsPerTick);
+  traceEvent->setProperty ("dur", (double) event.durationTicks * microsecondsPerTick);
+  traceEvent->setProperty ("pid", processId);
+  traceEvent->setProperty ("tid", event.threadIndex);
+  traceEvent->setProperty ("args", args.get());
+  traceEvents.add (traceEvent.get());
+ }
+
+ juce::DynamicObject::Ptr trace = new juce::DynamicObject();
+ trace->setProperty ("traceEvents", traceEvents);
+ trace->setProperty ("displayTimeUnit", "ms");
+
+ return juce::JSON::toString (juce::var (trace.get()));
+}
+
+bool RenderProfiler::writeChromeTrace (const juce::File& file)
+{
+ return file.replaceWithText (toChromeTrace());
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <atomic>
+#include <vector>
+
+// Per-stage timings of offline renders, for finding where a render's time goes.
+//
+// Each stage of ReverseReverbRenderer opens a ScopedStage; when profiling is on,
+// the stage's duration, the audio bytes it read and wrote, and the bytes it
+// allocated for its buffers are filed into a process-wide ring of the last
+// capacity events. Any render thread can record: a slot is claimed with one
+// atomic increment and published with a sequence number, so writers never wait
+// on each other or on a reader, and a snapshot simply skips slots that are being
+// overwritten. When profiling is off a ScopedStage costs one relaxed load.
+//
+// The ring is dumped as Chrome trace-event JSON (chrome://tracing, Perfetto):
+// one complete ("X") event per stage, nested by time on each thread.
+class RenderProfiler
+{
+public:
+ static constexpr int capacity = 4096;
+
+ struct Event
+ {
+  const char* name = nullptr; // A string literal
+  juce::int64 startTicks = 0, durationTicks = 0; // High-resolution ticks
+  int threadIndex = 0; // Small per-thread number, in order of first event
+  juce::int64 bytesTouched = 0;   // Audio read plus written: each buffer counted once, however many passes
+  juce::int64 bytesAllocated = 0; // Buffer storage the stage (re)allocated
+ };
+
+ static void setEnabled (bool shouldBeEnabled) noexcept { enabled.store (shouldBeEnabled, std::memory_order_relaxed); }
+ static bool isEnabled() noexcept { return enabled.load (std::memory_order_relaxed); }
+
+ // Forgets every event recorded so far
+ static void clear() noexcept;
+
+ // The events still in the ring, oldest first
+ static std::vector<Event> getEvents();
+
+ // The ring as a Chrome trace: {"traceEvents": [...]}, times in microseconds
+ static juce::String toChromeTrace();
+ static bool writeChromeTrace (const juce::File& file);
+
+ // Bytes in every channel of a buffer
+ static juce::int64 getSizeInBytes (const juce::AudioBuffer<float>& buffer) noexcept
+ {
+  return (juce::int64) buffer.getNumChannels() * buffer.getNumSamples() * (juce::int64) sizeof (float);
+ }
+
+ // Times the enclosing scope as one stage. With a buffer to watch, a stage that
+ // leaves it in new storage counts the new size as allocated.
+ class ScopedStage
+ {
+ public:
+  explicit ScopedStage (const char* stageName, const juce::AudioBuffer<float>* bufferToWatch = nullptr) noexcept
+   : active (isEnabled())
+  {
+   if (! active)
+    return;
+
+   event.name = stageName;
+   watched = bufferToWatch;
+   watchedStorage = getStorage (watched);
+   event.startTicks = juce::Time::getHighResolutionTicks();
+  }
+
+  ~ScopedStage() noexcept
+  {
+   if (! active)
+    return;
+
+   event.durationTicks = juce::Time::getHighResolutionTicks() - event.startTicks;
+
+   if (watched != nullptr && getStorage (watched) != watchedStorage)
+    event.bytesAllocated += getSizeInBytes (*watched);
+
+   record (event);
+  }
+
+  void addBytesTouched (juce::int64 bytes) noexcept { event.bytesTouched += bytes; }
+  void addBytesAllocated (juce::int64 bytes) noexcept { event.bytesAllocated += bytes; }
+
+ private:
+  static const float* getStorage (const juce::AudioBuffer<float>* buffer) noexcept
+  {
+   return buffer != nullptr && buffer->getNumChannels() > 0 ? buffer->getReadPointer (0) : nullptr;
+  }
+
+  const bool active;
+  Event event;
+  const juce::AudioBuffer<float>* watched = nullptr;
+  const float* watchedStorage = nullptr;
+
+  JUCE_DECLARE_NON_COPYABLE (ScopedStage)
+ };
+
+private:
+ struct Slot
+ {
+  std::atomic<juce::uint64> sequence { 0 }; // Index + 1 of the event it holds, 0 while being written
+  Event event;
+ };
+
+ static void record (Event event) noexcept;
+ static int getThreadIndex();
+
+ static std::atomic<bool> enabled;
+ static std::atomic<juce::uint64> nextIndex, firstIndex;
+ static std::array<Slot, (size_t) capacity> slots;
+
+ RenderProfiler() = delete;
+};
@@ -0,0 +1,136 @@
+#include "RenderWorker.h"
+
+RenderWorker::RenderWorker(juce::ThreadPool& pool, CompletionCallback onRenderFinishedToUse)
+ : juce::Thread("ReverseReverb Render Worker"),
+ onRenderFinished(std::move(onRenderFinishedToUse)),
+ renderer(pool)
+{
+ startThread();
+}
+
+RenderWorker::~RenderWorker()
+{
+ cancelAll();
+ stopThread(4000);
+}
+
+void RenderWorker::requestRender(Request request)
+{
+ {
+ const juce::ScopedLock sl(requestLock);
+ pendingRequest = std::move(request);
+ hasPendingRequest = true;
+ ++latestGeneration; // Cancels the render in flight
+ }
+
+ notify();
+}
+
+void RenderWorker::cancelAll()
+{
+ const juce::ScopedLock sl(requestLock);
+ pendingRequest = {};
+ hasPendingRequest = false;
+ ++latestGeneration;
+}
+
+bool RenderWorker::isRequestPending() const
+{
+ const juce::ScopedLock sl(requestLock);
+ return hasPendingRequest;
+}
+
+void RenderWorker::run()
+{
+ while (!threadShouldExit())
+ {
+ Request request;
+ juce::uint32 generation = 0;
+
+ {
+ const juce::ScopedLock sl(requestLock);
+
+ if (hasPendingRequest)
+ {
+ request = std::move(pendingRequest);
+ pendingRequest = {};
+ generation = latestGeneration.load();
+ hasPendingRequest = false;
+ }
+ }
+
+ const auto& source = request.source;
+ const auto& settings = request.settings;
+
+ if (source == nullptr)
+ {
+ wait(-1); // Woken by requestRender() or stopThread()
+ continue;
+ }
+
+ const auto cacheKey = RenderCache::makeKey(*source, settings);
+
+ auto cached = cache.find(cacheKey);
+ if (cached != nullptr)
+ {
+ DBG("Render worker: cache hit");
+ lastRenderCached = true;
+
+ if (onRenderFinished != nullptr)
+ onRenderFinished(cached, request);
+
+ continue;
+ }
+
+ // Rendered in an earlier session (or by another instance)
+ cached = diskCache.find(cacheKey);
+ if (cached != nullptr)
+ {
+ DBG("Render worker: disk cache hit");
+ lastRenderCached = true;
+
+ if (onRenderFinished != nullptr)
+ cached = onRenderFinished(cached, request);
+
+ cache.insert(cacheKey, cached);
+ continue;
+ }
+
+ RenderControl control;
+ control.isCancelled = [this, generation]
+ {
+ return threadShouldExit() || latestGeneration.load() != generation;
+ };
+ control.reportProgress = [this](float value) { progress = value; };
+
+ progress = 0.0f;
+ rendering = true;
+ auto startTicks = juce::Time::getHighResolutionTicks();
+
+ // Sources render at the session rate; the cache key above stays on the file's own audio
+ auto sourceAtRate = source->getAtSampleRate(settings.sampleRate, control.isCancelled);
+ auto result = sourceAtRate != nullptr ? renderer.render(sourceAtRate, settings, control) : nullptr;
+
+ auto elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+ rendering = false;
+
+ if (result == nullptr || control.cancelled())
+ {
+ DBG("Render worker: render superseded after " << juce::String(elapsed * 1000.0, 1) << " ms");
+ continue;
+ }
+
+ lastRenderMilliseconds = elapsed * 1000.0;
+ lastRenderCached = false;
+ DBG("Render worker: render finished in " << juce::String(elapsed * 1000.0, 1) << " ms");
+
+ if (onRenderFinished != nullptr)
+ result = onRenderFinished(result, request);
+
+ cache.insert(cacheKey, result);
+
+ // Only settled renders go to disk - not every step of a slider drag
+ if (!isRequestPending())
+ diskCache.store(cacheKey, *result);
+ }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <functional>
+#include "ReverseReverbRenderer.h"
+#include "RenderCache.h"
+#include "PersistentRenderCache.h"
+
+// One long-lived background thread per processor that runs offline renders.
+//
+// Requests are coalesced: only the newest source + settings snapshot is kept,
+// and a render in flight is cancelled as soon as a newer request arrives, so
+// only the newest settings ever finish rendering. Settings that were rendered
+// recently come straight from the in-memory render cache, and renders from
+// earlier sessions from the persistent one on disk. Progress, latency and the
+// cache hit rate are exposed through atomics for the editor.
+class RenderWorker : private juce::Thread
+{
+public:
+ // A source, the file it was decoded from and the settings to render it with
+ struct Request
+ {
+  SourceSample::Ptr source;
+  juce::File sourceFile;
+  RenderSettings settings;
+ };
+
+ // Returns the render as it was published (possibly moved to a streamed copy) - that is what gets cached
+ using CompletionCallback = std::function<RenderedSample::Ptr(RenderedSample::Ptr, const Request&)>;
+
+ // onRenderFinished is called on the worker thread with every completed or cached render,
+ // and the request it was rendered for. Renders spread their parallel work over pool.
+ RenderWorker(juce::ThreadPool& pool, CompletionCallback onRenderFinished);
+ ~RenderWorker() override;
+
+ // Any thread: replace whatever is queued with this request and cancel the render in flight
+ void requestRender(Request request);
+
+ // Any thread: drop the queued request and cancel the render in flight
+ void cancelAll();
+
+ // Any thread: delete every render persisted on disk
+ void purgeDiskCache() const { diskCache.purge(); }
+
+ bool isRendering() const noexcept { return rendering.load(); }
+ float getProgress() const noexcept { return progress.load(); }
+ double getLastRenderMilliseconds() const noexcept { return lastRenderMilliseconds.load(); }
+ bool wasLastRenderCached() const noexcept { return lastRenderCached.load(); }
+ float getCacheHitRate() const noexcept { return cache.getHitRate(); }
+
+private:
+ void run() override;
+ bool isRequestPending() const;
+
+ CompletionCallback onRenderFinished;
+ ReverseReverbRenderer renderer;
+ RenderCache cache; // Worker thread only (apart from the hit rate)
+ PersistentRenderCache diskCache; // Worker thread only (apart from purging)
+
+ // Latest request - guarded by requestLock, never touched by the audio thread
+ juce::CriticalSection requestLock;
+ Request pendingRequest;
+ bool hasPendingRequest = false;
+
+ // Bumped for every request; a render whose generation is stale cancels itself
+ std::atomic<juce::uint32> latestGeneration { 0 };
+
+ std::atomic<bool> rendering { false };
+ std::atomic<float> progress { 0.0f };
+ std::atomic<double> lastRenderMilliseconds { 0.0 };
+ std::atomic<bool> lastRenderCached { false };
+
+ JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RenderWorker)
+};
@@ -0,0 +1,285 @@
+#include "RenderedSample.h"
+#include "ContentHash.h"
+#include "Resampler.h"
+#include <algorithm>
+
+#if ! JUCE_WINDOWS
+ #include <sys/mman.h>
+ #include <unistd.h>
+#endif
+
+namespace
+{
+ volatile char touchSink = 0; // Keeps the page-touching reads from being optimised away
+
+ juce::int64 getPageSize() noexcept
+ {
+ #if JUCE_WINDOWS
+  return 4096;
+ #else
+  static const auto pageSize = (juce::int64) juce::jmax (4096L, sysconf (_SC_PAGESIZE));
+  return pageSize;
+ #endif
+ }
+}
+
+RenderedSample::RenderedSample (std::unique_ptr<juce::MemoryMappedFile> mappedFile, const juce::File& file,
+                                float* const* channels, int numChannels, int numSamples)
+ : mapping (std::move (mappedFile)),
+   tempFile (file),
+   audio (channels, numChannels, numSamples) // Refers into the mapping - no copy
+{
+}
+
+RenderedSample::~RenderedSample()
+{
+ // Never runs on the audio thread (see RealtimeHandoff), so the file can go here
+ if (mapping != nullptr)
+ {
+  mapping.reset();
+
+  if (tempFile != juce::File())
+   tempFile.deleteFile();
+ }
+}
+
+RenderedSample::Ptr RenderedSample::createStreamed (const juce::AudioBuffer<float>& renderedAudio, const juce::File& tempFile)
+{
+ const int numChannels = renderedAudio.getNumChannels();
+ const int numSamples = renderedAudio.getNumSamples();
+
+ if (numChannels == 0 || numSamples == 0 || numChannels > 2)
+  return nullptr;
+
+ // Planar float32, one channel after the other, so each channel maps to one contiguous run
+ {
+  tempFile.deleteFile();
+  juce::FileOutputStream out (tempFile);
+
+  if (out.failedToOpen())
+  {
+   DBG ("Streamed render: can't create " << tempFile.getFullPathName());
+   return nullptr;
+  }
+
+  for (int channel = 0; channel < numChannels; ++channel)
+  {
+   if (! out.write (renderedAudio.getReadPointer (channel), (size_t) numSamples * sizeof (float)))
+   {
+    DBG ("Streamed render: write failed (disk full?)");
+    out.flush();
+    tempFile.deleteFile();
+    return nullptr;
+   }
+  }
+
+  out.flush();
+ }
+
+ auto mappedFile = mapPlanarFile (tempFile, numChannels, numSamples);
+ if (mappedFile == nullptr)
+ {
+  tempFile.deleteFile();
+  return nullptr;
+ }
+
+ return adoptPlanarFile (std::move (mappedFile), tempFile, numChannels, numSamples);
+}
+
+juce::File RenderedSample::getUniqueScratchFile (const juce::File& directory, const juce::String& prefix)
+{
+ return directory.getChildFile (prefix + "-" + juce::Uuid().toDashedString() + ".f32");
+}
+
+std::unique_ptr<juce::MemoryMappedFile> RenderedSample::createPlanarFile (const juce::File& file, int numChannels, int numSamples)
+{
+ if (numChannels <= 0 || numChannels > 2 || numSamples <= 0)
+  return nullptr;
+
+ // Real zeros rather than a sparse file, so a full disk fails here and not as a fault inside the mapping
+ {
+  file.deleteFile();
+  juce::FileOutputStream out (file);
+
+  if (out.failedToOpen())
+  {
+   DBG ("Planar render file: can't create " << file.getFullPathName());
+   return nullptr;
+  }
+
+  const std::vector<char> zeros (1 << 16, 0);
+  auto remaining = (juce::int64) numChannels * numSamples * (juce::int64) sizeof (float);
+
+  while (remaining > 0)
+  {
+   const auto count = (size_t) juce::jmin (remaining, (juce::int64) zeros.size());
+   if (! out.write (zeros.data(), count))
+   {
+    DBG ("Planar render file: write failed (disk full?)");
+    out.flush();
+    file.deleteFile();
+    return nullptr;
+   }
+
+   remaining -= (juce::int64) count;
+  }
+
+  out.flush();
+ }
+
+ auto mappedFile = mapPlanarFile (file, numChannels, numSamples);
+ if (mappedFile == nullptr)
+  file.deleteFile();
+
+ return mappedFile;
+}
+
+std::unique_ptr<juce::MemoryMappedFile> RenderedSample::mapPlanarFile (const juce::File& file, int numChannels, int numSamples)
+{
+ // Read-write mapping: out-of-core renders write through it, and AudioBuffer wants non-const channel pointers anyway
+ auto mappedFile = std::make_unique<juce::MemoryMappedFile> (file, juce::MemoryMappedFile::readWrite, false);
+ const auto expectedSize = (size_t) numChannels * (size_t) numSamples * sizeof (float);
+
+ if (mappedFile->getData() == nullptr || mappedFile->getSize() < expectedSize)
+ {
+  DBG ("Planar render file: can't map " << file.getFullPathName());
+  return nullptr;
+ }
+
+ return mappedFile;
+}
+
+float* RenderedSample::getPlanarChannel (const juce::MemoryMappedFile& mappedFile, int channel, int numSamples) noexcept
+{
+ return static_cast<float*> (mappedFile.getData()) + (size_t) channel * (size_t) numSamples;
+}
+
+RenderedSample::Ptr RenderedSample::adoptPlanarFile (std::unique_ptr<juce::MemoryMappedFile> mappedFile, const juce::File& file,
+                                                     int numChannels, int numSamples)
+{
+ jassert (mappedFile != nullptr && numChannels > 0 && numChannels <= 2);
+
+ float* channels[2] = { getPlanarChannel (*mappedFile, 0, numSamples),
+                        getPlanarChannel (*mappedFile, numChannels > 1 ? 1 : 0, numSamples) };
+
+ DBG ("Streamed render: " << numSamples << " samples mapped from " << file.getFileName());
+ return new RenderedSample (std::move (mappedFile), file, channels, numChannels, numSamples);
+}
+
+RenderedSample::Ptr RenderedSample::createMapped (std::unique_ptr<juce::MemoryMappedFile> mappedFile, float* const* channels,
+                                                  int numChannels, int numSamples)
+{
+ jassert (mappedFile != nullptr && numChannels > 0 && numChannels <= 2);
+ return new RenderedSample (std::move (mappedFile), juce::File(), channels, numChannels, numSamples);
+}
+
+juce::Range<juce::int64> RenderedSample::getPageRange (int channel, int startSample, int numSamples) const noexcept
+{
+ if (mapping == nullptr || ! juce::isPositiveAndBelow (channel, audio.getNumChannels()))
+  return {};
+
+ const int start = juce::jlimit (0, audio.getNumSamples(), startSample);
+ const int end = juce::jlimit (start, audio.getNumSamples(), startSample + numSamples);
+
+ if (end == start)
+  return {};
+
+ // Every page the samples touch, including partly covered ones at either end
+ const auto pageSize = getPageSize();
+ const auto first = (juce::int64) reinterpret_cast<juce::pointer_sized_uint> (audio.getReadPointer (channel, start));
+ const auto last = (juce::int64) reinterpret_cast<juce::pointer_sized_uint> (audio.getReadPointer (channel, end - 1));
+ return { first / pageSize, last / pageSize + 1 };
+}
+
+bool RenderedSample::lockPages (juce::Range<juce::int64> pages) noexcept
+{
+ if (pages.isEmpty())
+  return true;
+
+ #if JUCE_WINDOWS
+  return false; // VirtualLock is capped by the working set - Windows relies on touch()
+ #else
+  const auto pageSize = getPageSize();
+  return mlock (reinterpret_cast<void*> ((juce::pointer_sized_uint) (pages.getStart() * pageSize)),
+                (size_t) (pages.getLength() * pageSize)) == 0;
+ #endif
+}
+
+void RenderedSample::unlockPages (juce::Range<juce::int64> pages) noexcept
+{
+ if (pages.isEmpty())
+  return;
+
+ #if ! JUCE_WINDOWS
+  const auto pageSize = getPageSize();
+  munlock (reinterpret_cast<void*> ((juce::pointer_sized_uint) (pages.getStart() * pageSize)),
+           (size_t) (pages.getLength() * pageSize));
+ #endif
+}
+
+void RenderedSample::touchPages (juce::Range<juce::int64> pages) noexcept
+{
+ const auto pageSize = getPageSize();
+
+ // One read per page is enough to fault it in
+ char sink = 0;
+ for (auto page = pages.getStart(); page < pages.getEnd(); ++page)
+  sink = (char) (sink + *reinterpret_cast<const volatile char*> ((juce::pointer_sized_uint) (page * pageSize)));
+
+ touchSink = sink;
+}
+
+juce::uint64 SourceSample::getContentHash() const noexcept
+{
+ auto hash = contentHash.load();
+ if (hash != 0)
+  return hash;
+
+ // Two threads may both compute it - they get the same value
+ ContentHash content;
+ content.addValue (sampleRate);
+ content.addBuffer (audio);
+
+ hash = content.hash != 0 ? content.hash : 1;
+ contentHash = hash;
+ return hash;
+}
+
+SourceSample::Ptr SourceSample::getAtSampleRate (double targetRate, const std::function<bool()>& isCancelled)
+{
+ if (targetRate <= 0.0 || std::abs (targetRate - sampleRate) < 1.0e-6 || isEmpty())
+  return this;
+
+ {
+  const juce::ScopedLock sl (resampledLock);
+
+  for (auto it = resampled.begin(); it != resampled.end(); ++it)
+  {
+   if (std::abs ((*it)->getSampleRate() - targetRate) < 1.0e-6)
+   {
+    std::rotate (resampled.begin(), it, it + 1);
+    return resampled.front();
+   }
+  }
+ }
+
+ const auto startTime = juce::Time::getMillisecondCounterHiRes();
+ const Resampler resampler (sampleRate, targetRate);
+ juce::AudioBuffer<float> converted;
+
+ if (! resampler.process (audio, converted, isCancelled))
+  return nullptr;
+
+ DBG ("Source resampled " << sampleRate << " -> " << targetRate << " Hz in "
+      << juce::roundToInt (juce::Time::getMillisecondCounterHiRes() - startTime) << " ms");
+
+ Ptr result = new SourceSample (std::move (converted), targetRate);
+
+ const juce::ScopedLock sl (resampledLock);
+ resampled.insert (resampled.begin(), result);
+
+ if ((int) resampled.size() > maxResampledRates)
+  resampled.resize ((size_t) maxResampledRates);
+
+ return result;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+// A finished reverse-reverb render. Immutable once constructed, so the audio
+// thread, the editor and the exporter can all read it without locking while
+// the renderer prepares the next one.
+//
+// Long renders can be streamed: the audio is spilled to a planar float temp
+// file and memory-mapped, and getBuffer() refers straight into the mapping.
+// RAM then only holds the pages that were read recently (the OS can drop them
+// at any time), so pair a streamed render with a read-ahead thread that pins
+// the pages ahead of the playback positions with lockPages() (see RenderPrefetcher).
+// Where pages can't be pinned it falls back to touchPages(), which only makes them
+// resident for now - the audio thread can then still fault under memory pressure.
+class RenderedSample : public juce::ReferenceCountedObject
+{
+public:
+ using Ptr = juce::ReferenceCountedObjectPtr<RenderedSample>;
+
+ RenderedSample() = default;
+ explicit RenderedSample (juce::AudioBuffer<float>&& renderedAudio) : audio (std::move (renderedAudio)) {}
+ ~RenderedSample() override;
+
+ // Writes renderedAudio to tempFile and returns a render that streams from it,
+ // or nullptr if the file can't be written or mapped (keep the in-memory render then)
+ static Ptr createStreamed (const juce::AudioBuffer<float>& renderedAudio, const juce::File& tempFile);
+
+ // A fresh name for a temp file in directory ("<prefix>-<uuid>.f32"). The scratch directory is
+ // shared by every instance, bank slot and CLI job, and the files are only created later (and
+ // can take seconds to fill), so a name that is merely free now could be picked twice.
+ static juce::File getUniqueScratchFile (const juce::File& directory, const juce::String& prefix);
+
+ // Out-of-core renders write their output in place: createPlanarFile() makes a
+ // zero-filled planar float32 file of this size and maps it read-write (nullptr on
+ // failure), the renderer fills it through getPlanarChannel(), and adoptPlanarFile()
+ // turns the finished file into a streamed render that deletes it when released.
+ static std::unique_ptr<juce::MemoryMappedFile> createPlanarFile (const juce::File& file, int numChannels, int numSamples);
+ static float* getPlanarChannel (const juce::MemoryMappedFile& mappedFile, int channel, int numSamples) noexcept;
+ static Ptr adoptPlanarFile (std::unique_ptr<juce::MemoryMappedFile> mappedFile, const juce::File& file, int numChannels, int numSamples);
+
+ // A streamed render over a mapping someone else's file owns (a persistent cache entry) - the file is kept
+ static Ptr createMapped (std::unique_ptr<juce::MemoryMappedFile> mappedFile, float* const* channels, int numChannels, int numSamples);
+
+ const juce::AudioBuffer<float>& getBuffer() const noexcept { return audio; }
+ int getNumSamples() const noexcept { return audio.getNumSamples(); }
+ int getNumChannels() const noexcept { return audio.getNumChannels(); }
+ bool isEmpty() const noexcept { return audio.getNumSamples() == 0 || audio.getNumChannels() == 0; }
+ bool isStreamed() const noexcept { return mapping != nullptr; }
+
+ // Read-ahead thread: the system pages (absolute page numbers) that hold one channel's
+ // [startSample, startSample + numSamples), empty for in-memory renders. Windows are
+ // pinned and released as page ranges so that two windows sharing a page at their
+ // boundary can be tracked exactly - unlocking is not reference counted.
+ juce::Range<juce::int64> getPageRange (int channel, int startSample, int numSamples) const noexcept;
+
+ // Pins pages from getPageRange() in RAM so reading them never faults, until unlockPages()
+ // or until the render is released. False where it isn't supported or the memlock limit is
+ // reached - touch the range instead then.
+ static bool lockPages (juce::Range<juce::int64> pages) noexcept;
+ static void unlockPages (juce::Range<juce::int64> pages) noexcept;
+
+ // Faults pages from getPageRange() in, so they are resident for now (the OS may drop them again)
+ static void touchPages (juce::Range<juce::int64> pages) noexcept;
+
+private:
+ RenderedSample (std::unique_ptr<juce::MemoryMappedFile> mappedFile, const juce::File& file,
+                 float* const* channels, int numChannels, int numSamples);
+
+ static std::unique_ptr<juce::MemoryMappedFile> mapPlanarFile (const juce::File& file, int numChannels, int numSamples);
+
+ std::unique_ptr<juce::MemoryMappedFile> mapping; // Streamed renders only (declared before audio, which refers into it)
+ juce::File tempFile;                             // Deleted with the render (none for createMapped())
+ const juce::AudioBuffer<float> audio;
+
+ JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderedSample)
+};
+
+// A decoded source sample, shared read-only between the processor and the
+// render worker so a load never pulls audio out from under a running render.
+// Either owns its buffer or refers into a read-only mapping of a cached decode.
+class SourceSample : public juce::ReferenceCountedObject
+{
+public:
+ using Ptr = juce::ReferenceCountedObjectPtr<SourceSample>;
+
+ SourceSample (juce::AudioBuffer<float>&& decodedAudio, double fileSampleRate)
+  : audio (std::move (decodedAudio)), sampleRate (fileSampleRate) {}
+
+ // channels point into mappedFile, which the sample keeps open (see DecodedSampleCache)
+ SourceSample (std::unique_ptr<juce::MemoryMappedFile> mappedFile, float* const* channels,
+               int numChannels, int numSamples, double fileSampleRate)
+  : mapping (std::move (mappedFile)), audio (channels, numChannels, numSamples), sampleRate (fileSampleRate) {}
+
+ const juce::AudioBuffer<float>& getBuffer() const noexcept { return audio; }
+ double getSampleRate() const noexcept { return sampleRate; }
+ bool isEmpty() const noexcept { return audio.getNumSamples() == 0 || audio.getNumChannels() == 0; }
+ bool isMapped() const noexcept { return mapping != nullptr; }
+
+ // Identifies the audio itself (samples and rate), so equal sources reloaded twice
+ // share cache entries. Computed on first use, from any thread.
+ juce::uint64 getContentHash() const noexcept;
+
+ // This audio converted to targetRate (see Resampler), done once per rate and kept
+ // for the next render at that rate. Returns this sample at its own rate, nullptr
+ // if isCancelled() returned true. Render thread only - the conversion is slow.
+ Ptr getAtSampleRate (double targetRate, const std::function<bool()>& isCancelled = nullptr);
+
+private:
+ static constexpr int maxResampledRates = 2; // Hosts rarely switch between more than a couple
+
+ std::unique_ptr<juce::MemoryMappedFile> mapping; // Cached decodes only (declared before audio, which refers into it)
+ const juce::AudioBuffer<float> audio;
+ const double sampleRate;
+ mutable std::atomic<juce::uint64> contentHash { 0 }; // 0 = not computed yet
+
+ juce::CriticalSection resampledLock;
+ std::vector<Ptr> resampled; // Most recently used first
+
+ JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SourceSample)
+};
@@ -0,0 +1,121 @@
+#include "Resampler.h"
+#include <cmath>
+
+namespace
+{
+ // Zeroth-order modified Bessel function, for the Kaiser window
+ double besselI0 (double x)
+ {
+  double sum = 1.0, term = 1.0;
+  for (int k = 1; k < 32; ++k)
+  {
+   term *= (x / (2.0 * k)) * (x / (2.0 * k));
+   sum += term;
+  }
+
+  return sum;
+ }
+}
+
+Resampler::Resampler (double sourceRate, double targetRate)
+ : ratio (targetRate / sourceRate),
+   step (sourceRate / targetRate),
+   coefficients ((size_t) ((numPhases + 1) * numTaps)),
+   deltas ((size_t) (numPhases * numTaps))
+{
+ jassert (sourceRate > 0.0 && targetRate > 0.0);
+
+ // Cutoff as a fraction of the source Nyquist, a little under the lower of the two rates
+ const double cutoff = 0.95 * juce::jmin (1.0, ratio);
+ const double beta = 8.0;
+ const double windowNorm = besselI0 (beta);
+
+ // Row p is for an output p / numPhases past input sample i: tap j multiplies
+ // input i - halfTaps + 1 + j, which sits j - halfTaps + 1 - p / numPhases away
+ for (int p = 0; p <= numPhases; ++p)
+ {
+  const double frac = (double) p / numPhases;
+  float* row = coefficients.data() + (size_t) (p * numTaps);
+  double sum = 0.0;
+
+  for (int j = 0; j < numTaps; ++j)
+  {
+   const double distance = j - halfTaps + 1 - frac;
+   const double x = distance / halfTaps;
+   const double window = std::abs (x) < 1.0 ? besselI0 (beta * std::sqrt (1.0 - x * x)) / windowNorm : 0.0;
+   const double arg = juce::MathConstants<double>::pi * cutoff * distance;
+   const double sinc = std::abs (arg) < 1.0e-12 ? 1.0 : std::sin (arg) / arg;
+
+   row[j] = (float) (sinc * window);
+   sum += row[j];
+  }
+
+  // Unity gain at DC for every phase
+  for (int j = 0; j < numTaps; ++j)
+   row[j] = (float) (row[j] / sum);
+ }
+
+ for (int p = 0; p < numPhases; ++p)
+  for (int j = 0; j < numTaps; ++j)
+   deltas[(size_t) (p * numTaps + j)] = coefficients[(size_t) ((p + 1) * numTaps + j)] - coefficients[(size_t) (p * numTaps + j)];
+}
+
+int Resampler::getOutputLength (int numSamples) const noexcept
+{
+ return (int) std::ceil (numSamples * ratio);
+}
+
+bool Resampler::process (const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output,
+                         const std::function<bool()>& isCancelled) const
+{
+ const int numSamples = input.getNumSamples();
+ const int outputLength = getOutputLength (numSamples);
+ output.setSize (input.getNumChannels(), outputLength, false, false, true);
+
+ // Zeros either side, so no tap ever needs a bounds check
+ std::vector<float> padded ((size_t) (numSamples + 2 * numTaps), 0.0f);
+ const int chunkSize = 65536;
+
+ for (int channel = 0; channel < input.getNumChannels(); ++channel)
+ {
+  std::copy (input.getReadPointer (channel), input.getReadPointer (channel) + numSamples, padded.begin() + numTaps);
+
+  for (int begin = 0; begin < outputLength; begin += chunkSize)
+  {
+   if (isCancelled != nullptr && isCancelled())
+    return false;
+
+   processChannel (padded.data() + numTaps, output.getWritePointer (channel), begin, juce::jmin (outputLength, begin + chunkSize));
+  }
+ }
+
+ return true;
+}
+
+void Resampler::processChannel (const float* input, float* output, int begin, int end) const noexcept
+{
+ for (int n = begin; n < end; ++n)
+ {
+  const double position = n * step;
+  const int base = (int) position;
+  const double phase = (position - base) * numPhases;
+  const int row = juce::jmin (numPhases - 1, (int) phase);
+  const float blend = (float) (phase - row);
+
+  const float* x = input + base - halfTaps + 1;
+  const float* h = coefficients.data() + (size_t) (row * numTaps);
+  const float* dh = deltas.data() + (size_t) (row * numTaps);
+
+  // Independent lane sums, so vectorising needs no reassociation
+  float lanes[numLanes] = {};
+  for (int j = 0; j < numTaps; j += numLanes)
+   for (int k = 0; k < numLanes; ++k)
+    lanes[k] += x[j + k] * (h[j + k] + blend * dh[j + k]);
+
+  float sum = 0.0f;
+  for (float lane : lanes)
+   sum += lane;
+
+  output[n] = sum;
+ }
+}
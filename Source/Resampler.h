@@ -0,0 +1,47 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <functional>
+#include <vector>
+
+// Offline sample-rate conversion for sources whose file rate differs from the
+// session rate.
+//
+// Polyphase windowed sinc: 64 taps (Kaiser window, beta 8) tabulated at 512
+// fractional positions, with linear interpolation between neighbouring phases
+// so any ratio works. When downsampling the cutoff follows the target's Nyquist
+// frequency, so nothing folds back. Each tap row is stored next to its
+// difference to the following phase, so one output sample is a single pass over
+// 64 contiguous inputs and coefficients, summed in independent lanes the
+// compiler turns into SIMD multiply-adds.
+class Resampler
+{
+public:
+ Resampler (double sourceRate, double targetRate);
+
+ double getRatio() const noexcept { return ratio; }
+
+ // Length of the converted signal for an input of numSamples
+ int getOutputLength (int numSamples) const noexcept;
+
+ // Converts every channel of input. Returns false if isCancelled() returned true
+ // part way (output is then incomplete).
+ bool process (const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output,
+               const std::function<bool()>& isCancelled = nullptr) const;
+
+private:
+ static constexpr int numTaps = 64;
+ static constexpr int halfTaps = numTaps / 2;
+ static constexpr int numPhases = 512;
+ static constexpr int numLanes = 8;
+
+ void processChannel (const float* input, float* output, int begin, int end) const noexcept;
+
+ const double ratio; // Output samples per input sample
+ const double step;  // Input samples per output sample
+
+ // numPhases + 1 rows of numTaps coefficients, and numPhases rows of (next row - row)
+ std::vector<float> coefficients, deltas;
+
+ JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Resampler)
+};
@@ -0,0 +1,1139 @@
+#include "ReverseReverbRenderer.h"
+#include "VectorReverb.h"
+#include "RenderProfiler.h"
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <optional>
+
+namespace
+{
+ // Wet gain both engines share
+ float wetLevelFor(const RenderSettings& settings)
+ {
+ return juce::jlimit(0.0f, 1.0f, settings.reverbMix) * 0.7f;
+ }
+
+ // Reverb parameters shared by the reversed and the forward pass.
+ // Both passes run at full width - width is applied afterwards by mixWetWidth(), which
+ // reproduces juce::Reverb's own wet1/wet2 mix exactly, so a width change never reruns a reverb.
+ VectorReverb::Parameters makeReverbParameters(const RenderSettings& settings)
+ {
+ float normalizedFeedback = juce::jlimit(0.0f, 1.0f, settings.tailSeconds / 10.0f);
+
+ VectorReverb::Parameters params;
+
+ // Adjust room size based on tail duration - longer tail = larger room
+ params.roomSize = juce::jlimit(0.0f, 1.0f, settings.reverbSize + (normalizedFeedback * 0.3f));
+ params.damping = juce::jlimit(0.1f, 0.9f, 0.5f - (normalizedFeedback * 0.3f));
+ params.wetLevel = wetLevelFor(settings);
+ params.dryLevel = 0.0f;
+ params.width = 1.0f;
+ params.freezeMode = 0.0f;
+ return params;
+ }
+
+ // The wet-channel mix juce::Reverb applies for a given width, on a full-width render.
+ // right is null for a mono render.
+ void mixWetWidth(float* left, float* right, int numSamples, float width)
+ {
+ const float wet1 = 0.5f * (1.0f + width);
+ const float wet2 = 0.5f * (1.0f - width);
+
+ if (right == nullptr)
+ {
+ // processMono() only uses wet1
+ juce::FloatVectorOperations::multiply(left, wet1, numSamples);
+ return;
+ }
+
+ for (int i = 0; i < numSamples; ++i)
+ {
+ const float l = left[i];
+ const float r = right[i];
+ left[i] = l * wet1 + r * wet2;
+ right[i] = r * wet1 + l * wet2;
+ }
+ }
+
+ void mixWetWidth(juce::AudioBuffer<float>& buffer, float width)
+ {
+ mixWetWidth(buffer.getWritePointer(0), buffer.getNumChannels() > 1 ? buffer.getWritePointer(1) : nullptr,
+ buffer.getNumSamples(), width);
+ }
+
+ // Width and cleanup after the reversed reverb: the wet width mix, then narrowing towards
+ // mono or a Haas delay on the right channel, then soft clipping. Keeps its delay line
+ // between calls, so a render can be fed whole or in consecutive chunks with the same result.
+ class WidthProcessor
+ {
+ public:
+ WidthProcessor(float widthToUse, double sampleRate) : width(widthToUse)
+ {
+ if (width > 0.5f)
+ {
+ // Calculate delay time based on width (0-20ms range)
+ const float delayMs = (width - 0.5f) * 40.0f;
+ const int delaySamples = (int)(delayMs * 0.001f * sampleRate);
+
+ if (delaySamples > 0 && delaySamples < 2000) // Max 2000 samples
+ delayLine.assign((size_t) delaySamples, 0.0f);
+ }
+ }
+
+ // right is null for a mono render (width mix and cleanup only)
+ void process(float* left, float* right, int numSamples)
+ {
+ applyWidth(left, right, numSamples);
+ cleanUp(left, right, numSamples);
+ }
+
+ // The width mix, then narrowing or the Haas delay
+ void applyWidth(float* left, float* right, int numSamples)
+ {
+ mixWetWidth(left, right, numSamples, width);
+
+ if (right != nullptr && width < 0.5f)
+ narrow(left, right, numSamples);
+ else if (right != nullptr && ! delayLine.empty())
+ widen(left, right, numSamples);
+ }
+
+ // Soft clipping and denormal removal
+ static void cleanUp(float* left, float* right, int numSamples)
+ {
+ cleanUpChannel(left, numSamples);
+ if (right != nullptr)
+ cleanUpChannel(right, numSamples);
+ }
+
+ private:
+ // Narrowing: move towards mono
+ void narrow(float* left, float* right, int numSamples) const
+ {
+ const float monoAmount = 1.0f - (width * 2.0f);
+
+ for (int i = 0; i < numSamples; ++i)
+ {
+ const float mono = (left[i] + right[i]) * 0.5f;
+ left[i] = left[i] * (1.0f - monoAmount) + mono * monoAmount;
+ right[i] = right[i] * (1.0f - monoAmount) + mono * monoAmount;
+ }
+ }
+
+ // Widening: delay the right channel slightly (Haas effect), plus some subtle cross-feed.
+ // The first delay's worth of samples stays undelayed, as it always has.
+ void widen(float* left, float* right, int numSamples)
+ {
+ const float crossfeed = 0.15f;
+ const int delaySamples = (int) delayLine.size();
+
+ for (int i = 0; i < numSamples; ++i)
+ {
+ const float input = right[i];
+ const float delayed = primed ? delayLine[(size_t) delayPosition] : input;
+
+ delayLine[(size_t) delayPosition] = input;
+ if (++delayPosition == delaySamples)
+ {
+ delayPosition = 0;
+ primed = true;
+ }
+
+ const float l = left[i];
+ left[i] = l - (delayed * crossfeed);
+ right[i] = delayed - (l * crossfeed);
+ }
+ }
+
+ static void cleanUpChannel(float* data, int numSamples)
+ {
+ for (int i = 0; i < numSamples; ++i)
+ {
+ float sample = data[i];
+
+ // Soft clip to prevent harsh distortion
+ if (sample > 0.95f)
+ sample = 0.95f + 0.05f * std::tanh((sample - 0.95f) / 0.05f);
+ else if (sample < -0.95f)
+ sample = -0.95f + 0.05f * std::tanh((sample + 0.95f) / 0.05f);
+
+ // Remove denormals
+ if (std::abs(sample) < 1e-10f)
+ sample = 0.0f;
+
+ data[i] = sample;
+ }
+ }
+
+ const float width;
+ std::vector<float> delayLine; // Empty unless widening
+ int delayPosition = 0;
+ bool primed = false;
+ };
+
+ // Either engine as a stream of consecutive chunks, for out-of-core renders.
+ // Chunks must be whole convolver blocks, except the last one.
+ class StreamingReverb
+ {
+ public:
+ StreamingReverb(const RenderSettings& settings, const PartitionedConvolver& convolver, int numChannelsToUse)
+ : numChannels(numChannelsToUse)
+ {
+ if (settings.engine == ReverbEngine::convolution)
+ {
+ convolution = std::make_unique<PartitionedConvolver::Stream>(convolver, numChannels);
+ }
+ else
+ {
+ reverb.setSampleRate(settings.sampleRate);
+ reverb.setParameters(makeReverbParameters(settings));
+ }
+ }
+
+ void process(float* const* channels, int numSamples)
+ {
+ if (convolution != nullptr)
+ convolution->process(channels, numChannels, numSamples);
+ else if (numChannels == 1)
+ reverb.processMono(channels[0], numSamples);
+ else
+ reverb.processStereo(channels[0], channels[1], numSamples);
+ }
+
+ private:
+ const int numChannels;
+ VectorReverb reverb;
+ std::unique_ptr<PartitionedConvolver::Stream> convolution;
+
+ JUCE_DECLARE_NON_COPYABLE(StreamingReverb)
+ };
+
+ // Deletes a scratch file on the way out unless release() handed it on
+ class ScopedTempFile
+ {
+ public:
+ explicit ScopedTempFile(const juce::File& fileToOwn) : file(fileToOwn) {}
+ ~ScopedTempFile() { if (owned) file.deleteFile(); }
+
+ const juce::File& get() const noexcept { return file; }
+ juce::File release() noexcept { owned = false; return file; }
+
+ private:
+ const juce::File file;
+ bool owned = true;
+
+ JUCE_DECLARE_NON_COPYABLE(ScopedTempFile)
+ };
+
+ // Stereo exponentially-decaying noise that reaches -60dB exactly at the tail length.
+ // Seeded, so the same settings always give the same IR.
+ juce::AudioBuffer<float> generateImpulseResponse(const RenderSettings& settings)
+ {
+ const double sampleRate = settings.sampleRate;
+ const int length = juce::jmax(1, (int)(settings.tailSeconds * sampleRate));
+
+ // Bigger room = later first reflections (0-30ms)
+ const int preDelay = juce::jmin(length - 1, (int)(juce::jlimit(0.0f, 1.0f, settings.reverbSize) * 0.03 * sampleRate));
+
+ // Same damping mapping as the Freeverb engine - longer tails ring brighter
+ float normalizedFeedback = juce::jlimit(0.0f, 1.0f, settings.tailSeconds / 10.0f);
+ float damping = juce::jlimit(0.1f, 0.9f, 0.5f - (normalizedFeedback * 0.3f));
+
+ // -60dB over the whole IR: 10^(-3 * t / T)
+ const double decayPerSample = std::pow(10.0, -3.0 / (double) length);
+
+ juce::AudioBuffer<float> impulseResponse(2, length);
+ impulseResponse.clear();
+
+ for (int channel = 0; channel < 2; ++channel)
+ {
+ juce::Random random(0x5eed + channel); // Decorrelated left/right
+ auto* data = impulseResponse.getWritePointer(channel);
+ double envelope = std::pow(decayPerSample, (double) preDelay);
+ float lowPass = 0.0f;
+
+ for (int i = preDelay; i < length; ++i)
+ {
+ float noise = random.nextFloat() * 2.0f - 1.0f;
+ lowPass += (1.0f - damping) * (noise - lowPass);
+ data[i] = lowPass * (float) envelope;
+ envelope *= decayPerSample;
+ }
+ }
+
+ return impulseResponse;
+ }
+
+ // A user IR at the render sample rate, cut at the tail length with a short fade-out
+ juce::AudioBuffer<float> prepareUserImpulseResponse(const SourceSample& impulseResponse, const RenderSettings& settings)
+ {
+ const auto& source = impulseResponse.getBuffer();
+ const double ratio = impulseResponse.getSampleRate() / settings.sampleRate;
+ const int resampledLength = juce::jmax(1, (int) std::ceil(source.getNumSamples() / ratio));
+ const int length = juce::jmin(resampledLength, juce::jmax(1, (int)(settings.tailSeconds * settings.sampleRate)));
+
+ juce::AudioBuffer<float> result(source.getNumChannels(), length);
+
+ if (std::abs(ratio - 1.0) < 1.0e-9)
+ {
+ for (int channel = 0; channel < source.getNumChannels(); ++channel)
+ result.copyFrom(channel, 0, source, channel, 0, length);
+ }
+ else
+ {
+ // Zero padding so the interpolator never reads past the end of the IR
+ juce::AudioBuffer<float> padded(source.getNumChannels(), source.getNumSamples() + 16);
+ padded.clear();
+
+ for (int channel = 0; channel < source.getNumChannels(); ++channel)
+ {
+ padded.copyFrom(channel, 0, source, channel, 0, source.getNumSamples());
+
+ juce::LagrangeInterpolator interpolator;
+ interpolator.process(ratio, padded.getReadPointer(channel), result.getWritePointer(channel), length);
+ }
+ }
+
+ const int fadeLength = juce::jmin(length, (int)(0.01 * settings.sampleRate));
+ if (length < resampledLength && fadeLength > 0)
+ result.applyGainRamp(length - fadeLength, fadeLength, 1.0f, 0.0f);
+
+ return result;
+ }
+
+ // Stereo reverb in small chunks, checking for cancellation between chunks
+ bool processStereoInChunks(VectorReverb& reverb, juce::AudioBuffer<float>& buffer,
+ const RenderControl& control, float progressStart, float progressEnd)
+ {
+ const int chunkSize = 512;
+
+ for (int pos = 0; pos < buffer.getNumSamples(); pos += chunkSize)
+ {
+ if (control.cancelled())
+ return false;
+
+ control.progress(progressStart + (progressEnd - progressStart) * (float)pos / (float)buffer.getNumSamples());
+
+ int samplesToProcess = juce::jmin(chunkSize, buffer.getNumSamples() - pos);
+ reverb.processStereo(buffer.getWritePointer(0) + pos,
+ buffer.getWritePointer(1) + pos,
+ samplesToProcess);
+ }
+
+ return true;
+ }
+
+ // One render pass running on the pool. The destructor waits for it, so the pass can
+ // never outlive the stages or the stack frame it uses - even if the caller throws.
+ class BackgroundPass
+ {
+ public:
+ BackgroundPass() = default;
+ ~BackgroundPass() { if (started) done.wait(-1); }
+
+ void start(juce::ThreadPool& pool, std::function<bool()> pass)
+ {
+ started = true;
+ pool.addJob([this, pass]
+ {
+ try { succeeded = pass(); }
+ catch (...) { error = std::current_exception(); }
+
+ done.signal();
+ });
+ }
+
+ bool isStarted() const noexcept { return started; }
+
+ // Waits for the pass and returns its result, rethrowing anything it threw
+ bool finish()
+ {
+ done.wait(-1);
+ started = false;
+
+ if (error != nullptr)
+ std::rethrow_exception(error);
+
+ return succeeded;
+ }
+
+ private:
+ juce::WaitableEvent done;
+ std::exception_ptr error;
+ bool succeeded = false, started = false;
+
+ JUCE_DECLARE_NON_COPYABLE(BackgroundPass)
+ };
+}
+
+void ReverseReverbRenderer::clearCache()
+{
+ cachedSource = nullptr;
+ cachedImpulseResponse = nullptr;
+ impulseStage.invalidate();
+ convolver.reset();
+ inputStage.invalidate();
+ reverbStage.invalidate();
+ widthStage.invalidate();
+ forwardStage.invalidate();
+ arrangeStage.invalidate();
+ lowCutStage.invalidate();
+}
+
+float RenderSettings::getTailSeconds(int tailDivision, double bpm)
+{
+ // Beats per division
+ static constexpr float divisionBeats[9] = {
+     32.0f,   // 0: 8 Bar
+     16.0f,   // 1: 4 Bar
+     8.0f,    // 2: 2 Bar
+     4.0f,    // 3: 1 Bar
+     2.0f,    // 4: 1/2
+     1.0f,    // 5: 1/4
+     0.5f,    // 6: 1/8
+     0.25f,   // 7: 1/16
+     0.125f   // 8: 1/32
+ };
+
+ if (bpm <= 0.0) bpm = 120.0;
+ float beats = divisionBeats[juce::jlimit(0, 8, tailDivision)];
+ return (float)((60.0 / bpm) * (double)beats);
+}
+
+RenderedSample::Ptr ReverseReverbRenderer::render(SourceSample::Ptr source,
+ const RenderSettings& settings,
+ const RenderControl& control)
+{
+ if (source == nullptr || source->isEmpty())
+ return new RenderedSample();
+
+ const RenderProfiler::ScopedStage renderStage("Render");
+
+ try
+ {
+ if (source != cachedSource)
+ {
+ // Everything but the impulse response depends on the source
+ inputStage.invalidate();
+ reverbStage.invalidate();
+ widthStage.invalidate();
+ forwardStage.invalidate();
+ arrangeStage.invalidate();
+ lowCutStage.invalidate();
+ cachedSource = source;
+ }
+
+ if (settings.engine == ReverbEngine::convolution && ! computeImpulse(settings))
+ return nullptr;
+
+ if (shouldRenderOutOfCore(*source, settings))
+ {
+ auto rendered = renderOutOfCore(*source, settings, control);
+ if (rendered == nullptr || ! rendered->isEmpty())
+ return rendered;
+
+ DBG("Out-of-core render: no scratch space, rendering in memory");
+ }
+
+ if (! computeInput(*source, settings) || control.cancelled())
+ return nullptr;
+
+ control.progress(0.1f);
+
+ // Transition mode: the forward pass only reads the source, so with Freeverb it runs on
+ // the render pool (its own reverb instance, its own stage) while this thread does the
+ // reversed pass. The convolution engine already spreads each pass over the pool.
+ // Renders that already run on the pool do the passes one after the other.
+ BackgroundPass forwardPass;
+ if (settings.transitionMode && settings.engine == ReverbEngine::freeverb && ! rendersOnPool)
+ {
+ RenderControl forwardControl;
+ forwardControl.isCancelled = control.isCancelled; // Progress follows the reversed pass only
+
+ forwardPass.start(renderPool, [this, source, settings, forwardControl]
+ {
+ return computeForward(*source, settings, forwardControl);
+ });
+ }
+
+ if (! computeReverb(settings, control) || control.cancelled())
+ return nullptr;
+
+ control.progress(0.6f);
+
+ computeWidth(settings);
+
+ if (settings.transitionMode)
+ {
+ // Crossfade merge only once both passes are done
+ const bool forwardDone = forwardPass.isStarted() ? forwardPass.finish()
+ : computeForward(*source, settings, control);
+ if (! forwardDone)
+ return nullptr;
+ }
+
+ if (control.cancelled())
+ return nullptr;
+
+ control.progress(0.85f);
+
+ computeArrange(settings);
+ computeLowCut(settings);
+
+ // Step 7: Final gentle normalization to -3dB
+ // Cheap, so it always runs on a fresh copy - the cached stages stay untouched
+ RenderProfiler::ScopedStage normalizeStage("Final normalize");
+ juce::AudioBuffer<float> processedSample;
+ processedSample.makeCopyOf(lowCutStage.output);
+
+ normalizeStage.addBytesTouched(2 * RenderProfiler::getSizeInBytes(processedSample));
+ normalizeStage.addBytesAllocated(RenderProfiler::getSizeInBytes(processedSample));
+
+ float maxLevel = processedSample.getMagnitude(0, processedSample.getNumSamples());
+
+ // Normalize to -3dB (0.707) instead of 0dB to prevent clipping
+ if (maxLevel > 0.001f)
+ {
+ float targetLevel = 0.707f; // -3dB
+ float scaleFactor = targetLevel / maxLevel;
+ processedSample.applyGain(scaleFactor); // Apply to all channels at once
+ }
+
+ // Note: Fades are NOT applied here - they're applied during playback/export only
+ // This keeps the processed buffer "clean" for fade adjustments
+
+ control.progress(1.0f);
+
+ return new RenderedSample(std::move(processedSample));
+ }
+ catch (const std::bad_alloc& e)
+ {
+ DBG("Memory allocation failed in ReverseReverbRenderer::render: " << e.what());
+ }
+ catch (const std::exception& e)
+ {
+ DBG("Exception in ReverseReverbRenderer::render: " << e.what());
+ }
+ catch (...)
+ {
+ DBG("Unknown exception in ReverseReverbRenderer::render");
+ }
+
+ // Failed renders clear the output (and the cache, which may be half-written)
+ clearCache();
+ return new RenderedSample();
+}
+
+bool ReverseReverbRenderer::computeInput(const SourceSample& source, const RenderSettings& settings)
+{
+ const InputKey key { &source, settings.tailSeconds, settings.sampleRate };
+ if (inputStage.isUpToDate(key))
+ return true;
+
+ inputStage.invalidate();
+ auto& reverbBuffer = inputStage.output;
+ const auto& originalSample = source.getBuffer();
+
+ // Step 1: Create a copy and normalize input to prevent clipping
+ // Step 3: Add silence at the end based on tail duration to let reverb tail ring out
+ int extraSamples = juce::jmax(0, (int)(settings.tailSeconds * settings.sampleRate));
+
+ DBG("Adding extra samples: " << extraSamples << " (" << settings.tailSeconds << " seconds)");
+
+ {
+ RenderProfiler::ScopedStage stage("Extend", &reverbBuffer);
+
+ reverbBuffer.setSize(originalSample.getNumChannels(), originalSample.getNumSamples() + extraSamples, false, false, true);
+ reverbBuffer.clear();
+
+ for (int channel = 0; channel < originalSample.getNumChannels(); ++channel)
+ reverbBuffer.copyFrom(channel, 0, originalSample, channel, 0, originalSample.getNumSamples());
+
+ stage.addBytesTouched(RenderProfiler::getSizeInBytes(originalSample) + RenderProfiler::getSizeInBytes(reverbBuffer));
+ }
+
+ RenderProfiler::ScopedStage stage("Normalize input");
+
+ // OPTIMIZATION: Use getMagnitude() for faster peak finding
+ float maxLevel = originalSample.getMagnitude(0, originalSample.getNumSamples());
+
+ // Scale down to 50% to prevent reverb clipping
+ if (maxLevel > 0.001f)
+ {
+ float scaleFactor = 0.5f / maxLevel;
+ reverbBuffer.applyGain(scaleFactor); // Apply to all channels at once
+ }
+
+ stage.addBytesTouched(RenderProfiler::getSizeInBytes(originalSample) + RenderProfiler::getSizeInBytes(reverbBuffer));
+
+ inputStage.store(key);
+ return true;
+}
+
+bool ReverseReverbRenderer::shouldRenderOutOfCore(const SourceSample& source, const RenderSettings& settings) const
+{
+ if (settings.scratchDirectory == juce::File() || settings.sampleRate <= 0.0)
+ return false;
+
+ const double reverbSeconds = source.getBuffer().getNumSamples() / settings.sampleRate + juce::jmax(0.0f, settings.tailSeconds);
+ return reverbSeconds > settings.outOfCoreSeconds;
+}
+
+RenderedSample::Ptr ReverseReverbRenderer::renderOutOfCore(const SourceSample& source, const RenderSettings& settings, const RenderControl& control)
+{
+ const auto& originalSample = source.getBuffer();
+ const int sourceLength = originalSample.getNumSamples();
+ const int sourceChannels = juce::jmin(2, originalSample.getNumChannels());
+ const int numChannels = 2; // A mono source is reverbed as stereo, like computeReverb() does
+ const int chunkSize = 16 * convolver.getBlockSize(); // Whole convolver blocks
+
+ // Same lengths and overlap as computeInput(), computeForward() and computeArrange()
+ const int reverbLength = sourceLength + juce::jmax(0, (int)(settings.tailSeconds * settings.sampleRate));
+ const int forwardLength = sourceLength + juce::jmax(0, (int)(juce::jmin(settings.tailSeconds, 4.0f) * settings.sampleRate));
+ const int overlapLength = settings.transitionMode ? juce::jmin(forwardLength / 2, reverbLength / 2) : 0;
+ const int forwardStart = reverbLength - overlapLength;
+ const int totalLength = settings.transitionMode ? reverbLength + forwardLength - overlapLength : reverbLength;
+
+ // Both files up front, so a full disk shows before any reverb runs.
+ // The guards are declared first so the mappings close before the files go.
+ settings.scratchDirectory.createDirectory();
+ ScopedTempFile reverbFile(RenderedSample::getUniqueScratchFile(settings.scratchDirectory, "pass"));
+ ScopedTempFile outputFile(RenderedSample::getUniqueScratchFile(settings.scratchDirectory, "reversed"));
+
+ const auto bytesPerSample = (juce::int64) (numChannels * sizeof(float));
+ const auto sourceBytes = RenderProfiler::getSizeInBytes(originalSample);
+ std::unique_ptr<juce::MemoryMappedFile> reverbMapping, outputMapping;
+
+ {
+ RenderProfiler::ScopedStage stage("Out-of-core: scratch files");
+
+ reverbMapping = RenderedSample::createPlanarFile(reverbFile.get(), numChannels, reverbLength);
+ outputMapping = reverbMapping != nullptr ? RenderedSample::createPlanarFile(outputFile.get(), numChannels, totalLength) : nullptr;
+
+ if (outputMapping != nullptr)
+ stage.addBytesAllocated(bytesPerSample * (reverbLength + (juce::int64) totalLength));
+ }
+
+ if (outputMapping == nullptr)
+ return new RenderedSample(); // The caller renders in memory instead
+
+ float* wet[2] = { RenderedSample::getPlanarChannel(*reverbMapping, 0, reverbLength),
+ RenderedSample::getPlanarChannel(*reverbMapping, 1, reverbLength) };
+ float* output[2] = { RenderedSample::getPlanarChannel(*outputMapping, 0, totalLength),
+ RenderedSample::getPlanarChannel(*outputMapping, 1, totalLength) };
+
+ DBG("Out-of-core render: " << reverbLength << " reverb samples, " << totalLength << " output samples");
+
+ // Pass 1: normalized, extended input -> reverb -> width and cleanup, chunk by chunk into the
+ // reverb file. The file starts zeroed, so the tail's silence is already there.
+ std::optional<RenderProfiler::ScopedStage> pass1; // Optional, so it ends where the pass does
+ pass1.emplace("Out-of-core pass 1: reverb, width and cleanup");
+ pass1->addBytesTouched(sourceBytes + bytesPerSample * reverbLength);
+
+ const float maxLevel = originalSample.getMagnitude(0, sourceLength);
+ const float inputGain = maxLevel > 0.001f ? 0.5f / maxLevel : 1.0f;
+
+ StreamingReverb reverb(settings, convolver, numChannels);
+ WidthProcessor width(settings.stereoWidth, settings.sampleRate);
+
+ for (int pos = 0; pos < reverbLength; pos += chunkSize)
+ {
+ if (control.cancelled())
+ return nullptr;
+
+ control.progress(0.1f + 0.5f * (float) pos / (float) reverbLength);
+
+ const int count = juce::jmin(chunkSize, reverbLength - pos);
+ const int fromSource = juce::jlimit(0, count, sourceLength - pos);
+ float* chunk[2] = { wet[0] + pos, wet[1] + pos };
+
+ for (int channel = 0; channel < numChannels && fromSource > 0; ++channel)
+ juce::FloatVectorOperations::copyWithMultiply(chunk[channel], originalSample.getReadPointer(juce::jmin(channel, sourceChannels - 1), pos),
+ inputGain, fromSource);
+
+ reverb.process(chunk, count);
+ width.process(chunk[0], chunk[1], count);
+ }
+
+ pass1.reset();
+
+ // Pass 2: the reverb file read backwards in windows, the forward pass crossfaded in
+ // (transition mode) and the low cut, straight into the output file
+ std::optional<RenderProfiler::ScopedStage> pass2;
+ pass2.emplace("Out-of-core pass 2: reverse, transition and low cut");
+ pass2->addBytesTouched(bytesPerSample * (reverbLength + (juce::int64) totalLength) + (settings.transitionMode ? sourceBytes : 0));
+
+ std::unique_ptr<StreamingReverb> forwardReverb;
+ juce::AudioBuffer<float> forwardChunk;
+
+ if (settings.transitionMode)
+ {
+ // Raw source, not the normalized input - same as computeForward()
+ forwardReverb = std::make_unique<StreamingReverb>(settings, convolver, sourceChannels);
+ forwardChunk.setSize(sourceChannels, chunkSize);
+ pass2->addBytesAllocated(RenderProfiler::getSizeInBytes(forwardChunk));
+ }
+
+ const bool applyLowCut = settings.lowCutFreq > 20.0f && settings.sampleRate > 0.0;
+ const float RC = 1.0f / (juce::MathConstants<float>::twoPi * settings.lowCutFreq);
+ const float dt = 1.0f / static_cast<float>(settings.sampleRate);
+ const float alpha = RC / (RC + dt);
+ float lowCutPrevInput[2] = {}, lowCutPrevOutput[2] = {};
+
+ float outputLevel = 0.0f;
+
+ for (int windowStart = 0; windowStart < totalLength;)
+ {
+ if (control.cancelled())
+ return nullptr;
+
+ control.progress(0.6f + 0.35f * (float) windowStart / (float) totalLength);
+
+ // Windows break at the forward pass's start, so it advances in whole chunks
+ const int windowEnd = windowStart < forwardStart ? juce::jmin(windowStart + chunkSize, forwardStart)
+ : juce::jmin(windowStart + chunkSize, totalLength);
+ const int count = windowEnd - windowStart;
+ const int reversedEnd = juce::jmin(windowEnd, reverbLength);
+
+ // Past the end of the reversed reverb the output file is still zero
+ if (reversedEnd > windowStart)
+ for (int channel = 0; channel < numChannels; ++channel)
+ std::reverse_copy(wet[channel] + reverbLength - reversedEnd, wet[channel] + reverbLength - windowStart, output[channel] + windowStart);
+
+ if (forwardReverb != nullptr && windowStart >= forwardStart)
+ {
+ const int forwardPos = windowStart - forwardStart;
+ const int fromSource = juce::jlimit(0, count, sourceLength - forwardPos);
+
+ forwardChunk.clear();
+ for (int channel = 0; channel < sourceChannels && fromSource > 0; ++channel)
+ forwardChunk.copyFrom(channel, 0, originalSample, channel, forwardPos, fromSource);
+
+ forwardReverb->process(forwardChunk.getArrayOfWritePointers(), count);
+ mixWetWidth(forwardChunk.getWritePointer(0), sourceChannels > 1 ? forwardChunk.getWritePointer(1) : nullptr,
+ count, settings.stereoWidth);
+
+ // Same smoothstep crossfade as computeArrange()
+ for (int channel = 0; channel < sourceChannels; ++channel)
+ {
+ auto* destData = output[channel] + windowStart;
+ auto* srcData = forwardChunk.getReadPointer(channel);
+
+ for (int i = 0; i < count; ++i)
+ {
+ float blend = 1.0f;
+
+ if (forwardPos + i < overlapLength)
+ {
+ const float fadePos = (float)(forwardPos + i) / overlapLength;
+ blend = fadePos * fadePos * (3.0f - 2.0f * fadePos);
+ }
+
+ destData[i] = destData[i] * (1.0f - blend) + srcData[i] * blend;
+ }
+ }
+ }
+
+ for (int channel = 0; channel < numChannels; ++channel)
+ {
+ auto* data = output[channel] + windowStart;
+
+ // Filter state carries over from window to window
+ if (applyLowCut)
+ {
+ for (int i = 0; i < count; ++i)
+ {
+ const float input = data[i];
+ const float filtered = alpha * (lowCutPrevOutput[channel] + input - lowCutPrevInput[channel]);
+ lowCutPrevInput[channel] = input;
+ lowCutPrevOutput[channel] = filtered;
+ data[i] = filtered;
+ }
+ }
+
+ const auto range = juce::FloatVectorOperations::findMinAndMax(data, count);
+ outputLevel = juce::jmax(outputLevel, -range.getStart(), range.getEnd());
+ }
+
+ windowStart = windowEnd;
+ }
+
+ reverbMapping.reset(); // Done with the reverb file
+ pass2.reset();
+
+ // Pass 3: final gentle normalization to -3dB, in place
+ control.progress(0.95f);
+
+ {
+ RenderProfiler::ScopedStage pass3("Out-of-core pass 3: normalize");
+ pass3.addBytesTouched(bytesPerSample * totalLength);
+
+ if (outputLevel > 0.001f)
+ for (int channel = 0; channel < numChannels; ++channel)
+ juce::FloatVectorOperations::multiply(output[channel], 0.707f / outputLevel, totalLength);
+ }
+
+ control.progress(1.0f);
+
+ return RenderedSample::adoptPlanarFile(std::move(outputMapping), outputFile.release(), numChannels, totalLength);
+}
+
+ReverseReverbRenderer::ReverbKey ReverseReverbRenderer::makeReverbKey(juce::uint32 inputVersion, const SourceSample* source, const RenderSettings& settings) const
+{
+ const bool convolution = settings.engine == ReverbEngine::convolution;
+ return { inputVersion, source, settings.reverbSize, settings.reverbMix, settings.tailSeconds, settings.sampleRate,
+ settings.engine, convolution ? impulseStage.version : 0u };
+}
+
+bool ReverseReverbRenderer::computeImpulse(const RenderSettings& settings)
+{
+ const ImpulseKey key { settings.impulseResponse.get(), settings.reverbSize, settings.reverbMix, settings.tailSeconds, settings.sampleRate };
+ if (impulseStage.isUpToDate(key))
+ return true;
+
+ impulseStage.invalidate();
+ convolver.reset();
+
+ auto& impulseResponse = impulseStage.output;
+ RenderProfiler::ScopedStage stage("Impulse response", &impulseResponse);
+
+ if (settings.impulseResponse != nullptr && ! settings.impulseResponse->isEmpty())
+ impulseResponse = prepareUserImpulseResponse(*settings.impulseResponse, settings);
+ else
+ impulseResponse = generateImpulseResponse(settings);
+
+ // Unit energy per channel, then the shared wet level, so both engines sit at a similar level
+ for (int channel = 0; channel < impulseResponse.getNumChannels(); ++channel)
+ {
+ auto rms = impulseResponse.getRMSLevel(channel, 0, impulseResponse.getNumSamples());
+ auto energy = rms * std::sqrt((float) impulseResponse.getNumSamples());
+
+ if (energy > 1.0e-6f)
+ impulseResponse.applyGain(channel, 0, impulseResponse.getNumSamples(), wetLevelFor(settings) / energy);
+ }
+
+ convolver.prepare(impulseResponse);
+ cachedImpulseResponse = settings.impulseResponse;
+ stage.addBytesTouched(RenderProfiler::getSizeInBytes(impulseResponse));
+
+ DBG("Impulse response: " << impulseResponse.getNumSamples() << " samples ("
+ << (settings.impulseResponse != nullptr ? "user" : "generated") << ")");
+
+ impulseStage.store(key);
+ return true;
+}
+
+bool ReverseReverbRenderer::runReverb(juce::AudioBuffer<float>& buffer, const RenderSettings& settings,
+ const RenderControl& control, float progressStart, float progressEnd)
+{
+ if (settings.engine == ReverbEngine::convolution)
+ {
+ return convolver.process(buffer, renderPool, control.isCancelled,
+ [&control, progressStart, progressEnd](float value)
+ {
+ control.progress(progressStart + (progressEnd - progressStart) * value);
+ });
+ }
+
+ // Step 2: Reset and configure reverb with beat-synced tail length
+ // VectorReverb is juce::Reverb with its comb bank in SIMD lanes - same output, faster
+ VectorReverb reverb;
+ reverb.setSampleRate(settings.sampleRate);
+ auto reverbParams = makeReverbParameters(settings);
+ reverb.setParameters(reverbParams);
+
+ DBG("Processing with tail duration: " << settings.tailSeconds << "s");
+ DBG("Adjusted room size: " << reverbParams.roomSize);
+ DBG("Damping: " << reverbParams.damping);
+
+ if (buffer.getNumChannels() == 1)
+ {
+ reverb.processMono(buffer.getWritePointer(0), buffer.getNumSamples());
+ return ! control.cancelled();
+ }
+
+ return processStereoInChunks(reverb, buffer, control, progressStart, progressEnd);
+}
+
+bool ReverseReverbRenderer::computeReverb(const RenderSettings& settings, const RenderControl& control)
+{
+ const auto key = makeReverbKey(inputStage.version, nullptr, settings);
+ if (reverbStage.isUpToDate(key))
+ return true;
+
+ reverbStage.invalidate();
+ auto& reverbBuffer = reverbStage.output;
+ RenderProfiler::ScopedStage stage("Reverb", &reverbBuffer);
+
+ // Step 4: Apply reverb in smaller chunks to prevent distortion
+ // Cancellation is checked between chunks so a newer request never waits on a stale render
+ const auto& input = inputStage.output;
+
+ if (input.getNumChannels() == 1)
+ {
+ // Mono - convert to stereo
+ reverbBuffer.setSize(2, input.getNumSamples(), false, false, true);
+ reverbBuffer.copyFrom(0, 0, input, 0, 0, input.getNumSamples());
+ reverbBuffer.copyFrom(1, 0, input, 0, 0, input.getNumSamples());
+ }
+ else
+ {
+ reverbBuffer.makeCopyOf(input);
+ }
+
+ if (! runReverb(reverbBuffer, settings, control, 0.1f, 0.6f))
+ return false;
+
+ stage.addBytesTouched(RenderProfiler::getSizeInBytes(input) + RenderProfiler::getSizeInBytes(reverbBuffer));
+ reverbStage.store(key);
+ return true;
+}
+
+bool ReverseReverbRenderer::computeWidth(const RenderSettings& settings)
+{
+ const WidthKey key { reverbStage.version, settings.stereoWidth, settings.sampleRate };
+ if (widthStage.isUpToDate(key))
+ return true;
+
+ widthStage.invalidate();
+ auto& reverbBuffer = widthStage.output;
+
+ // The reverb's own width setting, the Haas/narrowing width and the cleanup (Steps 4.5 and 5),
+ // shared with out-of-core renders
+ WidthProcessor width(settings.stereoWidth, settings.sampleRate);
+
+ {
+ RenderProfiler::ScopedStage stage("Width / Haas", &reverbBuffer);
+ reverbBuffer.makeCopyOf(reverbStage.output);
+ width.applyWidth(reverbBuffer.getWritePointer(0), reverbBuffer.getNumChannels() > 1 ? reverbBuffer.getWritePointer(1) : nullptr,
+ reverbBuffer.getNumSamples());
+ stage.addBytesTouched(RenderProfiler::getSizeInBytes(reverbStage.output) + RenderProfiler::getSizeInBytes(reverbBuffer));
+ }
+
+ {
+ RenderProfiler::ScopedStage stage("Cleanup");
+ WidthProcessor::cleanUp(reverbBuffer.getWritePointer(0), reverbBuffer.getNumChannels() > 1 ? reverbBuffer.getWritePointer(1) : nullptr,
+ reverbBuffer.getNumSamples());
+ stage.addBytesTouched(RenderProfiler::getSizeInBytes(reverbBuffer));
+ }
+
+ DBG("Stereo width: " << settings.stereoWidth);
+
+ widthStage.store(key);
+ return true;
+}
+
+bool ReverseReverbRenderer::computeForward(const SourceSample& source, const RenderSettings& settings, const RenderControl& control)
+{
+ // The forward pass reads the raw source, not the normalized input stage
+ const auto key = makeReverbKey(0, &source, settings);
+ if (forwardStage.isUpToDate(key))
+ return true;
+
+ forwardStage.invalidate();
+ auto& originalWithReverb = forwardStage.output;
+ const auto& originalSample = source.getBuffer();
+ RenderProfiler::ScopedStage stage("Forward reverb", &originalWithReverb);
+
+ // Now create a FORWARD reverb for the original sample
+ // IDENTICAL reverb settings - create SYMMETRY!
+ // Use THE SAME settings (and engine) as the reversed reverb for visual balance
+
+ // Add extra silence for tail (capped at 4s for transition mode)
+ float forwardTailDuration = juce::jmin(settings.tailSeconds, 4.0f);
+ int extraSamplesForward = juce::jmax(0, (int)(forwardTailDuration * settings.sampleRate));
+
+ // Extend original sample with silence to match reversed reverb tail
+ originalWithReverb.setSize(originalSample.getNumChannels(), originalSample.getNumSamples() + extraSamplesForward, false, false, true);
+ originalWithReverb.clear();
+
+ for (int channel = 0; channel < originalSample.getNumChannels(); ++channel)
+ originalWithReverb.copyFrom(channel, 0, originalSample, channel, 0, originalSample.getNumSamples());
+
+ DBG(" Forward reverb extra samples: " + juce::String(extraSamplesForward));
+
+ // Process original sample with reverb
+ if (! runReverb(originalWithReverb, settings, control, 0.6f, 0.85f))
+ return false;
+
+ stage.addBytesTouched(RenderProfiler::getSizeInBytes(originalSample) + RenderProfiler::getSizeInBytes(originalWithReverb));
+
+ forwardStage.store(key);
+ return true;
+}
+
+bool ReverseReverbRenderer::computeArrange(const RenderSettings& settings)
+{
+ const ArrangeKey key { widthStage.version,
+ settings.transitionMode ? forwardStage.version : 0u,
+ settings.transitionMode ? settings.stereoWidth : 0.0f,
+ settings.transitionMode };
+ if (arrangeStage.isUpToDate(key))
+ return true;
+
+ arrangeStage.invalidate();
+ auto& processedSample = arrangeStage.output;
+ const auto& widthOutput = widthStage.output;
+ RenderProfiler::ScopedStage stage(settings.transitionMode ? "Transition" : "Reverse", &processedSample);
+
+ // Step 6: Reverse the audio OR Create transition
+ // Both modes start from the reversed reverb
+ processedSample.makeCopyOf(widthOutput);
+
+ for (int channel = 0; channel < processedSample.getNumChannels(); ++channel)
+ {
+ auto* data = processedSample.getWritePointer(channel);
+ std::reverse(data, data + processedSample.getNumSamples());
+ }
+
+ if (! settings.transitionMode)
+ {
+ // REVERSE ONLY MODE: Standard reverse reverb
+ DBG(" REVERSE ONLY MODE: Reversed reverb only (length: " + juce::String(processedSample.getNumSamples()) + " samples)");
+ stage.addBytesTouched(RenderProfiler::getSizeInBytes(widthOutput) + RenderProfiler::getSizeInBytes(processedSample));
+ arrangeStage.store(key);
+ return true;
+ }
+
+ // TRANSITION MODE: Reversed reverb -> Original sample WITH reverb
+ // This creates a smooth transition effect where the original also has reverb!
+ juce::AudioBuffer<float> originalWithReverb;
+ originalWithReverb.makeCopyOf(forwardStage.output);
+ mixWetWidth(originalWithReverb, settings.stereoWidth); // SAME width as the reversed reverb
+ stage.addBytesAllocated(RenderProfiler::getSizeInBytes(originalWithReverb));
+
+ juce::AudioBuffer<float> reverbBuffer(std::move(processedSample));
+
+ // Get lengths for blending calculation
+ int reversedReverbLength = reverbBuffer.getNumSamples();
+ int originalLength = originalWithReverb.getNumSamples();
+
+ // NOW CREATE A SMOOTH OVERLAP/BLEND - NO GAP!
+ // Instead of putting original at the END, we OVERLAP them!
+
+ // Overlap length - how much the two buffers overlap (50% of original or reverb, whichever is shorter)
+ int overlapLength = juce::jmin(originalLength / 2, reversedReverbLength / 2);
+
+ // Total length is LESS than sum because of overlap!
+ int totalLength = reversedReverbLength + originalLength - overlapLength;
+
+ // Start position for original sample (overlaps with end of reversed reverb)
+ int originalStartPos = reversedReverbLength - overlapLength;
+
+ // Create output buffer
+ processedSample.setSize(reverbBuffer.getNumChannels(),
+ totalLength,
+ false, false, true);
+ processedSample.clear();
+
+ // 1 Copy reversed reverb to the beginning (full length)
+ for (int channel = 0; channel < processedSample.getNumChannels(); ++channel)
+ {
+ processedSample.copyFrom(channel, 0, reverbBuffer, channel, 0, reversedReverbLength);
+ }
+
+ // 2 Blend original sample WITH REVERB starting BEFORE reverb ends
+ for (int channel = 0; channel < juce::jmin(processedSample.getNumChannels(), originalWithReverb.getNumChannels()); ++channel)
+ {
+ auto* destData = processedSample.getWritePointer(channel);
+ auto* srcData = originalWithReverb.getReadPointer(channel);
+
+ for (int i = 0; i < originalLength; ++i)
+ {
+ int destPos = originalStartPos + i;
+ if (destPos >= 0 && destPos < totalLength)
+ {
+ // Calculate blend factor based on position in overlap
+ float blend = 1.0f; // Default: full original volume
+
+ if (i < overlapLength)
+ {
+ // We're in the overlap zone - crossfade!
+ float fadePos = (float)i / overlapLength;
+
+ // Smooth S-curve for better blending
+ fadePos = fadePos * fadePos * (3.0f - 2.0f * fadePos); // Smoothstep
+
+ // Original fades IN, reverb already there will fade OUT naturally
+ blend = fadePos;
+ }
+
+ // Mix the samples
+ destData[destPos] = destData[destPos] * (1.0f - blend) + srcData[i] * blend;
+ }
+ }
+ }
+
+ DBG(" TRANSITION MODE: Reversed reverb -> Original WITH reverb");
+ DBG(" Overlap length: " + juce::String(overlapLength) + " samples (" + juce::String(overlapLength / settings.sampleRate, 2) + "s)");
+ DBG(" Total length: " + juce::String(totalLength) + " samples");
+
+ stage.addBytesTouched(RenderProfiler::getSizeInBytes(widthOutput) + 2 * RenderProfiler::getSizeInBytes(originalWithReverb)
+ + RenderProfiler::getSizeInBytes(processedSample));
+ arrangeStage.store(key);
+ return true;
+}
+
+bool ReverseReverbRenderer::computeLowCut(const RenderSettings& settings)
+{
+ const LowCutKey key { arrangeStage.version, settings.lowCutFreq, settings.sampleRate };
+ if (lowCutStage.isUpToDate(key))
+ return true;
+
+ lowCutStage.invalidate();
+ auto& processedSample = lowCutStage.output;
+ RenderProfiler::ScopedStage stage("Low cut", &processedSample);
+ processedSample.makeCopyOf(arrangeStage.output);
+ stage.addBytesTouched(RenderProfiler::getSizeInBytes(arrangeStage.output) + RenderProfiler::getSizeInBytes(processedSample));
+
+ const float lowCutFreq = settings.lowCutFreq;
+
+ // Step 6.5: Apply Low Cut Filter (simple 1-pole high-pass)
+ if (lowCutFreq > 20.0f && settings.sampleRate > 0.0)
+ {
+ // Calculate filter coefficient
+ float RC = 1.0f / (juce::MathConstants<float>::twoPi * lowCutFreq);
+ float dt = 1.0f / static_cast<float>(settings.sampleRate);
+ float alpha = RC / (RC + dt);
+
+ // Filter state starts from silence for every render
+ float lowCutPrevInputL = 0.0f;
+ float lowCutPrevInputR = 0.0f;
+ float lowCutPrevOutputL = 0.0f;
+ float lowCutPrevOutputR = 0.0f;
+
+ // Apply filter to left channel
+ if (processedSample.getNumChannels() >= 1)
+ {
+ auto* dataL = processedSample.getWritePointer(0);
+ for (int i = 0; i < processedSample.getNumSamples(); ++i)
+ {
+ float input = dataL[i];
+ float output = alpha * (lowCutPrevOutputL + input - lowCutPrevInputL);
+ lowCutPrevInputL = input;
+ lowCutPrevOutputL = output;
+ dataL[i] = output;
+ }
+ }
+
+ // Apply filter to right channel
+ if (processedSample.getNumChannels() >= 2)
+ {
+ auto* dataR = processedSample.getWritePointer(1);
+ for (int i = 0; i < processedSample.getNumSamples(); ++i)
+ {
+ float input = dataR[i];
+ float output = alpha * (lowCutPrevOutputR + input - lowCutPrevInputR);
+ lowCutPrevInputR = input;
+ lowCutPrevOutputR = output;
+ dataR[i] = output;
+ }
+ }
+
+ DBG("Applied Low Cut filter at " << lowCutFreq << " Hz");
+ }
+
+ lowCutStage.store(key);
+ return true;
+}
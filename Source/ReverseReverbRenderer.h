@@ -0,0 +1,182 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <functional>
+#include <tuple>
+#include "RenderedSample.h"
+#include "PartitionedConvolver.h"
+
+// Which reverb the render runs
+enum class ReverbEngine
+{
+ freeverb,   // Freeverb (VectorReverb), tail length approximated through room size and damping
+ convolution // Partitioned FFT convolution with a user IR, or a generated one that decays over the tail length
+};
+
+// Snapshot of every parameter the offline render reads.
+// Taken on the requesting thread so a render never reads live processor state.
+struct RenderSettings
+{
+ float reverbSize = 1.0f;
+ float reverbMix = 1.0f;
+ float tailSeconds = 2.0f;   // Beat-synced tail length (BPM + division resolved by the caller)
+ float stereoWidth = 0.5f;   // 0.0 = mono, 0.5 = normal, 1.0 = max width
+ float lowCutFreq = 20.0f;   // 20Hz to 500Hz
+ bool transitionMode = false;
+ double sampleRate = 44100.0;
+
+ ReverbEngine engine = ReverbEngine::freeverb;
+ SourceSample::Ptr impulseResponse; // Convolution only - null generates an IR from the tail length
+ juce::File impulseResponseFile;     // Where impulseResponse was loaded from, for saving state - not read by the render
+
+ juce::File scratchDirectory;      // Where long renders run out of core - empty keeps every render in memory
+ double outOfCoreSeconds = 20.0;   // Reverb length (source + tail) past which a render goes out of core
+
+ // Tail length for a tail division (0=8 Bar, 1=4 Bar, 2=2 Bar, 3=1 Bar, 4=1/2 ... 8=1/32, in 4/4) at a tempo
+ static float getTailSeconds(int tailDivision, double bpm);
+
+ bool operator== (const RenderSettings& o) const { return std::tie(reverbSize, reverbMix, tailSeconds, stereoWidth, lowCutFreq, transitionMode, sampleRate, engine, impulseResponse, scratchDirectory, outOfCoreSeconds) == std::tie(o.reverbSize, o.reverbMix, o.tailSeconds, o.stereoWidth, o.lowCutFreq, o.transitionMode, o.sampleRate, o.engine, o.impulseResponse, o.scratchDirectory, o.outOfCoreSeconds); }
+ bool operator!= (const RenderSettings& o) const { return ! (*this == o); }
+};
+
+// Lets the caller cancel a render and follow its progress. Both hooks are optional.
+struct RenderControl
+{
+ std::function<bool()> isCancelled;
+ std::function<void(float)> reportProgress; // 0.0 to 1.0
+
+ bool cancelled() const { return isCancelled != nullptr && isCancelled(); }
+ void progress(float value) const { if (reportProgress != nullptr) reportProgress(value); }
+};
+
+// The offline reverse-reverb render, split into memoized stages:
+//
+//   input (normalize + extend) -> reverb -> width + cleanup -> arrange (reverse or transition) -> low cut -> final normalize
+//                                              forward reverb (transition mode) ----^
+//   impulse response (convolution engine) feeds both reverb passes
+//
+// Each stage keeps its last output together with the parameters it read and the
+// versions of the stages it read from, so a render only recomputes the stages
+// downstream of whatever changed. Moving the low cut, for example, skips both
+// reverb passes entirely. In transition mode the two Freeverb passes run at the
+// same time, the forward one on the render pool. Not thread-safe - one renderer
+// per render thread, but any number of renderers can share one render pool.
+//
+// Long sources skip the stages and render out of core instead: the reverb streams
+// chunk by chunk into a memory-mapped temp file, and the reverse, transition and
+// low-cut passes read that file backwards in fixed-size windows, writing straight
+// into the file the finished render streams from. Peak memory stays a few chunks,
+// however long the source is.
+class ReverseReverbRenderer
+{
+public:
+ // pool runs convolution jobs and the concurrent forward pass, and must outlive the renderer.
+ // Set renderingOnPool when render() itself is called from jobs on that pool: the forward
+ // pass then runs inline, so a job never waits on jobs queued behind it in its own pool.
+ explicit ReverseReverbRenderer(juce::ThreadPool& pool, bool renderingOnPool = false)
+ : renderPool(pool), rendersOnPool(renderingOnPool) {}
+
+ // Returns nullptr if the render was cancelled, an empty sample if it failed
+ RenderedSample::Ptr render(SourceSample::Ptr source,
+ const RenderSettings& settings,
+ const RenderControl& control = {});
+
+ // Drops every cached stage output (and the reference to the cached source)
+ void clearCache();
+
+private:
+ // One memoized stage: its output is valid while the key it was computed with still matches
+ template <typename KeyType>
+ struct Stage
+ {
+  KeyType key {};
+  juce::AudioBuffer<float> output;
+  juce::uint32 version = 0; // Bumped on every recompute so downstream keys can depend on it
+  bool valid = false;
+
+  bool isUpToDate(const KeyType& newKey) const { return valid && key == newKey; }
+  void invalidate() { valid = false; }
+  void store(const KeyType& newKey) { key = newKey; valid = true; ++version; }
+ };
+
+ struct ImpulseKey
+ {
+  const SourceSample* impulseResponse = nullptr;
+  float reverbSize = 0.0f, reverbMix = 0.0f, tailSeconds = 0.0f;
+  double sampleRate = 0.0;
+  bool operator== (const ImpulseKey& o) const { return std::tie(impulseResponse, reverbSize, reverbMix, tailSeconds, sampleRate) == std::tie(o.impulseResponse, o.reverbSize, o.reverbMix, o.tailSeconds, o.sampleRate); }
+ };
+
+ struct InputKey
+ {
+  const SourceSample* source = nullptr;
+  float tailSeconds = 0.0f;
+  double sampleRate = 0.0;
+  bool operator== (const InputKey& o) const { return std::tie(source, tailSeconds, sampleRate) == std::tie(o.source, o.tailSeconds, o.sampleRate); }
+ };
+
+ struct ReverbKey
+ {
+  juce::uint32 inputVersion = 0;
+  const SourceSample* source = nullptr; // Only read by the forward pass
+  float reverbSize = 0.0f, reverbMix = 0.0f, tailSeconds = 0.0f;
+  double sampleRate = 0.0;
+  ReverbEngine engine = ReverbEngine::freeverb;
+  juce::uint32 impulseVersion = 0; // 0 unless convolution
+  bool operator== (const ReverbKey& o) const { return std::tie(inputVersion, source, reverbSize, reverbMix, tailSeconds, sampleRate, engine, impulseVersion) == std::tie(o.inputVersion, o.source, o.reverbSize, o.reverbMix, o.tailSeconds, o.sampleRate, o.engine, o.impulseVersion); }
+ };
+
+ struct WidthKey
+ {
+  juce::uint32 reverbVersion = 0;
+  float stereoWidth = 0.0f;
+  double sampleRate = 0.0;
+  bool operator== (const WidthKey& o) const { return std::tie(reverbVersion, stereoWidth, sampleRate) == std::tie(o.reverbVersion, o.stereoWidth, o.sampleRate); }
+ };
+
+ struct ArrangeKey
+ {
+  juce::uint32 widthVersion = 0;
+  juce::uint32 forwardVersion = 0; // 0 unless transition mode
+  float forwardWidth = 0.0f;       // 0 unless transition mode
+  bool transitionMode = false;
+  bool operator== (const ArrangeKey& o) const { return std::tie(widthVersion, forwardVersion, forwardWidth, transitionMode) == std::tie(o.widthVersion, o.forwardVersion, o.forwardWidth, o.transitionMode); }
+ };
+
+ struct LowCutKey
+ {
+  juce::uint32 arrangeVersion = 0;
+  float lowCutFreq = 0.0f;
+  double sampleRate = 0.0;
+  bool operator== (const LowCutKey& o) const { return std::tie(arrangeVersion, lowCutFreq, sampleRate) == std::tie(o.arrangeVersion, o.lowCutFreq, o.sampleRate); }
+ };
+
+ bool shouldRenderOutOfCore(const SourceSample& source, const RenderSettings& settings) const;
+ RenderedSample::Ptr renderOutOfCore(const SourceSample& source, const RenderSettings& settings, const RenderControl& control);
+ ReverbKey makeReverbKey(juce::uint32 inputVersion, const SourceSample* source, const RenderSettings& settings) const;
+ bool computeImpulse(const RenderSettings& settings);
+ bool runReverb(juce::AudioBuffer<float>& buffer, const RenderSettings& settings, const RenderControl& control, float progressStart, float progressEnd);
+ bool computeInput(const SourceSample& source, const RenderSettings& settings);
+ bool computeReverb(const RenderSettings& settings, const RenderControl& control);
+ bool computeWidth(const RenderSettings& settings);
+ bool computeForward(const SourceSample& source, const RenderSettings& settings, const RenderControl& control);
+ bool computeArrange(const RenderSettings& settings);
+ bool computeLowCut(const RenderSettings& settings);
+
+ SourceSample::Ptr cachedSource; // Keeps the keyed source alive so its address can't be reused
+ SourceSample::Ptr cachedImpulseResponse; // Same for a user IR
+
+ Stage<ImpulseKey> impulseStage;
+ PartitionedConvolver convolver;   // Prepared from impulseStage.output
+ juce::ThreadPool& renderPool; // Shared - convolution jobs and the concurrent forward pass
+ const bool rendersOnPool;
+
+ Stage<InputKey> inputStage;
+ Stage<ReverbKey> reverbStage;
+ Stage<WidthKey> widthStage;
+ Stage<ReverbKey> forwardStage;
+ Stage<ArrangeKey> arrangeStage;
+ Stage<LowCutKey> lowCutStage;
+
+ JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ReverseReverbRenderer)
+};
@@ -0,0 +1,347 @@
+#include "SampleBank.h"
+#include "SampleLoader.h"
+#include "RenderCache.h"
+#include "PersistentRenderCache.h"
+
+// One slot's decode (if its source isn't decoded yet) and render, with the
+// request snapshot it was queued with
+class SampleBank::SlotJob : public juce::ThreadPoolJob
+{
+public:
+ SlotJob(SampleBank& ownerBank, int slotToRender, juce::uint32 generationToRender,
+ const juce::File& fileToDecode, SourceSample::Ptr decodedSource, const RenderSettings& settingsToUse)
+ : juce::ThreadPoolJob("ReverseReverb Bank Slot " + juce::String(slotToRender)),
+ bank(ownerBank), slotIndex(slotToRender), generation(generationToRender),
+ file(fileToDecode), source(std::move(decodedSource)), settings(settingsToUse)
+ {
+ ++bank.numJobs;
+ }
+
+ ~SlotJob() override
+ {
+ --bank.numJobs;
+ }
+
+ JobStatus runJob() override
+ {
+ auto& slot = bank.slots[(size_t) slotIndex];
+ const std::function<bool()> isCancelled = [this, &slot]
+ {
+ return shouldExit() || slot.generation.load() != generation;
+ };
+
+ if (source == nullptr)
+ {
+ // Per job: PcmFileCache instances are one per thread
+ DecodedSampleCache decodedCache;
+ juce::String error;
+ source = SampleLoader::decodeFile(bank.formatManager, decodedCache, file, bank.maxSeconds, isCancelled, nullptr, error);
+
+ if (source == nullptr)
+ {
+ if (error.isNotEmpty())
+ {
+ DBG("Sample bank: slot " << slotIndex << ": " << error);
+ ++bank.failureCount;
+ }
+
+ return jobHasFinished;
+ }
+
+ const juce::ScopedLock sl(slot.lock);
+ if (isCancelled())
+ return jobHasFinished;
+
+ slot.source = source; // Later settings changes skip the decode
+ }
+
+ // A restored slot with a user IR of its own only knows the IR's file
+ if (settings.engine == ReverbEngine::convolution && settings.impulseResponse == nullptr && settings.impulseResponseFile != juce::File())
+ {
+ DecodedSampleCache decodedCache;
+ juce::String error;
+ settings.impulseResponse = SampleLoader::decodeFile(bank.formatManager, decodedCache, settings.impulseResponseFile,
+ SampleLoader::maxImpulseResponseSeconds, isCancelled, nullptr, error);
+
+ if (isCancelled())
+ return jobHasFinished;
+
+ if (settings.impulseResponse == nullptr)
+ {
+ // Moved or deleted since the session was saved: the generated IR stands in
+ DBG("Sample bank: slot " << slotIndex << ": impulse response: " << error);
+ ++bank.failureCount;
+ settings.impulseResponseFile = juce::File();
+ }
+
+ const juce::ScopedLock sl(slot.lock);
+ if (isCancelled())
+ return jobHasFinished;
+
+ slot.settings = settings; // Later settings changes skip the decode too
+ }
+
+ const juce::ScopedLock sl(slot.renderLock);
+ if (isCancelled())
+ return jobHasFinished;
+
+ // Same keys as the render worker's, so a kit reopened in a later session maps its renders back
+ const auto cacheKey = RenderCache::makeKey(*source, settings);
+ PersistentRenderCache diskCache;
+
+ auto result = diskCache.find(cacheKey);
+ const bool cached = result != nullptr;
+
+ if (!cached)
+ {
+ RenderControl control;
+ control.isCancelled = isCancelled;
+
+ auto sourceAtRate = source->getAtSampleRate(settings.sampleRate, isCancelled);
+ result = sourceAtRate != nullptr ? slot.renderer->render(sourceAtRate, settings, control) : nullptr;
+
+ if (result == nullptr || control.cancelled())
+ return jobHasFinished;
+ }
+
+ if (bank.onRenderFinished != nullptr)
+ result = bank.onRenderFinished(result, settings);
+
+ {
+ // Under the slot lock, so a render that lost a race with clearSlot() is never published after it
+ const juce::ScopedLock sl(slot.lock);
+ if (isCancelled())
+ return jobHasFinished;
+
+ slot.handoff.publish(result);
+ }
+
+ DBG("Sample bank: slot " << slotIndex << (cached ? " loaded from the disk cache" : " rendered"));
+
+ if (!cached && !result->isEmpty())
+ diskCache.store(cacheKey, *result);
+
+ return jobHasFinished;
+ }
+
+private:
+ SampleBank& bank;
+ const int slotIndex;
+ const juce::uint32 generation;
+ const juce::File file;
+ SourceSample::Ptr source;
+ RenderSettings settings; // Gets the decoded IR, if only its file was given
+
+ JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SlotJob)
+};
+
+SampleBank::SampleBank(juce::AudioFormatManager& formats, juce::ThreadPool& poolToUse, double maxSecondsToAccept, PublishCallback onRenderFinishedToUse)
+ : formatManager(formats),
+ maxSeconds(maxSecondsToAccept),
+ onRenderFinished(std::move(onRenderFinishedToUse)),
+ pool(poolToUse)
+{
+ // Slot jobs call render() on the pool itself
+ for (auto& slot : slots)
+ slot.renderer = std::make_unique<ReverseReverbRenderer>(pool, true);
+}
+
+SampleBank::~SampleBank()
+{
+ for (auto& slot : slots)
+ ++slot.generation;
+
+ // Other users' jobs stay queued on the shared pool
+ struct SlotJobSelector : public juce::ThreadPool::JobSelector
+ {
+ bool isJobSuitable(juce::ThreadPoolJob* job) override { return dynamic_cast<SlotJob*>(job) != nullptr; }
+ };
+
+ SlotJobSelector slotJobs;
+ pool.removeAllJobs(true, 4000, &slotJobs);
+}
+
+void SampleBank::loadSlot(int slotIndex, const juce::File& file, int lowNote, int highNote, const RenderSettings& settings, bool followMain)
+{
+ jassert(juce::isPositiveAndBelow(slotIndex, maxSlots));
+ auto& slot = slots[(size_t) slotIndex];
+
+ const juce::ScopedLock sl(slot.lock);
+ slot.file = file;
+ slot.source = nullptr;
+ slot.settings = settings;
+ slot.followsMain = followMain;
+ slot.loaded = true;
+ setSlotKeyRange(slotIndex, lowNote, highNote);
+ queueJob(slotIndex);
+}
+
+void SampleBank::setSlotSettings(int slotIndex, const RenderSettings& settings)
+{
+ jassert(juce::isPositiveAndBelow(slotIndex, maxSlots));
+ auto& slot = slots[(size_t) slotIndex];
+
+ const juce::ScopedLock sl(slot.lock);
+ const bool changed = slot.settings != settings;
+ slot.settings = settings;
+ slot.followsMain = false;
+
+ if (slot.loaded && changed)
+ queueJob(slotIndex);
+}
+
+void SampleBank::setMainSettings(const RenderSettings& settings)
+{
+ for (int i = 0; i < maxSlots; ++i)
+ {
+ auto& slot = slots[(size_t) i];
+ const juce::ScopedLock sl(slot.lock);
+
+ if (slot.followsMain && slot.settings != settings)
+ {
+ slot.settings = settings;
+
+ if (slot.loaded)
+ queueJob(i);
+ }
+ }
+}
+
+void SampleBank::setSlotFollowsMain(int slotIndex, bool shouldFollow, const RenderSettings& mainSettings)
+{
+ jassert(juce::isPositiveAndBelow(slotIndex, maxSlots));
+ auto& slot = slots[(size_t) slotIndex];
+
+ const juce::ScopedLock sl(slot.lock);
+ slot.followsMain = shouldFollow;
+
+ if (shouldFollow && slot.settings != mainSettings)
+ {
+ slot.settings = mainSettings;
+
+ if (slot.loaded)
+ queueJob(slotIndex);
+ }
+}
+
+void SampleBank::setSampleRate(double sampleRate)
+{
+ for (int i = 0; i < maxSlots; ++i)
+ {
+ auto& slot = slots[(size_t) i];
+ const juce::ScopedLock sl(slot.lock);
+
+ if (slot.loaded && slot.settings.sampleRate != sampleRate)
+ {
+ slot.settings.sampleRate = sampleRate;
+ queueJob(i);
+ }
+ }
+}
+
+void SampleBank::setSlotKeyRange(int slotIndex, int lowNote, int highNote)
+{
+ jassert(juce::isPositiveAndBelow(slotIndex, maxSlots));
+ auto& slot = slots[(size_t) slotIndex];
+ slot.lowNote = juce::jlimit(0, 127, lowNote);
+ slot.highNote = juce::jlimit(-1, 127, highNote);
+}
+
+void SampleBank::clearSlot(int slotIndex)
+{
+ jassert(juce::isPositiveAndBelow(slotIndex, maxSlots));
+ auto& slot = slots[(size_t) slotIndex];
+
+ {
+ const juce::ScopedLock sl(slot.lock);
+ ++slot.generation; // Cancels the job in flight
+ slot.file = juce::File();
+ slot.source = nullptr;
+ slot.loaded = false;
+ slot.followsMain = true;
+ slot.lowNote = 0;
+ slot.highNote = -1;
+
+ if (slot.handoff.getLatest() != nullptr)
+ slot.handoff.publish(new RenderedSample());
+ }
+
+ // The renderer's cached stages can be large - drop them with the slot
+ const juce::ScopedLock sl(slot.renderLock);
+ slot.renderer->clearCache();
+}
+
+void SampleBank::clearAll()
+{
+ for (int i = 0; i < maxSlots; ++i)
+ clearSlot(i);
+}
+
+bool SampleBank::isSlotLoaded(int slotIndex) const
+{
+ auto& slot = slots[(size_t) slotIndex];
+ const juce::ScopedLock sl(slot.lock);
+ return slot.loaded;
+}
+
+int SampleBank::getNumLoadedSlots() const
+{
+ int count = 0;
+ for (int i = 0; i < maxSlots; ++i)
+ if (isSlotLoaded(i))
+ ++count;
+
+ return count;
+}
+
+juce::File SampleBank::getSlotFile(int slotIndex) const
+{
+ auto& slot = slots[(size_t) slotIndex];
+ const juce::ScopedLock sl(slot.lock);
+ return slot.file;
+}
+
+RenderSettings SampleBank::getSlotSettings(int slotIndex) const
+{
+ auto& slot = slots[(size_t) slotIndex];
+ const juce::ScopedLock sl(slot.lock);
+ return slot.settings;
+}
+
+bool SampleBank::doesSlotFollowMain(int slotIndex) const
+{
+ auto& slot = slots[(size_t) slotIndex];
+ const juce::ScopedLock sl(slot.lock);
+ return slot.followsMain;
+}
+
+void SampleBank::collectGarbage()
+{
+ for (auto& slot : slots)
+ slot.handoff.collectGarbage();
+}
+
+int SampleBank::findSlotForNote(int note) const noexcept
+{
+ for (int i = 0; i < maxSlots; ++i)
+ {
+ auto& slot = slots[(size_t) i];
+ if (note < slot.lowNote.load(std::memory_order_relaxed) || note > slot.highNote.load(std::memory_order_relaxed))
+ continue;
+
+ auto* render = slot.handoff.getCurrent();
+ if (render != nullptr && !render->isEmpty())
+ return i;
+ }
+
+ return -1;
+}
+
+void SampleBank::queueJob(int slotIndex)
+{
+ auto& slot = slots[(size_t) slotIndex];
+ const auto generation = ++slot.generation; // Cancels this slot's job in flight - other slots keep going
+
+ // The pool owns and deletes the job; a stale one finishes at its next cancellation check
+ pool.addJob(new SlotJob(*this, slotIndex, generation, slot.file, slot.source, slot.settings), true);
+}
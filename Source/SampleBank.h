@@ -0,0 +1,115 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <functional>
+#include "RealtimeHandoff.h"
+#include "ReverseReverbRenderer.h"
+
+// Extra samples mapped to MIDI key ranges, each with its own render settings,
+// so a whole kit of reverse swells plays from one instance. A slot follows the
+// main settings (re-rendering as they change) until it is given settings of
+// its own.
+//
+// Every slot decodes and renders as a job on the processor's render pool, which
+// the slots' renderers also use for their convolution jobs, so a kit loads on
+// all cores at once without spawning threads of its own. Requests for a slot are coalesced
+// like the render worker's: a newer load or settings change cancels that
+// slot's job in flight, and other slots keep going. Each slot publishes its
+// render through its own RealtimeHandoff, so the audio thread picks up every
+// slot independently. The main sample stays with the render worker and plays
+// on every key no slot claims.
+class SampleBank
+{
+public:
+ static constexpr int maxSlots = 16;
+
+ // Called on a pool thread with every finished slot render and its settings; returns the render
+ // to publish (the processor moves long ones to a streamed file)
+ using PublishCallback = std::function<RenderedSample::Ptr(RenderedSample::Ptr, const RenderSettings&)>;
+
+ // formats and pool must outlive the bank
+ SampleBank(juce::AudioFormatManager& formats, juce::ThreadPool& pool, double maxSecondsToAccept, PublishCallback onRenderFinished);
+ ~SampleBank();
+
+ // Any thread: decode file into slot, play it on [lowNote, highNote] and render it with settings
+ // (the main settings when followMain is set). Replaces whatever the slot held; the render
+ // lands in the background.
+ void loadSlot(int slot, const juce::File& file, int lowNote, int highNote, const RenderSettings& settings, bool followMain);
+
+ // Any thread: give a slot settings of its own (it stops following the main settings), re-rendering if they differ
+ void setSlotSettings(int slot, const RenderSettings& settings);
+
+ // Any thread: the main settings changed - re-render every loaded slot that follows them and differs
+ void setMainSettings(const RenderSettings& settings);
+
+ // Any thread: make a slot follow the main settings (re-rendering with mainSettings) or keep its current ones
+ void setSlotFollowsMain(int slot, bool shouldFollow, const RenderSettings& mainSettings);
+
+ // Any thread: re-render every loaded slot at a new session rate, keeping their settings
+ void setSampleRate(double sampleRate);
+
+ // Any thread: takes effect on the next note-on
+ void setSlotKeyRange(int slot, int lowNote, int highNote);
+
+ // Any thread: empty the slot (its voices stop when the empty render lands)
+ void clearSlot(int slot);
+ void clearAll();
+
+ // Non-realtime threads
+ bool isSlotLoaded(int slot) const;
+ int getNumLoadedSlots() const;
+ juce::File getSlotFile(int slot) const;
+ RenderSettings getSlotSettings(int slot) const;
+ bool doesSlotFollowMain(int slot) const;
+ int getSlotLowNote(int slot) const noexcept { return slots[(size_t) slot].lowNote.load(); }
+ int getSlotHighNote(int slot) const noexcept { return slots[(size_t) slot].highNote.load(); }
+ RenderedSample::Ptr getSlotRender(int slot) const { return slots[(size_t) slot].handoff.getLatest(); }
+ bool isRendering() const { return numJobs.load() > 0; }
+ juce::uint32 getFailureCount() const noexcept { return failureCount.load(); } // Bumped on every failed decode
+ void collectGarbage(); // Frees slot renders the audio thread has let go of
+
+ // Audio thread: adopt the newest render for this slot and return the one to play this block (may be null)
+ RenderedSample* acquire(int slot) noexcept { return slots[(size_t) slot].handoff.acquire(); }
+
+ // Audio thread: the first slot whose key range holds note and whose current render has audio, or -1
+ int findSlotForNote(int note) const noexcept;
+
+private:
+ class SlotJob;
+
+ struct Slot
+ {
+  // Guarded by lock
+  juce::CriticalSection lock;
+  juce::File file;
+  SourceSample::Ptr source; // Null until the slot's file is decoded
+  RenderSettings settings;
+  bool loaded = false;
+  bool followsMain = true; // Re-rendered with the main settings as they change
+
+  std::atomic<int> lowNote { 0 }, highNote { -1 }; // Empty range = plays on no key
+  std::atomic<juce::uint32> generation { 0 };      // Bumped for every request; a stale job cancels itself
+
+  juce::CriticalSection renderLock; // A superseded job and its replacement never share the renderer
+  std::unique_ptr<ReverseReverbRenderer> renderer; // Per slot, so a settings tweak only re-runs the stages it touches
+
+  RealtimeHandoff<RenderedSample> handoff;
+ };
+
+ // Bumps the slot's generation and queues a job with its current file, source and settings.
+ // Caller holds slot.lock.
+ void queueJob(int slotIndex);
+
+ juce::AudioFormatManager& formatManager;
+ const double maxSeconds;
+ PublishCallback onRenderFinished;
+
+ juce::ThreadPool& pool; // Shared - the destructor removes (and waits for) the bank's own jobs only
+ std::array<Slot, (size_t) maxSlots> slots;
+ std::atomic<juce::uint32> failureCount { 0 };
+ std::atomic<int> numJobs { 0 }; // Slot jobs queued or running
+
+ JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SampleBank)
+};
@@ -0,0 +1,210 @@
+#include "SampleLoader.h"
+
+SampleLoader::SampleLoader(juce::AudioFormatManager& formats, double maxSecondsToAccept, LoadCallback onSampleLoadedToUse)
+ : juce::Thread("ReverseReverb Sample Loader"),
+ formatManager(formats),
+ maxSeconds(maxSecondsToAccept),
+ onSampleLoaded(std::move(onSampleLoadedToUse))
+{
+ startThread();
+}
+
+SampleLoader::~SampleLoader()
+{
+ cancelAll();
+ stopThread(4000);
+}
+
+void SampleLoader::requestLoad(const juce::File& file, Target target)
+{
+ {
+ const juce::ScopedLock sl(requestLock);
+ pendingRequests[(size_t) target] = { file, true };
+ ++latestGenerations[(size_t) target]; // Cancels the decode in flight for this target
+ }
+
+ notify();
+}
+
+void SampleLoader::cancel(Target target)
+{
+ const juce::ScopedLock sl(requestLock);
+ pendingRequests[(size_t) target] = {};
+ ++latestGenerations[(size_t) target];
+}
+
+void SampleLoader::cancelAll()
+{
+ cancel(Target::sample);
+ cancel(Target::impulseResponse);
+}
+
+juce::String SampleLoader::getLastError() const
+{
+ const juce::ScopedLock sl(requestLock);
+ return lastError;
+}
+
+void SampleLoader::fail(const juce::String& reason)
+{
+ DBG("Sample loader: " << reason);
+
+ {
+ const juce::ScopedLock sl(requestLock);
+ lastError = reason;
+ }
+
+ ++failureCount;
+}
+
+void SampleLoader::run()
+{
+ while (!threadShouldExit())
+ {
+ juce::File file;
+ auto target = Target::sample;
+ juce::uint32 generation = 0;
+ bool hasRequest = false;
+
+ {
+ const juce::ScopedLock sl(requestLock);
+
+ // Samples first - the IR only matters once there is something to render
+ for (auto candidate : { Target::sample, Target::impulseResponse })
+ {
+ auto& request = pendingRequests[(size_t) candidate];
+
+ if (request.pending)
+ {
+ file = request.file;
+ target = candidate;
+ generation = latestGenerations[(size_t) candidate].load();
+ request.pending = false;
+ hasRequest = true;
+ break;
+ }
+ }
+ }
+
+ if (!hasRequest)
+ {
+ wait(-1); // Woken by requestLoad() or stopThread()
+ continue;
+ }
+
+ progress = 0.0f;
+ loading = true;
+
+ auto source = decode(file, target, generation);
+
+ loading = false;
+
+ // Handed on only when complete and still the newest request
+ if (source != nullptr && !isStale(target, generation) && onSampleLoaded != nullptr)
+ onSampleLoaded(source, file, target);
+ }
+}
+
+SourceSample::Ptr SampleLoader::decode(const juce::File& file, Target target, juce::uint32 generation)
+{
+ const bool isImpulse = target == Target::impulseResponse;
+
+ juce::String error;
+ auto source = decodeFile(formatManager, decodedCache, file, isImpulse ? maxImpulseResponseSeconds : maxSeconds,
+ [this, target, generation] { return isStale(target, generation); }, &progress, error);
+
+ if (source == nullptr && error.isNotEmpty())
+ fail(isImpulse ? "Impulse response: " + error : error);
+
+ return source;
+}
+
+SourceSample::Ptr SampleLoader::decodeFile(juce::AudioFormatManager& formats, DecodedSampleCache& decodedCache,
+ const juce::File& file, double maxSeconds, const std::function<bool()>& isCancelled,
+ std::atomic<float>* progress, juce::String& error)
+{
+ if (!file.existsAsFile())
+ {
+ error = "File not found: " + file.getFileName();
+ return nullptr;
+ }
+
+ // Before opening a reader - the MP3 reader alone scans the whole file
+ const bool useCache = DecodedSampleCache::isWorthCaching(file);
+ const auto cacheKey = useCache ? decodedCache.makeKey(file) : juce::String();
+
+ if (useCache)
+ {
+ auto cached = decodedCache.find(cacheKey);
+ if (cached != nullptr && cached->getBuffer().getNumSamples() <= (int)(maxSeconds * cached->getSampleRate()))
+ {
+ if (progress != nullptr)
+ *progress = 1.0f;
+ return cached;
+ }
+ }
+
+ std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(file));
+
+ if (reader == nullptr)
+ {
+ error = "Unsupported or unreadable file: " + file.getFileName();
+ return nullptr;
+ }
+
+ // Validate sample rate to prevent division by zero
+ if (reader->sampleRate <= 0.0)
+ {
+ error = "Invalid sample rate in " + file.getFileName();
+ return nullptr;
+ }
+
+ auto duration = reader->lengthInSamples / reader->sampleRate;
+
+ // Long samples are fine - their renders stream from disk
+ if (duration > maxSeconds || duration <= 0.0)
+ {
+ error = "Please load a sample shorter than " + juce::String((int) maxSeconds) + " seconds.\n\nThis file is "
+ + juce::String(duration, 1) + " seconds.";
+ return nullptr;
+ }
+
+ auto numChannels = juce::jmin((int)reader->numChannels, 2); // Max stereo
+ auto numSamples = (int)reader->lengthInSamples;
+
+ if (numSamples <= 0 || numChannels <= 0)
+ {
+ error = "Empty file: " + file.getFileName();
+ return nullptr;
+ }
+
+ juce::AudioBuffer<float> decoded(numChannels, numSamples);
+
+ // Decode in chunks, checking for a newer request between chunks
+ const int chunkSize = 65536;
+
+ for (int pos = 0; pos < numSamples; pos += chunkSize)
+ {
+ if (isCancelled != nullptr && isCancelled())
+ return nullptr;
+
+ const int count = juce::jmin(chunkSize, numSamples - pos);
+
+ if (!reader->read(&decoded, pos, count, pos, true, true))
+ {
+ error = "Failed to read " + file.getFileName();
+ return nullptr;
+ }
+
+ if (progress != nullptr)
+ *progress = (float)(pos + count) / (float)numSamples;
+ }
+
+ DBG("Sample loader: decoded " << file.getFileName() << " (" << numSamples << " samples)");
+ SourceSample::Ptr source = new SourceSample(std::move(decoded), reader->sampleRate);
+
+ if (useCache)
+ decodedCache.store(cacheKey, *source);
+
+ return source;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <functional>
+#include "RenderedSample.h"
+#include "DecodedSampleCache.h"
+
+// One long-lived background thread per processor that decodes dropped or
+// browsed files, so the message thread (and with it the host) never waits on
+// an MP3 or FLAC decode.
+//
+// Like the render worker, requests are coalesced: a newer file cancels the
+// decode in flight, and only a complete decode is ever handed on. Samples and
+// impulse responses queue separately, so loading one never cancels the other
+// (a restored session asks for both at once). Progress and failures are
+// exposed for the editor to poll. Compressed files go through
+// the decoded-PCM cache, so reloading one is an mmap instead of a decode.
+class SampleLoader : private juce::Thread
+{
+public:
+ enum class Target { sample, impulseResponse };
+
+ // Generous - the render cuts a user IR at the tail length anyway
+ static constexpr double maxImpulseResponseSeconds = 30.0;
+
+ using LoadCallback = std::function<void(SourceSample::Ptr, const juce::File&, Target)>;
+
+ // onSampleLoaded is called on the loader thread with every complete decode.
+ // formats must outlive the loader.
+ SampleLoader(juce::AudioFormatManager& formats, double maxSecondsToAccept, LoadCallback onSampleLoaded);
+ ~SampleLoader() override;
+
+ // Any thread: load this file instead of whatever is queued or decoding for the same target
+ void requestLoad(const juce::File& file, Target target = Target::sample);
+
+ // Any thread: drop the queued file for target and cancel its decode in flight
+ void cancel(Target target);
+
+ // Any thread: the same for every target
+ void cancelAll();
+
+ // Any thread: delete every cached decode
+ void purgeDiskCache() const { decodedCache.purge(); }
+
+ bool isLoading() const noexcept { return loading.load(); }
+ float getProgress() const noexcept { return progress.load(); }
+
+ // Bumped on every failed load; getLastError() says why
+ juce::uint32 getFailureCount() const noexcept { return failureCount.load(); }
+ juce::String getLastError() const;
+
+ // Any thread: decodes file whole (through decodedCache for compressed formats). Returns nullptr
+ // if isCancelled() returned true, or on failure with the reason in error. progress may be null.
+ static SourceSample::Ptr decodeFile(juce::AudioFormatManager& formats, DecodedSampleCache& decodedCache,
+ const juce::File& file, double maxSeconds, const std::function<bool()>& isCancelled,
+ std::atomic<float>* progress, juce::String& error);
+
+private:
+ void run() override;
+
+ // Returns nullptr if cancelled or failed (failures are recorded through fail())
+ SourceSample::Ptr decode(const juce::File& file, Target target, juce::uint32 generation);
+ void fail(const juce::String& reason);
+ bool isStale(Target target, juce::uint32 generation) const { return threadShouldExit() || latestGenerations[(size_t) target].load() != generation; }
+
+ juce::AudioFormatManager& formatManager;
+ const double maxSeconds;
+ LoadCallback onSampleLoaded;
+ DecodedSampleCache decodedCache; // Loader thread only
+
+ // Latest request per target - guarded by requestLock
+ struct PendingRequest
+ {
+  juce::File file;
+  bool pending = false;
+ };
+
+ juce::CriticalSection requestLock;
+ std::array<PendingRequest, 2> pendingRequests;
+ juce::String lastError;
+
+ // Bumped for every request per target; a decode whose generation is stale cancels itself
+ std::array<std::atomic<juce::uint32>, 2> latestGenerations {};
+
+ std::atomic<bool> loading { false };
+ std::atomic<float> progress { 0.0f };
+ std::atomic<juce::uint32> failureCount { 0 };
+
+ JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SampleLoader)
+};
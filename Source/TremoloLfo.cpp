@@ -0,0 +1,159 @@
+#include "TremoloLfo.h"
+#include <cmath>
+
+TransportSnapshot TransportSnapshot::read(juce::AudioPlayHead* playHead)
+{
+ TransportSnapshot snapshot;
+
+ if (playHead == nullptr)
+ return snapshot;
+
+ auto positionInfo = playHead->getPosition();
+ if (! positionInfo.hasValue())
+ return snapshot;
+
+ auto bpm = positionInfo->getBpm();
+ if (bpm.hasValue() && *bpm > 0.0)
+ {
+ snapshot.bpm = *bpm;
+ snapshot.hasHostTempo = true;
+ }
+
+ snapshot.hostPlaying = positionInfo->getIsPlaying();
+
+ if (auto ppq = positionInfo->getPpqPosition(); ppq.hasValue())
+ {
+ snapshot.hasPpq = true;
+ snapshot.ppqPosition = *ppq;
+ }
+
+ return snapshot;
+}
+
+// Waveforms over one phasor cycle, returning -1 to 1
+struct TremoloLfo::Sine
+{
+ static float value(float phase) noexcept
+ {
+ // Parabolic sine with one refinement step - within 0.1% of std::sin, no trig
+ const float t = phase < 0.5f ? phase : phase - 1.0f; // -0.5 to 0.5
+ const float y = 8.0f * t - 16.0f * t * std::abs(t);
+ return 0.225f * (y * std::abs(y) - y) + y;
+ }
+};
+
+struct TremoloLfo::Triangle
+{
+ // Same shape as (2 / pi) * asin(sin(phase)), piecewise linear
+ static float value(float phase) noexcept
+ {
+ if (phase < 0.25f) return 4.0f * phase;
+ if (phase < 0.75f) return 2.0f - 4.0f * phase;
+ return 4.0f * phase - 4.0f;
+ }
+};
+
+struct TremoloLfo::Square
+{
+ static float value(float phase) noexcept { return phase < 0.5f ? 1.0f : -1.0f; }
+};
+
+float TremoloLfo::getDivisionMultiplier(int division) noexcept
+{
+ static const float divisionMultipliers[] = {
+ 0.125f, // 0: 2 Bar
+ 0.25f, // 1: 1 Bar
+ 1.0f, // 2: 1/1
+ 2.0f, // 3: 1/2
+ 4.0f, // 4: 1/4
+ 8.0f, // 5: 1/8
+ 16.0f, // 6: 1/16
+ 32.0f, // 7: 1/32
+ 64.0f // 8: 1/64
+ };
+
+ return divisionMultipliers[juce::jlimit(0, 8, division)];
+}
+
+void TremoloLfo::render(TremoloState& state, const Settings& settings, const TransportSnapshot& transport,
+ float* gains, int numSamples, int blockOffset, int sampleLength) noexcept
+{
+ // The waveform switch happens once per run, not per sample
+ switch (settings.waveform)
+ {
+ case 1: renderWith<Triangle>(state, settings, transport, gains, numSamples, blockOffset, sampleLength); break;
+ case 2: renderWith<Square>(state, settings, transport, gains, numSamples, blockOffset, sampleLength); break;
+ default: renderWith<Sine>(state, settings, transport, gains, numSamples, blockOffset, sampleLength); break;
+ }
+}
+
+template <typename Waveform>
+void TremoloLfo::renderWith(TremoloState& state, const Settings& settings, const TransportSnapshot& transport,
+ float* gains, int numSamples, int blockOffset, int sampleLength) noexcept
+{
+ const float sampleRate = (float)settings.sampleRate;
+ const float beatsPerSecond = (float)(transport.bpm / 60.0);
+
+ // Convert LFO from [-1, 1] to gain multiplier [1-depth, 1]: gain = offset + scale * lfo
+ const float scale = settings.depth * 0.5f;
+ const float offset = 1.0f - scale;
+
+ float phase = state.phase;
+
+ if (settings.rateRampEnabled && sampleLength > 0)
+ {
+ // Rate Ramp (works with or without sync!): the division moves from start to end over the sample
+ const float startMultiplier = getDivisionMultiplier(settings.startDivision);
+ const float endMultiplier = getDivisionMultiplier(settings.endDivision);
+ const float increment0 = beatsPerSecond * startMultiplier / sampleRate;
+ const float incrementSlope = beatsPerSecond * (endMultiplier - startMultiplier) / (sampleRate * (float)sampleLength);
+
+ int counter = state.sampleCounter;
+ for (int i = 0; i < numSamples; ++i)
+ {
+ gains[i] = offset + scale * Waveform::value(phase);
+
+ phase += increment0 + incrementSlope * (float)juce::jlimit(0, sampleLength, counter);
+ phase -= std::floor(phase);
+
+ // Reset counter when we reach the end of the sample
+ if (++counter >= sampleLength)
+ counter = 0;
+ }
+
+ state.sampleCounter = counter;
+ }
+ else
+ {
+ float frequency = settings.rate; // Free-running mode
+
+ if (settings.syncEnabled)
+ {
+ // Host Sync mode (without rate ramp)
+ const float divisionMultiplier = getDivisionMultiplier(settings.syncDivision);
+ frequency = beatsPerSecond * divisionMultiplier;
+
+ // Re-sync the phase to the transport whenever the host position moves on,
+ // at the exact position this run starts
+ if (transport.hostPlaying && transport.hasHostTempo && transport.hasPpq && transport.ppqPosition != state.lastPpq)
+ {
+ const double runPpq = transport.ppqPosition + blockOffset * (transport.bpm / 60.0) / settings.sampleRate;
+ const double cycles = runPpq * divisionMultiplier;
+ phase = (float)(cycles - std::floor(cycles));
+ state.lastPpq = transport.ppqPosition;
+ }
+ }
+
+ const float increment = frequency / sampleRate;
+ for (int i = 0; i < numSamples; ++i)
+ {
+ gains[i] = offset + scale * Waveform::value(phase);
+
+ phase += increment;
+ if (phase >= 1.0f)
+ phase -= std::floor(phase);
+ }
+ }
+
+ state.phase = phase;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+// Host transport, read once per block instead of once per sample
+struct TransportSnapshot
+{
+ double bpm = 120.0;        // Host tempo, 120 when the host has none
+ bool hasHostTempo = false;
+ bool hostPlaying = false;
+ bool hasPpq = false;
+ double ppqPosition = 0.0;  // At the first sample of the block
+
+ static TransportSnapshot read(juce::AudioPlayHead* playHead);
+};
+
+// Per-voice tremolo LFO state, so overlapping voices each run their own LFO
+struct TremoloState
+{
+ float phase = 0.0f;    // Phasor, 0 to 1 per LFO cycle
+ int sampleCounter = 0; // Samples into the voice, for Rate Ramp
+ double lastPpq = -1.0; // Last host position the phase was synced to
+};
+
+// Block-rate tremolo: a phasor drives a waveform that is picked at compile time,
+// and the gains for a whole run go into a buffer the caller applies with one
+// vector multiply. No trig, fmod or playhead calls per sample.
+class TremoloLfo
+{
+public:
+ // Snapshot of the processor's tremolo parameters, taken once per block
+ struct Settings
+ {
+  float depth = 0.5f;          // 0.0 to 1.0
+  float rate = 4.0f;           // Hz, free-running mode
+  int waveform = 0;            // 0=Sine, 1=Triangle, 2=Square
+  bool syncEnabled = false;
+  int syncDivision = 2;
+  bool rateRampEnabled = false;
+  int startDivision = 5;
+  int endDivision = 7;
+  double sampleRate = 44100.0;
+ };
+
+ // LFO cycles per beat for a division index (0=2 Bar ... 8=1/64)
+ static float getDivisionMultiplier(int division) noexcept;
+
+ // Writes the gain for the next numSamples of one voice (between 1 - depth and 1)
+ // and advances its state. blockOffset is where the run starts within the block,
+ // sampleLength the render length the Rate Ramp progresses over.
+ static void render(TremoloState& state, const Settings& settings, const TransportSnapshot& transport,
+                    float* gains, int numSamples, int blockOffset, int sampleLength) noexcept;
+
+private:
+ struct Sine;
+ struct Triangle;
+ struct Square;
+
+ template <typename Waveform>
+ static void renderWith(TremoloState& state, const Settings& settings, const TransportSnapshot& transport,
+                        float* gains, int numSamples, int blockOffset, int sampleLength) noexcept;
+};
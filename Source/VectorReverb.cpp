@@ -0,0 +1,279 @@
+#include "VectorReverb.h"
+
+namespace
+{
+ // Same tunings as juce::Reverb (and the original Freeverb), in samples at 44.1kHz
+ const short combTunings[] = { 1116, 1188, 1277, 1356, 1422, 1491, 1557, 1617 };
+ const short allPassTunings[] = { 556, 441, 341, 225 };
+ const int stereoSpread = 23;
+}
+
+VectorReverb::VectorReverb()
+{
+ // Same start-up sequence as juce::Reverb, so the parameter ramps start from the same place
+ setParameters(Parameters());
+ setSampleRate(44100.0);
+}
+
+void VectorReverb::setParameters(const Parameters& newParams)
+{
+ const float wetScaleFactor = 3.0f;
+ const float dryScaleFactor = 2.0f;
+
+ const float wet = newParams.wetLevel * wetScaleFactor;
+ dryGain.setTargetValue(newParams.dryLevel * dryScaleFactor);
+ wetGain1.setTargetValue(0.5f * wet * (1.0f + newParams.width));
+ wetGain2.setTargetValue(0.5f * wet * (1.0f - newParams.width));
+
+ const bool frozen = newParams.freezeMode >= 0.5f;
+ gain = frozen ? 0.0f : 0.015f;
+ parameters = newParams;
+
+ const float roomScaleFactor = 0.28f;
+ const float roomOffset = 0.7f;
+ const float dampScaleFactor = 0.4f;
+
+ damping.setTargetValue(frozen ? 0.0f : parameters.damping * dampScaleFactor);
+ feedback.setTargetValue(frozen ? 1.0f : parameters.roomSize * roomScaleFactor + roomOffset);
+}
+
+void VectorReverb::setSampleRate(double sampleRate)
+{
+ jassert(sampleRate > 0);
+
+ const int intSampleRate = (int) sampleRate;
+
+ combRingLength = 1;
+ shortestCombSize = maxRunLength;
+ for (int lane = 0; lane < numCombLanes; ++lane)
+ {
+ const int tuning = combTunings[lane % numCombs] + (lane < numCombs ? 0 : stereoSpread);
+ combSize[(size_t) lane] = juce::jmax(1, (intSampleRate * tuning) / 44100);
+ combRingLength = juce::jmax(combRingLength, combSize[(size_t) lane]);
+ shortestCombSize = juce::jmin(shortestCombSize, combSize[(size_t) lane]);
+ }
+
+ combRing.assign((size_t) (combRingLength * numCombRegisters), Vec::expand(0.0f));
+ combWriteRow = 0;
+
+ for (int channel = 0; channel < 2; ++channel)
+ {
+ for (int i = 0; i < numAllPasses; ++i)
+ {
+ const int tuning = allPassTunings[i] + (channel == 0 ? 0 : stereoSpread);
+ allPassStorage[channel][i].assign((size_t) juce::jmax(1, (intSampleRate * tuning) / 44100), 0.0f);
+ allPassIndex[channel][i] = 0;
+ }
+ }
+
+ const double smoothTime = 0.01;
+ damping.reset(sampleRate, smoothTime);
+ feedback.reset(sampleRate, smoothTime);
+ dryGain.reset(sampleRate, smoothTime);
+ wetGain1.reset(sampleRate, smoothTime);
+ wetGain2.reset(sampleRate, smoothTime);
+
+ reset();
+}
+
+void VectorReverb::reset()
+{
+ std::fill(combRing.begin(), combRing.end(), Vec::expand(0.0f));
+
+ for (auto& last : combLast)
+ last = Vec::expand(0.0f);
+
+ for (int channel = 0; channel < 2; ++channel)
+ for (auto& line : allPassStorage[channel])
+ std::fill(line.begin(), line.end(), 0.0f);
+}
+
+int VectorReverb::getCombReadRow(int lane) const noexcept
+{
+ // Lane l reads what was written combSize[l] samples ago
+ const int row = combWriteRow - combSize[(size_t) lane];
+ return row < 0 ? row + combRingLength : row;
+}
+
+int VectorReverb::getCombRunLength(int numActiveLanes, int maxSamples) const noexcept
+{
+ // Longest run in which neither the write row, any lane's read row nor any allpass index wraps,
+ // and which is no longer than the shortest comb delay (under 256 samples below about 10.1kHz).
+ // The allpass bound implies that with the Freeverb tunings, but processCombs() relies on it.
+ int run = juce::jmin(maxSamples, shortestCombSize, combRingLength - combWriteRow);
+ for (int lane = 0; lane < numActiveLanes; ++lane)
+ run = juce::jmin(run, combRingLength - getCombReadRow(lane));
+
+ for (int channel = 0; channel < (numActiveLanes > numCombs ? 2 : 1); ++channel)
+ for (int i = 0; i < numAllPasses; ++i)
+ run = juce::jmin(run, (int) allPassStorage[channel][i].size() - allPassIndex[channel][i]);
+
+ return run;
+}
+
+template <int numActiveLanes>
+void VectorReverb::processCombs(const float* input, const float* damp, const float* feedbackLevel,
+ float* const* laneSums, int numSamples) noexcept
+{
+ constexpr int numRegisters = (numActiveLanes + (int) Vec::SIMDNumElements - 1) / (int) Vec::SIMDNumElements;
+ constexpr int lanesPerChannel = numCombs;
+ float* ring = reinterpret_cast<float*>(combRing.data());
+
+ // Gather the run's comb outputs into lane-ordered rows, so the recursion
+ // below only does aligned vector loads and stores. A run is never longer
+ // than the shortest delay, so nothing read here is written in the same run.
+ for (int lane = 0; lane < numActiveLanes; ++lane)
+ {
+ const float* source = ring + getCombReadRow(lane) * numPaddedLanes + lane;
+ for (int i = 0; i < numSamples; ++i)
+ laneRows[i * numPaddedLanes + lane] = source[i * numPaddedLanes];
+ }
+
+ // Working copy on the stack so the compiler can keep the state in registers
+ Vec last[numCombRegisters];
+ for (int r = 0; r < numCombRegisters; ++r)
+ last[r] = combLast[r];
+
+ float* writeRow = ring + combWriteRow * numPaddedLanes;
+
+ for (int i = 0; i < numSamples; ++i)
+ {
+ const float* row = laneRows + i * numPaddedLanes;
+ const float d = damp[i];
+ const float oneMinusDamp = 1.0f - d;
+ const float fb = feedbackLevel[i];
+ const float in = input[i];
+
+ for (int r = 0; r < numRegisters; ++r)
+ {
+ const auto output = Vec::fromRawArray(row + r * (int) Vec::SIMDNumElements);
+
+ // last = output * (1 - damp) + last * damp, then the input plus feedback goes back in the line
+ last[r] = output * oneMinusDamp + last[r] * d;
+ last[r] += 0.1f; last[r] -= 0.1f; // JUCE_UNDENORMALISE
+
+ auto temp = last[r] * fb + in;
+ temp += 0.1f; temp -= 0.1f; // JUCE_UNDENORMALISE
+ temp.copyToRawArray(writeRow + i * numPaddedLanes + r * (int) Vec::SIMDNumElements);
+ }
+
+ // Each channel's comb sum, in the same order as juce::Reverb so the rounding matches
+ for (int channel = 0; channel * lanesPerChannel < numActiveLanes; ++channel)
+ {
+ float sum = 0;
+ for (int j = 0; j < lanesPerChannel; ++j)
+ sum += row[channel * lanesPerChannel + j];
+
+ laneSums[channel][i] = sum;
+ }
+ }
+
+ for (int r = 0; r < numCombRegisters; ++r)
+ combLast[r] = last[r];
+
+ combWriteRow += numSamples;
+ if (combWriteRow >= combRingLength)
+ combWriteRow = 0;
+}
+
+void VectorReverb::processAllPasses(int channel, float* samples, int numSamples) noexcept
+{
+ // A run never wraps an allpass line either, so each stage reads values written
+ // before the run and the whole stage is one loop the compiler can vectorise
+ for (int i = 0; i < numAllPasses; ++i)
+ {
+ auto& index = allPassIndex[channel][i];
+ float* line = allPassStorage[channel][i].data() + index;
+
+ for (int n = 0; n < numSamples; ++n)
+ {
+ const float bufferedValue = line[n];
+ float temp = samples[n] + (bufferedValue * 0.5f);
+ JUCE_UNDENORMALISE(temp);
+ line[n] = temp;
+ samples[n] = bufferedValue - samples[n];
+ }
+
+ index += numSamples;
+ if (index >= (int) allPassStorage[channel][i].size())
+ index = 0;
+ }
+}
+
+void VectorReverb::processStereo(float* left, float* right, int numSamples) noexcept
+{
+ jassert(left != nullptr && right != nullptr);
+
+ int done = 0;
+ while (done < numSamples)
+ {
+ const int run = getCombRunLength(numCombLanes, juce::jmin(numSamples - done, maxRunLength));
+
+ for (int i = 0; i < run; ++i)
+ {
+ runInput[i] = (left[done + i] + right[done + i]) * gain;
+ runDamping[i] = damping.getNextValue();
+ runFeedback[i] = feedback.getNextValue();
+ }
+
+ float* const sums[] = { runSumLeft, runSumRight };
+ processCombs<numCombLanes>(runInput, runDamping, runFeedback, sums, run);
+
+ processAllPasses(0, runSumLeft, run);
+ processAllPasses(1, runSumRight, run);
+
+ for (int i = 0; i < run; ++i)
+ {
+ const float outL = runSumLeft[i];
+ const float outR = runSumRight[i];
+
+ const float dry = dryGain.getNextValue();
+ const float wet1 = wetGain1.getNextValue();
+ const float wet2 = wetGain2.getNextValue();
+
+ auto& l = left[done + i];
+ auto& r = right[done + i];
+ const float newLeft = outL * wet1 + outR * wet2 + l * dry;
+ r = outR * wet1 + outL * wet2 + r * dry;
+ l = newLeft;
+ }
+
+ done += run;
+ }
+}
+
+void VectorReverb::processMono(float* samples, int numSamples) noexcept
+{
+ jassert(samples != nullptr);
+
+ int done = 0;
+ while (done < numSamples)
+ {
+ // Left comb lanes only
+ const int run = getCombRunLength(numCombs, juce::jmin(numSamples - done, maxRunLength));
+
+ for (int i = 0; i < run; ++i)
+ {
+ runInput[i] = samples[done + i] * gain;
+ runDamping[i] = damping.getNextValue();
+ runFeedback[i] = feedback.getNextValue();
+ }
+
+ float* const sums[] = { runSumLeft };
+ processCombs<numCombs>(runInput, runDamping, runFeedback, sums, run);
+
+ processAllPasses(0, runSumLeft, run);
+
+ for (int i = 0; i < run; ++i)
+ {
+ const float output = runSumLeft[i];
+
+ const float dry = dryGain.getNextValue();
+ const float wet1 = wetGain1.getNextValue();
+
+ samples[done + i] = output * wet1 + samples[done + i] * dry;
+ }
+
+ done += run;
+ }
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <vector>
+
+// Freeverb with the same topology, tunings and parameter smoothing as juce::Reverb,
+// built for the offline render.
+//
+// The 16 comb filters (8 per channel) run side by side in SIMD lanes
+// (juce::dsp::SIMDRegister - SSE, AVX or NEON, whatever the build targets).
+// All comb delay lines share one lane-interleaved ring with a common write row;
+// each lane reads its own distance behind it. Samples are processed in runs that
+// no row index wraps inside and that are no longer than the shortest comb delay: the run's comb outputs are gathered once, then every
+// damping and feedback update and every write is a whole-row vector operation.
+// The allpass chains run a whole stage over a run at a time. There is no
+// per-sample modulo like in juce::Reverb.
+//
+// Tolerance: the arithmetic and the order of every sum match juce::Reverb, so the
+// output is bit-identical when the compiler does not contract multiply-adds into
+// FMAs. With FMA contraction the difference stays below 1e-6 of full scale.
+class VectorReverb
+{
+public:
+ using Parameters = juce::Reverb::Parameters;
+
+ VectorReverb();
+
+ void setParameters(const Parameters& newParams);
+ const Parameters& getParameters() const noexcept { return parameters; }
+
+ // Resizes the delay lines for this rate and resets the parameter ramps, like juce::Reverb
+ void setSampleRate(double sampleRate);
+ void reset();
+
+ void processStereo(float* left, float* right, int numSamples) noexcept;
+ void processMono(float* samples, int numSamples) noexcept;
+
+private:
+ using Vec = juce::dsp::SIMDRegister<float>;
+
+ static constexpr int numCombs = 8;
+ static constexpr int numAllPasses = 4;
+ static constexpr int numCombLanes = 2 * numCombs; // Left combs, then right combs
+ static constexpr int numCombRegisters = (int) ((numCombLanes + Vec::SIMDNumElements - 1) / Vec::SIMDNumElements);
+ static constexpr int numPaddedLanes = numCombRegisters * (int) Vec::SIMDNumElements;
+
+ static constexpr int maxRunLength = 256;
+
+ int getCombReadRow(int lane) const noexcept;
+ int getCombRunLength(int numActiveLanes, int maxSamples) const noexcept;
+
+ // Runs comb lanes [0, numActiveLanes) over a run that no delay line wraps in,
+ // writing each channel's comb sum (8 lanes per channel) to laneSums
+ template <int numActiveLanes>
+ void processCombs(const float* input, const float* damp, const float* feedbackLevel,
+ float* const* laneSums, int numSamples) noexcept;
+ void processAllPasses(int channel, float* samples, int numSamples) noexcept;
+
+ Parameters parameters;
+ float gain = 0.015f;
+
+ // Comb delay lines: combRingLength rows of numPaddedLanes floats, lane l delayed by combSize[l] rows
+ std::vector<Vec> combRing; // Vec storage keeps every row SIMD-aligned
+ int combRingLength = 1;
+ int combWriteRow = 0;
+ std::array<int, numCombLanes> combSize {};
+ int shortestCombSize = 1; // A run never reads a row it writes
+ Vec combLast[numCombRegisters];
+
+ // Per-run inputs, parameter ramps and comb sums
+ float runInput[maxRunLength], runDamping[maxRunLength], runFeedback[maxRunLength];
+ float runSumLeft[maxRunLength], runSumRight[maxRunLength];
+
+ // Lane-ordered comb outputs for one run (SIMD-aligned)
+ alignas (32) float laneRows[maxRunLength * numPaddedLanes];
+
+ std::vector<float> allPassStorage[2][numAllPasses];
+ int allPassIndex[2][numAllPasses] {};
+
+ juce::SmoothedValue<float> damping, feedback, dryGain, wetGain1, wetGain2;
+
+ JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VectorReverb)
+};
@@ -0,0 +1,80 @@
+#include "VoicePlayback.h"
+
+void VoicePlayback::render(SampleVoice& voice, const RenderedSample& rendered, const FadeEnvelope* fades, const Settings& settings,
+ juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+ const auto& processedSample = rendered.getBuffer();
+ auto numChannels = juce::jmin(buffer.getNumChannels(), rendered.getNumChannels());
+ auto totalSamples = rendered.getNumSamples();
+ const float releaseSamples = (float)juce::jmax(1, settings.releaseSamples);
+
+ // One gain per sample for a run, built once and shared by every channel
+ constexpr int maxRunLength = 256;
+ float gains[maxRunLength], tremoloGains[maxRunLength];
+
+ int done = 0;
+ while (done < numSamples)
+ {
+ // The run ends at the block, the end of the sample or the end of the release -
+ // all known up front, so the loops below have no end-of-sample branch
+ int run = juce::jmin(maxRunLength, numSamples - done, totalSamples - voice.position);
+ if (voice.isReleasing())
+ run = juce::jmin(run, voice.releaseRemaining);
+
+ if (voice.position < 0 || run <= 0)
+ {
+ voice.active = false;
+ return;
+ }
+
+ juce::FloatVectorOperations::fill(gains, voice.velocityGain, run);
+ // Fades come from the precomputed tables
+ if (fades != nullptr && fades->getNumSamples() > 0)
+ {
+ if (fades->getNumSamples() == totalSamples)
+ {
+ fades->applyTo(gains, voice.position, run);
+ }
+ else
+ {
+ // A new render and its fade tables can land a block apart - map positions across
+ for (int i = 0; i < run; ++i)
+ gains[i] *= fades->getGain((int)((juce::int64)(voice.position + i) * fades->getNumSamples() / totalSamples));
+ }
+ }
+
+ // Tremolo, with this voice's own LFO - one gain buffer, one vector multiply
+ if (settings.tremoloEnabled)
+ {
+ TremoloLfo::render(voice.tremolo, settings.tremolo, settings.transport, tremoloGains, run, startSample + done, totalSamples);
+ juce::FloatVectorOperations::multiply(gains, tremoloGains, run);
+ }
+
+ // Linear declick fade after a note-off or a steal
+ if (voice.isReleasing())
+ {
+ for (int i = 0; i < run; ++i)
+ gains[i] *= (float)(voice.releaseRemaining - i) / releaseSamples;
+ }
+
+ for (int channel = 0; channel < numChannels; ++channel)
+ juce::FloatVectorOperations::addWithMultiply(buffer.getWritePointer(channel, startSample + done),
+ processedSample.getReadPointer(channel, voice.position),
+ gains, run);
+
+ voice.position += run;
+ done += run;
+
+ if (voice.isReleasing() && (voice.releaseRemaining -= run) == 0)
+ {
+ voice.active = false;
+ return;
+ }
+
+ if (voice.position >= totalSamples)
+ {
+ voice.active = false;
+ return;
+ }
+ }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "RenderedSample.h"
+#include "FadeEnvelope.h"
+#include "VoicePool.h"
+
+// Playback of one voice from a finished render: velocity, the fade tables, the
+// voice's own tremolo and the release declick, built as one gain span per run
+// and mixed in with FloatVectorOperations. Nothing here allocates or locks, so
+// it runs on the audio thread.
+class VoicePlayback
+{
+public:
+ // Snapshot of the playback parameters, taken once per block
+ struct Settings
+ {
+  bool tremoloEnabled = false;
+  TremoloLfo::Settings tremolo;
+  TransportSnapshot transport; // Host transport at the start of the block (tremolo sync)
+  int releaseSamples = 220;    // Declick fade after a note-off or a steal
+ };
+
+ // Adds the voice's output to buffer[startSample, startSample + numSamples) and advances it.
+ // fades may be null (no fades); the voice goes inactive at the end of the render or its release.
+ static void render(SampleVoice& voice, const RenderedSample& rendered, const FadeEnvelope* fades, const Settings& settings,
+                    juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+};
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include "TremoloLfo.h"
+
+// One playback cursor into the current render
+struct SampleVoice
+{
+ bool active = false;
+ int note = -1;              // MIDI note that started the voice, -1 for the editor's play button
+ int slot = -1;              // Sample bank slot it plays, -1 for the main sample
+ float velocityGain = 1.0f;
+ int position = 0;           // Read position in the render
+ juce::uint32 startOrder = 0; // Higher = started later, for stealing the oldest voice
+ int releaseRemaining = 0;   // > 0 while fading out after a note-off or a steal
+ TremoloState tremolo;
+
+ bool isReleasing() const noexcept { return releaseRemaining > 0; }
+};
+
+// Fixed pool of sample voices, owned by the audio thread. Everything lives in a
+// std::array, so starting, stealing and releasing voices never allocates.
+//
+// At most maxSoundingVoices play at full level. A note-on past that releases the
+// oldest sounding voice (a short declick fade) instead of cutting it, and the
+// spare slots hold those fades, so a drum roll never chops the previous swell.
+class VoicePool
+{
+public:
+ static constexpr int maxSoundingVoices = 16;
+ static constexpr int maxVoices = 24; // Sounding voices plus room for releasing ones
+
+ VoicePool() = default;
+
+ // Declick fade length, set from prepareToPlay()
+ void setReleaseSamples(int numSamples) noexcept { releaseSamples = juce::jmax(1, numSamples); }
+ int getReleaseSamples() const noexcept { return releaseSamples; }
+
+ // Starts a voice from the top of the render, stealing if the pool is full.
+ // Every bank slot shares the pool, so a full kit costs no more voices than one sample.
+ SampleVoice& startVoice(int note, float velocityGain, int slot = -1) noexcept
+ {
+  if (getNumSoundingVoices() >= maxSoundingVoices)
+   if (auto* oldest = findOldestSoundingVoice())
+    release(*oldest);
+
+  auto& voice = findFreeVoice();
+  voice = SampleVoice();
+  voice.active = true;
+  voice.note = note;
+  voice.velocityGain = velocityGain;
+  voice.slot = slot;
+  voice.startOrder = ++startCounter;
+  return voice;
+ }
+
+ // Fades out every sounding voice started by this note
+ void noteOff(int note) noexcept
+ {
+  for (auto& voice : voices)
+   if (voice.active && ! voice.isReleasing() && voice.note == note)
+    release(voice);
+ }
+
+ // Hard stop (new sample loaded, playback reset)
+ void stopAll() noexcept
+ {
+  for (auto& voice : voices)
+   voice.active = false;
+ }
+
+ // Hard stop for the voices of one slot (-1 = the main sample)
+ void stopSlot(int slot) noexcept
+ {
+  for (auto& voice : voices)
+   if (voice.slot == slot)
+    voice.active = false;
+ }
+
+ void release(SampleVoice& voice) noexcept
+ {
+  if (voice.active && ! voice.isReleasing())
+   voice.releaseRemaining = releaseSamples;
+ }
+
+ bool isAnyVoiceActive() const noexcept
+ {
+  for (auto& voice : voices)
+   if (voice.active)
+    return true;
+
+  return false;
+ }
+
+ // The newest sounding voice of a slot (-1 = the main sample, the one the editor's playhead follows)
+ const SampleVoice* getNewestVoice(int slot = -1) const noexcept
+ {
+  const SampleVoice* newest = nullptr;
+  for (auto& voice : voices)
+   if (voice.active && ! voice.isReleasing() && voice.slot == slot && (newest == nullptr || voice.startOrder > newest->startOrder))
+    newest = &voice;
+
+  return newest;
+ }
+
+ SampleVoice* begin() noexcept { return voices.data(); }
+ SampleVoice* end() noexcept { return voices.data() + voices.size(); }
+
+private:
+ int getNumSoundingVoices() const noexcept
+ {
+  int count = 0;
+  for (auto& voice : voices)
+   if (voice.active && ! voice.isReleasing())
+    ++count;
+
+  return count;
+ }
+
+ SampleVoice* findOldestSoundingVoice() noexcept
+ {
+  SampleVoice* oldest = nullptr;
+  for (auto& voice : voices)
+   if (voice.active && ! voice.isReleasing() && (oldest == nullptr || voice.startOrder < oldest->startOrder))
+    oldest = &voice;
+
+  return oldest;
+ }
+
+ SampleVoice& findFreeVoice() noexcept
+ {
+  for (auto& voice : voices)
+   if (! voice.active)
+    return voice;
+
+  // Every slot busy: reuse the release closest to silent
+  auto* quietest = &voices[0];
+  for (auto& voice : voices)
+   if (voice.isReleasing() && (! quietest->isReleasing() || voice.releaseRemaining < quietest->releaseRemaining))
+    quietest = &voice;
+
+  return *quietest;
+ }
+
+ std::array<SampleVoice, maxVoices> voices {};
+ int releaseSamples = 220;
+ juce::uint32 startCounter = 0;
+
+ JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VoicePool)
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <functional>
+#include <vector>
+
+// Min/max overview of a render for the waveform display: one column per pixel,
+// each the range of the channel average over the samples that pixel covers.
+class WaveformSummary
+{
+public:
+ // Fills gains[0, count) with the gain for samples [start, start + count)
+ using GainFunction = std::function<void (int start, int count, float* gains)>;
+
+ static constexpr int blockSize = 512;
+
+ // Resizes mins and maxs to width and fills them (both cleared for an empty buffer or width).
+ // The buffer is read once, in order, a block at a time, so a streamed render is summarised
+ // straight from its mapping; getGains (optional) scales each block before it is measured.
+ static void compute (const juce::AudioBuffer<float>& buffer, int width, std::vector<float>& mins, std::vector<float>& maxs,
+                      const GainFunction& getGains = nullptr)
+ {
+  if (width <= 0 || buffer.getNumSamples() == 0 || buffer.getNumChannels() == 0)
+  {
+   mins.clear();
+   maxs.clear();
+   return;
+  }
+
+  auto numSamples = buffer.getNumSamples();
+  auto numChannels = buffer.getNumChannels();
+  float samplesPerPixel = (float) numSamples / (float) width;
+
+  mins.assign ((size_t) width, 0.0f);
+  maxs.assign ((size_t) width, 0.0f);
+
+  auto getPixelEnd = [&] (int px) { return juce::jmin ((int) ((px + 1) * samplesPerPixel), numSamples); };
+
+  // Pixels tile the buffer in order (one's end is the next one's start), so walk both together
+  int px = 0;
+  int pixelEnd = getPixelEnd (0);
+  const int lastSample = getPixelEnd (width - 1);
+  float gains[blockSize];
+
+  for (int start = 0; start < lastSample; start += blockSize)
+  {
+   const int count = juce::jmin (blockSize, lastSample - start);
+
+   if (getGains != nullptr)
+    getGains (start, count, gains);
+
+   for (int i = 0; i < count; ++i)
+   {
+    const int s = start + i;
+    while (s >= pixelEnd)
+     pixelEnd = getPixelEnd (++px);
+
+    float v = 0.0f;
+    for (int ch = 0; ch < numChannels; ++ch)
+     v += buffer.getSample (ch, s);
+    v /= numChannels;
+
+    if (getGains != nullptr)
+     v *= gains[i];
+
+    mins[(size_t) px] = juce::jmin (mins[(size_t) px], v);
+    maxs[(size_t) px] = juce::jmax (maxs[(size_t) px], v);
+   }
+  }
+ }
+};
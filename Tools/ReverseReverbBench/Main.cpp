@@ -0,0 +1,468 @@
+#include <JuceHeader.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include "ReverseReverbRenderer.h"
+#include "FadeEnvelope.h"
+#include "VoicePool.h"
+#include "VoicePlayback.h"
+#include "WaveformSummary.h"
+#include "RenderExport.h"
+#include "CpuLoadMeter.h"
+#include "VectorReverb.h"
+
+// Benchmarks for the DSP core, written as JSON so runs can be compared across
+// machines and builds.
+//
+// Every result carries a real-time factor - seconds of processing per second of
+// audio, so 0.01 is 1% of one core and 1 / realTimeFactor is roughly how many
+// instances that core can carry - and the time per sample frame in ns.
+// Block-size cases add the per-block spread CpuLoadMeter reports for the plugin
+// (p99Load, maxLoad, overruns), since spikes, not averages, cause dropouts.
+// The reverb case also checks VectorReverb against juce::Reverb and fails the
+// run if they differ by more than the documented tolerance.
+
+namespace
+{
+ const char* const usage =
+  "Usage: ReverseReverbBench [options]\n"
+  "\n"
+  "Times the render, the voice playback, the waveform summary and the export, checks\n"
+  "the vectorised reverb against juce::Reverb, and prints the results as JSON\n"
+  "(progress goes to stderr). Exits with 1 if the reverb check fails.\n"
+  "\n"
+  "  --out=<file>            Write the JSON here instead of stdout\n"
+  "  --only=<names>          Comma-separated subset of render,block,waveform,export,reverb\n"
+  "  --iterations=<n>        Timed runs per case, the median is reported (default 3)\n"
+  "  --source-seconds=<s>    Length of the synthetic source (default 4)\n"
+  "  --block-seconds=<s>     Audio played per block-size case (default 20)\n"
+  "  --voices=<n>            Overlapping voices in the block-size cases (default 4)\n";
+
+ const double sourceRate = 44100.0;
+ const double sampleRates[] = { 44100.0, 48000.0, 96000.0 };
+ const int blockSizes[] = { 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+ const int waveformWidth = 800;
+
+ // The reverb check also covers rates whose shortest comb delay is under a 256-sample run
+ const double reverbCheckRates[] = { 8000.0, 11025.0, 22050.0, 44100.0, 48000.0, 96000.0, 192000.0 };
+ const float reverbTolerance = 1.0e-6f; // VectorReverb's documented bound, of full scale
+
+ struct Timing
+ {
+  double seconds = 0.0;    // Median
+  double minSeconds = 0.0;
+  int iterations = 0;
+ };
+
+ // Runs body iterations times; body returns the seconds it spent on the timed part
+ template <typename Body>
+ Timing measure (int iterations, Body&& body)
+ {
+  std::vector<double> times;
+
+  for (int i = 0; i < iterations; ++i)
+   times.push_back (body());
+
+  std::sort (times.begin(), times.end());
+
+  Timing timing;
+  timing.seconds = times[times.size() / 2];
+  timing.minSeconds = times.front();
+  timing.iterations = iterations;
+  return timing;
+ }
+
+ double secondsSince (juce::int64 startTicks)
+ {
+  return juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+ }
+
+ // Deterministic stereo source: a chord under a decaying noise burst, so the reverb has transients and a body
+ SourceSample::Ptr makeSource (double seconds)
+ {
+  const int numSamples = juce::jmax (1, (int) (seconds * sourceRate));
+  juce::AudioBuffer<float> audio (2, numSamples);
+  juce::Random random (42);
+
+  for (int i = 0; i < numSamples; ++i)
+  {
+   const double t = i / sourceRate;
+   const auto chord = (float) (0.2 * (std::sin (juce::MathConstants<double>::twoPi * 220.0 * t)
+                                    + std::sin (juce::MathConstants<double>::twoPi * 277.2 * t)
+                                    + std::sin (juce::MathConstants<double>::twoPi * 329.6 * t)));
+   const auto burst = (float) std::exp (-6.0 * t);
+
+   for (int channel = 0; channel < 2; ++channel)
+    audio.setSample (channel, i, chord * (1.0f - burst) + burst * (random.nextFloat() * 2.0f - 1.0f));
+  }
+
+  return new SourceSample (std::move (audio), sourceRate);
+ }
+
+ juce::DynamicObject::Ptr makeResult (const juce::String& benchmark, const Timing& timing, juce::int64 numSamples, double sampleRate)
+ {
+  const double audioSeconds = numSamples / sampleRate;
+
+  juce::DynamicObject::Ptr result = new juce::DynamicObject();
+  result->setProperty ("benchmark", benchmark);
+  result->setProperty ("sampleRate", sampleRate);
+  result->setProperty ("iterations", timing.iterations);
+  result->setProperty ("samples", numSamples);
+  result->setProperty ("audioSeconds", audioSeconds);
+  result->setProperty ("seconds", timing.seconds);
+  result->setProperty ("minSeconds", timing.minSeconds);
+  result->setProperty ("realTimeFactor", timing.seconds / juce::jmax (audioSeconds, 1.0e-9));
+  result->setProperty ("nsPerSample", timing.seconds * 1.0e9 / (double) juce::jmax ((juce::int64) 1, numSamples));
+  return result;
+ }
+
+ void logResult (const juce::DynamicObject& result, const juce::String& description)
+ {
+  std::cerr << result.getProperty ("benchmark").toString() << " " << description << ": "
+            << juce::String ((double) result.getProperty ("realTimeFactor"), 5) << " x real time, "
+            << juce::String ((double) result.getProperty ("nsPerSample"), 1) << " ns/sample" << std::endl;
+ }
+
+ // Full renders from a cold renderer (no memoized stages) for every tail division, rate and transition mode
+ void benchmarkRender (juce::ThreadPool& renderPool, const SourceSample::Ptr& source, int iterations, juce::Array<juce::var>& results)
+ {
+  ReverseReverbRenderer renderer (renderPool);
+
+  for (auto sampleRate : sampleRates)
+  {
+   // Resampling is done once up front, like the render worker's per-rate cache
+   auto sourceAtRate = source->getAtSampleRate (sampleRate);
+
+   for (int tailDivision = 0; tailDivision <= 8; ++tailDivision)
+   {
+    for (bool transition : { false, true })
+    {
+     RenderSettings settings;
+     settings.tailSeconds = RenderSettings::getTailSeconds (tailDivision, 120.0);
+     settings.transitionMode = transition;
+     settings.sampleRate = sampleRate;
+
+     int renderLength = 0;
+     auto timing = measure (iterations, [&]
+     {
+      renderer.clearCache();
+      const auto start = juce::Time::getHighResolutionTicks();
+      auto rendered = renderer.render (sourceAtRate, settings);
+      const auto seconds = secondsSince (start);
+
+      renderLength = rendered != nullptr ? rendered->getNumSamples() : 0;
+      return seconds;
+     });
+
+     auto result = makeResult ("render", timing, renderLength, sampleRate);
+     result->setProperty ("tailDivision", tailDivision);
+     result->setProperty ("tailSeconds", settings.tailSeconds);
+     result->setProperty ("transition", transition);
+     logResult (*result, "division " + juce::String (tailDivision) + " @ " + juce::String (sampleRate) + (transition ? " transition" : ""));
+     results.add (result.get());
+    }
+   }
+  }
+
+  renderer.clearCache();
+ }
+
+ // The audio thread's voice loop (VoicePlayback over a VoicePool, as in processBlock) at every block size.
+ // A voice that ends is restarted, so numVoices keep playing throughout.
+ void benchmarkBlocks (const RenderedSample& rendered, int numVoices, double blockSeconds, int iterations, juce::Array<juce::var>& results)
+ {
+  const FadeEnvelope fades (rendered.getNumSamples(), 0.05f, 0.05f);
+
+  for (bool tremoloEnabled : { false, true })
+  {
+   for (auto blockSize : blockSizes)
+   {
+    VoicePlayback::Settings settings;
+    settings.tremoloEnabled = tremoloEnabled;
+    settings.tremolo.sampleRate = sourceRate;
+
+    juce::AudioBuffer<float> buffer (2, blockSize);
+    const int numBlocks = juce::jmax (1, (int) (blockSeconds * sourceRate) / blockSize);
+
+    // Per-block spread (p99, max, overruns) over every iteration, the way the plugin meters processBlock()
+    CpuLoadMeter blockLoad;
+    blockLoad.prepare (sourceRate);
+
+    auto timing = measure (iterations, [&]
+    {
+     juce::ScopedNoDenormals noDenormals;
+     VoicePool voices;
+
+     // Staggered through the render, so the fade regions and the body are all being played
+     for (int i = 0; i < numVoices; ++i)
+      voices.startVoice (60 + i, 1.0f).position = i * rendered.getNumSamples() / numVoices;
+
+     const auto start = juce::Time::getHighResolutionTicks();
+
+     for (int block = 0; block < numBlocks; ++block)
+     {
+      const CpuLoadMeter::ScopedMeasurement measurement (blockLoad, blockSize);
+      buffer.clear();
+      int numActive = 0;
+
+      for (auto& voice : voices)
+      {
+       if (voice.active)
+       {
+        VoicePlayback::render (voice, rendered, &fades, settings, buffer, 0, blockSize);
+        ++numActive;
+       }
+      }
+
+      for (; numActive < numVoices; ++numActive)
+       voices.startVoice (60, 1.0f);
+     }
+
+     return secondsSince (start);
+    });
+
+    auto result = makeResult ("block", timing, (juce::int64) numBlocks * blockSize, sourceRate);
+    result->setProperty ("blockSize", blockSize);
+    result->setProperty ("tremolo", tremoloEnabled);
+    result->setProperty ("voices", numVoices);
+
+    const auto load = blockLoad.getStats();
+    result->setProperty ("p99Load", load.p99Load);
+    result->setProperty ("maxLoad", load.maxLoad);
+    result->setProperty ("overruns", load.numOverruns);
+    logResult (*result, juce::String (blockSize) + " samples" + (tremoloEnabled ? " tremolo" : ""));
+    results.add (result.get());
+   }
+  }
+ }
+
+ // VectorReverb against juce::Reverb on the source, stereo and mono, at every check rate.
+ // Blocks of uneven sizes and a parameter change halfway exercise the run splitting and the ramps.
+ // Returns false if any output sample differs by more than reverbTolerance.
+ bool benchmarkReverb (const SourceSample& source, int iterations, juce::Array<juce::var>& results)
+ {
+  const int blockPattern[] = { 1, 7, 64, 255, 256, 257, 1000, 4096 };
+  const int numSamples = source.getBuffer().getNumSamples();
+
+  VectorReverb::Parameters firstParameters, secondParameters;
+  firstParameters.roomSize = 0.8f;
+  firstParameters.damping = 0.3f;
+  firstParameters.width = 0.7f;
+  secondParameters.roomSize = 0.4f;
+  secondParameters.damping = 0.7f;
+  secondParameters.wetLevel = 0.5f;
+
+  // Runs process (left, right, n) over a copy of the source in blockPattern-sized blocks
+  auto run = [&] (juce::AudioBuffer<float>& buffer, auto&& setParameters, auto&& process)
+  {
+   buffer.makeCopyOf (source.getBuffer());
+   setParameters (firstParameters);
+   bool changed = false;
+
+   for (int position = 0, block = 0; position < numSamples; ++block)
+   {
+    if (! changed && position >= numSamples / 2)
+    {
+     setParameters (secondParameters);
+     changed = true;
+    }
+
+    const int n = juce::jmin (blockPattern[block % 8], numSamples - position);
+    process (buffer.getWritePointer (0, position), buffer.getWritePointer (1, position), n);
+    position += n;
+   }
+  };
+
+  bool allMatch = true;
+
+  for (auto sampleRate : reverbCheckRates)
+  {
+   for (bool stereo : { true, false })
+   {
+    juce::AudioBuffer<float> expected, actual;
+
+    juce::Reverb reference;
+    reference.setSampleRate (sampleRate);
+    run (expected,
+         [&] (const juce::Reverb::Parameters& p) { reference.setParameters (p); },
+         [&] (float* l, float* r, int n) { if (stereo) reference.processStereo (l, r, n); else reference.processMono (l, n); });
+
+    VectorReverb reverb;
+    auto timing = measure (iterations, [&]
+    {
+     reverb.setSampleRate (sampleRate);
+     const auto start = juce::Time::getHighResolutionTicks();
+     run (actual,
+          [&] (const VectorReverb::Parameters& p) { reverb.setParameters (p); },
+          [&] (float* l, float* r, int n) { if (stereo) reverb.processStereo (l, r, n); else reverb.processMono (l, n); });
+     return secondsSince (start);
+    });
+
+    // Mono only processes the first channel
+    float maxError = 0.0f;
+    for (int channel = 0; channel < (stereo ? 2 : 1); ++channel)
+    {
+     auto* e = expected.getReadPointer (channel);
+     auto* a = actual.getReadPointer (channel);
+
+     for (int i = 0; i < numSamples; ++i)
+      maxError = juce::jmax (maxError, std::abs (e[i] - a[i]));
+    }
+
+    const bool matches = maxError <= reverbTolerance;
+    allMatch = allMatch && matches;
+
+    auto result = makeResult ("reverb", timing, numSamples, sampleRate);
+    result->setProperty ("stereo", stereo);
+    result->setProperty ("maxError", maxError);
+    result->setProperty ("matches", matches);
+    logResult (*result, juce::String (stereo ? "stereo" : "mono") + " @ " + juce::String (sampleRate)
+                          + ", max error " + juce::String (maxError) + (matches ? "" : " - EXCEEDS TOLERANCE"));
+    results.add (result.get());
+   }
+  }
+
+  return allMatch;
+ }
+
+ // The waveform display's min/max overview of a whole render
+ void benchmarkWaveform (const RenderedSample& rendered, int iterations, juce::Array<juce::var>& results)
+ {
+  std::vector<float> mins, maxs;
+
+  auto timing = measure (juce::jmax (iterations, 10), [&]
+  {
+   const auto start = juce::Time::getHighResolutionTicks();
+   WaveformSummary::compute (rendered.getBuffer(), waveformWidth, mins, maxs);
+   return secondsSince (start);
+  });
+
+  auto result = makeResult ("waveform", timing, rendered.getNumSamples(), sourceRate);
+  result->setProperty ("width", waveformWidth);
+  logResult (*result, juce::String (waveformWidth) + " px");
+  results.add (result.get());
+ }
+
+ // The export: fades applied to a copy, written as a 24-bit WAV
+ void benchmarkExport (const RenderedSample& rendered, int iterations, juce::Array<juce::var>& results)
+ {
+  const FadeEnvelope fades (rendered.getNumSamples(), 0.05f, 0.05f);
+  auto file = juce::File::getSpecialLocation (juce::File::tempDirectory).getChildFile ("ReverseReverbBench Export.wav");
+  bool written = true;
+
+  auto timing = measure (iterations, [&]
+  {
+   const auto start = juce::Time::getHighResolutionTicks();
+   written = RenderExport::writeWav (rendered.getBuffer(), &fades, sourceRate, file) && written;
+   return secondsSince (start);
+  });
+
+  file.deleteFile();
+
+  if (! written)
+  {
+   std::cerr << "export: can't write " << file.getFullPathName() << std::endl;
+   return;
+  }
+
+  auto result = makeResult ("export", timing, rendered.getNumSamples(), sourceRate);
+  result->setProperty ("bitDepth", 24);
+  logResult (*result, "24-bit WAV");
+  results.add (result.get());
+ }
+}
+
+int main (int argc, char* argv[])
+{
+ juce::ArgumentList args (argc, argv);
+
+ if (args.containsOption ("--help|-h"))
+ {
+  std::cout << usage;
+  return 0;
+ }
+
+ const int iterations = juce::jmax (1, args.containsOption ("--iterations") ? args.getValueForOption ("--iterations").getIntValue() : 3);
+ const double sourceSeconds = args.containsOption ("--source-seconds") ? juce::jlimit (0.1, 120.0, args.getValueForOption ("--source-seconds").getDoubleValue()) : 4.0;
+ const double blockSeconds = args.containsOption ("--block-seconds") ? juce::jlimit (0.1, 600.0, args.getValueForOption ("--block-seconds").getDoubleValue()) : 20.0;
+ const int numVoices = args.containsOption ("--voices") ? juce::jlimit (1, VoicePool::maxSoundingVoices, args.getValueForOption ("--voices").getIntValue()) : 4;
+
+ juce::StringArray only;
+ only.addTokens (args.getValueForOption ("--only"), ",", {});
+ only.removeEmptyStrings();
+
+ auto shouldRun = [&only] (const char* name) { return only.isEmpty() || only.contains (name); };
+
+ auto source = makeSource (sourceSeconds);
+ juce::Array<juce::var> results;
+ juce::ThreadPool renderPool (juce::jmax (1, juce::SystemStats::getNumCpus() - 1)); // Sized like the plugin's
+
+ bool reverbMatches = true;
+
+ if (shouldRun ("reverb"))
+  reverbMatches = benchmarkReverb (*source, iterations, results);
+
+ if (shouldRun ("render"))
+  benchmarkRender (renderPool, source, iterations, results);
+
+ if (shouldRun ("block") || shouldRun ("waveform") || shouldRun ("export"))
+ {
+  // The plugin's defaults: one bar of tail at 120 BPM
+  RenderSettings settings;
+  settings.tailSeconds = RenderSettings::getTailSeconds (3, 120.0);
+  settings.sampleRate = sourceRate;
+
+  ReverseReverbRenderer renderer (renderPool);
+  auto rendered = renderer.render (source, settings);
+
+  if (rendered == nullptr || rendered->isEmpty())
+  {
+   std::cerr << "Render failed" << std::endl;
+   return 1;
+  }
+
+  if (shouldRun ("block"))
+   benchmarkBlocks (*rendered, numVoices, blockSeconds, iterations, results);
+
+  if (shouldRun ("waveform"))
+   benchmarkWaveform (*rendered, iterations, results);
+
+  if (shouldRun ("export"))
+   benchmarkExport (*rendered, iterations, results);
+ }
+
+ juce::DynamicObject::Ptr machine = new juce::DynamicObject();
+ machine->setProperty ("cpu", juce::SystemStats::getCpuModel());
+ machine->setProperty ("cores", juce::SystemStats::getNumCpus());
+ machine->setProperty ("os", juce::SystemStats::getOperatingSystemName());
+
+ juce::DynamicObject::Ptr report = new juce::DynamicObject();
+ report->setProperty ("version", ProjectInfo::versionString);
+ report->setProperty ("date", juce::Time::getCurrentTime().toISO8601 (true));
+ report->setProperty ("machine", machine.get());
+ report->setProperty ("sourceSeconds", sourceSeconds);
+ report->setProperty ("results", results);
+ report->setProperty ("reverbMatches", reverbMatches);
+
+ const auto json = juce::JSON::toString (juce::var (report.get()));
+
+ if (args.containsOption ("--out"))
+ {
+  auto outFile = args.getFileForOption ("--out");
+
+  if (! outFile.replaceWithText (json))
+  {
+   std::cerr << "Can't write " << outFile.getFullPathName() << std::endl;
+   return 1;
+  }
+
+  std::cerr << "Wrote " << results.size() << " results to " << outFile.getFullPathName() << std::endl;
+ }
+ else
+ {
+  std::cout << json << std::endl;
+ }
+
+ return reverbMatches ? 0 : 1;
+}
@@ -0,0 +1,390 @@
+#include <JuceHeader.h>
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <vector>
+#include "ReverseReverbRenderer.h"
+#include "FadeEnvelope.h"
+#include "RenderProfiler.h"
+
+// Headless batch renderer: the plugin's offline render over folders of samples,
+// one file per job across every core, so library variants don't mean scripting
+// the GUI by hand.
+
+namespace
+{
+ const char* const usage =
+  "Usage: ReverseReverbCLI <file | folder | \"glob\">... [options]\n"
+  "\n"
+  "Renders every input with the plugin's reverse reverb into \"Reverse Reverb - <name>\".\n"
+  "\n"
+  "  --out=<folder>        Output folder (default: \"Reverse Reverb\" next to each input). Files\n"
+  "                        found in a folder keep their subfolder under it\n"
+  "  --format=wav|flac     Output format (default wav)\n"
+  "  --bits=16|24          Output bit depth (default 24)\n"
+  "  --rate=<hz>           Render at this rate (default: each file's own)\n"
+  "  --tail-division=<0-8> 0=8 Bar, 1=4 Bar, 2=2 Bar, 3=1 Bar (default), 4=1/2 ... 8=1/32\n"
+  "  --bpm=<bpm>           Tempo for the tail division (default 120)\n"
+  "  --tail=<seconds>      Tail length, overrides --tail-division\n"
+  "  --size=<0-1>          Room size (default 1)\n"
+  "  --width=<0-1>         Stereo width (default 0.5)\n"
+  "  --low-cut=<hz>        Low cut, 20 to 500 (default 20)\n"
+  "  --transition          Transition mode (reversed tail into the forward sample)\n"
+  "  --engine=freeverb|convolution\n"
+  "  --ir=<file>           Impulse response (implies --engine=convolution)\n"
+  "  --fade-in=<0-0.5>     Fade in, as a fraction of the render (default 0)\n"
+  "  --fade-out=<0-0.5>    Fade out, as a fraction of the render (default 0)\n"
+  "  --recursive           Search folders recursively\n"
+  "  --jobs=<n>            Files rendered at once (default: one per core)\n"
+  "  --trace=<file>        Write each render's stage timings as a Chrome trace (chrome://tracing)\n";
+
+ struct BatchSettings
+ {
+  RenderSettings render;  // sampleRate is filled in per file
+  double targetRate = 0.0; // 0 = each file's own rate
+  float fadeIn = 0.0f, fadeOut = 0.0f;
+  juce::File outputDirectory; // Empty = next to each input
+  bool flac = false;
+  int bitDepth = 24;
+ };
+
+ float getFloatOption (const juce::ArgumentList& args, juce::StringRef option, float defaultValue, float minimum, float maximum)
+ {
+  auto value = args.getValueForOption (option);
+  return value.isEmpty() ? defaultValue : juce::jlimit (minimum, maximum, value.getFloatValue());
+ }
+
+ struct Input
+ {
+  juce::File file;
+  juce::File root; // Folder the file was found under (its own folder for a file argument)
+  juce::File output;
+
+  bool operator== (const Input& other) const { return file == other.file; }
+ };
+
+ // Files, folders and quoted globs ("Kits/*.wav"), in natural order without duplicates
+ juce::Array<Input> collectInputs (const juce::ArgumentList& args, const juce::AudioFormatManager& formats, bool recursive)
+ {
+  juce::Array<Input> inputs;
+
+  for (auto& arg : args.arguments)
+  {
+   if (arg.isOption())
+    continue;
+
+   if (arg.text.containsAnyOf ("*?"))
+   {
+    auto pattern = juce::File::getCurrentWorkingDirectory().getChildFile (arg.text);
+    for (auto& file : pattern.getParentDirectory().findChildFiles (juce::File::findFiles, recursive, pattern.getFileName()))
+     inputs.addIfNotAlreadyThere ({ file, pattern.getParentDirectory(), {} });
+   }
+   else if (auto file = arg.resolveAsFile(); file.isDirectory())
+   {
+    for (auto& child : file.findChildFiles (juce::File::findFiles, recursive, formats.getWildcardForAllFormats()))
+     inputs.addIfNotAlreadyThere ({ child, file, {} });
+   }
+   else if (file.existsAsFile())
+   {
+    inputs.addIfNotAlreadyThere ({ file, file.getParentDirectory(), {} });
+   }
+   else
+   {
+    std::cerr << "Skipping " << arg.text << ": not found" << std::endl;
+   }
+  }
+
+  // Earlier outputs under the inputs (the default output folder) are not inputs
+  inputs.removeIf ([] (const Input& input) { return input.file.getFileName().startsWith ("Reverse Reverb - "); });
+
+  std::sort (inputs.begin(), inputs.end(), [] (const Input& a, const Input& b)
+  {
+   return a.file.getFullPathName().compareNatural (b.file.getFullPathName()) < 0;
+  });
+
+  return inputs;
+ }
+
+ // Fills in every input's output file and creates its folder, before any job runs. Under --out
+ // each file keeps its subfolder below its root, so same-named files in different folders don't
+ // meet. Inputs that would still write the same file as an earlier one ("Kick.wav" and "Kick.aif")
+ // are reported and dropped; returns false if any were.
+ bool resolveOutputs (juce::Array<Input>& inputs, const BatchSettings& batch)
+ {
+  bool allResolved = true;
+  juce::Array<Input> resolved;
+
+  for (auto input : inputs)
+  {
+   const auto directory = batch.outputDirectory != juce::File()
+                            ? batch.outputDirectory.getChildFile (input.file.getParentDirectory().getRelativePathFrom (input.root))
+                            : input.file.getParentDirectory().getChildFile ("Reverse Reverb");
+
+   input.output = directory.getChildFile ("Reverse Reverb - " + input.file.getFileNameWithoutExtension() + (batch.flac ? ".flac" : ".wav"));
+
+   auto* clash = std::find_if (resolved.begin(), resolved.end(), [&input] (const Input& other) { return other.output == input.output; });
+   if (clash != resolved.end())
+   {
+    std::cerr << input.file.getFullPathName() << ": skipped, would overwrite the output of " << clash->file.getFullPathName() << std::endl;
+    allResolved = false;
+    continue;
+   }
+
+   if (directory.createDirectory().failed())
+   {
+    std::cerr << input.file.getFullPathName() << ": skipped, can't create " << directory.getFullPathName() << std::endl;
+    allResolved = false;
+    continue;
+   }
+
+   resolved.add (input);
+  }
+
+  inputs = std::move (resolved);
+  return allResolved;
+ }
+
+ // One input file: decode, render, fade and write
+ class RenderJob : public juce::ThreadPoolJob
+ {
+ public:
+  // outputToWrite comes from resolveOutputs(): unique, with its folder already created
+  RenderJob (const juce::File& inputFile, const juce::File& outputToWrite, juce::AudioFormatManager& formatsToUse, const BatchSettings& batchSettings,
+             juce::ThreadPool& poolToRunOn, juce::CriticalSection& consoleLockToUse)
+   : juce::ThreadPoolJob ("Render " + inputFile.getFileName()),
+     input (inputFile), outputFile (outputToWrite), formats (formatsToUse), batch (batchSettings), renderPool (poolToRunOn), consoleLock (consoleLockToUse)
+  {
+  }
+
+  JobStatus runJob() override
+  {
+   const auto startTime = juce::Time::getMillisecondCounterHiRes();
+   const auto error = render();
+   const auto milliseconds = juce::Time::getMillisecondCounterHiRes() - startTime;
+
+   succeeded = error.isEmpty();
+
+   const juce::ScopedLock sl (consoleLock);
+   if (succeeded)
+    std::cout << input.getFileName() << " -> " << outputFile.getFullPathName()
+              << " (" << juce::String (sourceSeconds, 2) << " s in " << juce::roundToInt (milliseconds) << " ms)" << std::endl;
+   else
+    std::cerr << input.getFileName() << ": " << error << std::endl;
+
+   return jobHasFinished;
+  }
+
+  bool hasSucceeded() const noexcept { return succeeded; }
+  double getSourceSeconds() const noexcept { return sourceSeconds; }
+
+ private:
+  // Returns an error message, empty on success
+  juce::String render()
+  {
+   std::unique_ptr<juce::AudioFormatReader> reader (formats.createReaderFor (input));
+
+   if (reader == nullptr || reader->sampleRate <= 0.0 || reader->lengthInSamples <= 0)
+    return "unsupported or empty file";
+
+   if (reader->lengthInSamples > std::numeric_limits<int>::max())
+    return "file too long";
+
+   const int numChannels = juce::jmin ((int) reader->numChannels, 2); // Max stereo, like the plugin
+   const int numSamples = (int) reader->lengthInSamples;
+   juce::AudioBuffer<float> decoded (numChannels, numSamples);
+
+   if (! reader->read (&decoded, 0, numSamples, 0, true, true))
+    return "read failed";
+
+   sourceSeconds = numSamples / reader->sampleRate;
+
+   SourceSample::Ptr source = new SourceSample (std::move (decoded), reader->sampleRate);
+   auto settings = batch.render;
+   settings.sampleRate = batch.targetRate > 0.0 ? batch.targetRate : reader->sampleRate;
+
+   RenderControl control;
+   control.isCancelled = [this] { return shouldExit(); };
+
+   // One renderer per job - renderers are not shared between threads, but they share the
+   // pool this job runs on for their convolution work
+   ReverseReverbRenderer renderer (renderPool, true);
+   auto sourceAtRate = source->getAtSampleRate (settings.sampleRate, control.isCancelled);
+   auto rendered = sourceAtRate != nullptr ? renderer.render (sourceAtRate, settings, control) : nullptr;
+
+   if (rendered == nullptr)
+    return "cancelled";
+
+   if (rendered->isEmpty())
+    return "render failed";
+
+   // Same fades the plugin's export applies
+   juce::AudioBuffer<float> faded;
+   const auto* output = &rendered->getBuffer();
+
+   if (batch.fadeIn > 0.0f || batch.fadeOut > 0.0f)
+   {
+    faded.makeCopyOf (rendered->getBuffer());
+    FadeEnvelope::Ptr fades = new FadeEnvelope (faded.getNumSamples(), batch.fadeIn, batch.fadeOut);
+    fades->applyTo (faded);
+    output = &faded;
+   }
+
+   return write (*output, settings.sampleRate);
+  }
+
+  juce::String write (const juce::AudioBuffer<float>& audio, double sampleRate)
+  {
+   outputFile.deleteFile();
+
+   std::unique_ptr<juce::FileOutputStream> stream (outputFile.createOutputStream());
+   if (stream == nullptr)
+    return "can't write " + outputFile.getFullPathName();
+
+   juce::WavAudioFormat wavFormat;
+   juce::FlacAudioFormat flacFormat;
+   juce::AudioFormat& format = batch.flac ? static_cast<juce::AudioFormat&> (flacFormat) : wavFormat;
+
+   std::unique_ptr<juce::AudioFormatWriter> writer (format.createWriterFor (stream.get(), sampleRate, (unsigned int) audio.getNumChannels(),
+                                                                           batch.bitDepth, {}, 0));
+   if (writer == nullptr)
+    return "can't create a " + format.getFormatName() + " writer";
+
+   stream.release(); // The writer owns it now
+
+   if (! writer->writeFromAudioSampleBuffer (audio, 0, audio.getNumSamples()))
+    return "write failed (disk full?)";
+
+   return {};
+  }
+
+  const juce::File input;
+  const juce::File outputFile;
+  juce::AudioFormatManager& formats;
+  const BatchSettings& batch;
+  juce::ThreadPool& renderPool;
+  juce::CriticalSection& consoleLock;
+
+  double sourceSeconds = 0.0;
+  bool succeeded = false;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderJob)
+ };
+}
+
+int main (int argc, char* argv[])
+{
+ juce::ArgumentList args (argc, argv);
+
+ if (args.size() == 0 || args.containsOption ("--help|-h"))
+ {
+  std::cout << usage;
+  return args.size() == 0 ? 1 : 0;
+ }
+
+ juce::AudioFormatManager formats;
+ formats.registerBasicFormats();
+
+ BatchSettings batch;
+ auto& render = batch.render;
+ const float bpm = getFloatOption (args, "--bpm", 120.0f, 20.0f, 300.0f);
+ const int tailDivision = juce::jlimit (0, 8, args.getValueForOption ("--tail-division").getIntValue());
+
+ render.tailSeconds = args.containsOption ("--tail")
+                        ? getFloatOption (args, "--tail", 2.0f, 0.01f, 60.0f)
+                        : RenderSettings::getTailSeconds (args.containsOption ("--tail-division") ? tailDivision : 3, bpm);
+ render.reverbSize = getFloatOption (args, "--size", 1.0f, 0.0f, 1.0f);
+ render.stereoWidth = getFloatOption (args, "--width", 0.5f, 0.0f, 1.0f);
+ render.lowCutFreq = getFloatOption (args, "--low-cut", 20.0f, 20.0f, 500.0f);
+ render.transitionMode = args.containsOption ("--transition");
+ render.engine = args.getValueForOption ("--engine") == "convolution" ? ReverbEngine::convolution : ReverbEngine::freeverb;
+ render.scratchDirectory = juce::File::getSpecialLocation (juce::File::tempDirectory).getChildFile ("ReverseReverbCLI");
+ render.scratchDirectory.createDirectory();
+
+ if (args.containsOption ("--ir"))
+ {
+  auto irFile = args.getFileForOption ("--ir");
+  std::unique_ptr<juce::AudioFormatReader> reader (formats.createReaderFor (irFile));
+
+  if (reader == nullptr || reader->sampleRate <= 0.0 || reader->lengthInSamples <= 0 || reader->lengthInSamples > (juce::int64) (30.0 * reader->sampleRate))
+  {
+   std::cerr << "Can't load impulse response " << irFile.getFullPathName() << " (max 30 s)" << std::endl;
+   return 1;
+  }
+
+  juce::AudioBuffer<float> impulse (juce::jmin ((int) reader->numChannels, 2), (int) reader->lengthInSamples);
+  reader->read (&impulse, 0, impulse.getNumSamples(), 0, true, true);
+  render.impulseResponse = new SourceSample (std::move (impulse), reader->sampleRate);
+  render.engine = ReverbEngine::convolution;
+ }
+
+ batch.targetRate = getFloatOption (args, "--rate", 0.0f, 0.0f, 384000.0f);
+ batch.fadeIn = getFloatOption (args, "--fade-in", 0.0f, 0.0f, 0.5f);
+ batch.fadeOut = getFloatOption (args, "--fade-out", 0.0f, 0.0f, 0.5f);
+ batch.flac = args.getValueForOption ("--format").equalsIgnoreCase ("flac");
+ batch.bitDepth = args.getValueForOption ("--bits") == "16" ? 16 : 24;
+
+ if (args.containsOption ("--out"))
+  batch.outputDirectory = args.getFileForOption ("--out");
+
+ auto inputs = collectInputs (args, formats, args.containsOption ("--recursive"));
+ const bool allOutputsResolved = resolveOutputs (inputs, batch);
+
+ if (inputs.isEmpty())
+ {
+  std::cerr << "No input files" << std::endl;
+  return 1;
+ }
+
+ const int numJobs = args.containsOption ("--jobs") ? juce::jmax (1, args.getValueForOption ("--jobs").getIntValue())
+                                                    : juce::SystemStats::getNumCpus();
+
+ std::cout << "Rendering " << inputs.size() << " files on " << numJobs << " threads (tail "
+           << juce::String (render.tailSeconds, 2) << " s)" << std::endl;
+
+ const auto traceFile = args.containsOption ("--trace") ? args.getFileForOption ("--trace") : juce::File();
+ RenderProfiler::setEnabled (traceFile != juce::File());
+
+ juce::CriticalSection consoleLock;
+ juce::ThreadPool pool (numJobs); // The only render threads: every job and every job's convolution runs here
+ std::vector<std::unique_ptr<RenderJob>> jobs;
+
+ for (auto& input : inputs)
+  jobs.push_back (std::make_unique<RenderJob> (input.file, input.output, formats, batch, pool, consoleLock));
+
+ const auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+ for (auto& job : jobs)
+  pool.addJob (job.get(), false);
+
+ for (auto& job : jobs)
+  pool.waitForJobToFinish (job.get(), -1);
+
+ const double wallSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+ int numSucceeded = 0;
+ double sourceSeconds = 0.0;
+
+ for (auto& job : jobs)
+ {
+  if (job->hasSucceeded())
+  {
+   ++numSucceeded;
+   sourceSeconds += job->getSourceSeconds();
+  }
+ }
+
+ // Real-time factor: seconds of source audio rendered per second of wall time
+ std::cout << numSucceeded << " of " << jobs.size() << " files in " << juce::String (wallSeconds, 2) << " s: "
+           << juce::String (numSucceeded / juce::jmax (wallSeconds, 1.0e-6), 2) << " files/s, "
+           << juce::String (sourceSeconds / juce::jmax (wallSeconds, 1.0e-6), 1) << "x real time" << std::endl;
+
+ if (traceFile != juce::File())
+ {
+  if (RenderProfiler::writeChromeTrace (traceFile))
+   std::cout << "Trace written to " << traceFile.getFullPathName() << std::endl;
+  else
+   std::cerr << "Can't write the trace to " << traceFile.getFullPathName() << std::endl;
+ }
+
+ return allOutputsResolved && numSucceeded == (int) jobs.size() ? 0 : 1;
+}
@@ -0,0 +1,254 @@
+#include <JuceHeader.h>
+#include <iostream>
+#include <iterator>
+#include <sys/resource.h>
+#include "PluginProcessor.h"
+#include "RenderExport.h"
+#include "RealtimeChecker.h"
+
+// Real-time safety check: the plugin's processBlock() runs on a simulated
+// audio thread, at host pace with varying block sizes and random MIDI, while
+// this thread plays the editor: it moves parameters, reloads samples, fills the
+// bank and restores state, so renders land mid-playback the whole time. Any
+// allocation, lock or blocking system call made inside processBlock() is a
+// failure (see RealtimeChecker), and so is any major page fault it takes - a
+// streamed render read from disk rather than from pages the read-ahead pinned.
+//
+// Build Debug, so DBG() string building is checked too.
+
+namespace
+{
+ const char* const usage =
+  "Usage: ReverseReverbRTCheck [options]\n"
+  "\n"
+  "Runs processBlock() under the real-time checker and exits with 1 on any\n"
+  "allocation, lock, blocking call or major page fault on the audio thread.\n"
+  "\n"
+  "  --seconds=<s>   How long to run (default 20)\n"
+  "  --rate=<hz>     Sample rate (default 44100)\n"
+  "  --abort         abort() on the first violation, for a stack trace in a debugger\n";
+
+ const int blockSizes[] = { 32, 64, 128, 256, 441, 512, 1024 };
+ const int maxBlockSize = 1024;
+
+ // A host playing at a fixed tempo, so synced tremolo reads the play head
+ class TestPlayHead : public juce::AudioPlayHead
+ {
+ public:
+  juce::Optional<PositionInfo> getPosition() const override
+  {
+   PositionInfo info;
+   info.setBpm (bpm);
+   info.setIsPlaying (true);
+   info.setPpqPosition (ppqPosition.load());
+   return info;
+  }
+
+  const double bpm = 128.0;
+  std::atomic<double> ppqPosition { 0.0 }; // Advanced by the audio thread after each block
+ };
+
+ // Page faults the calling thread has taken that needed disk I/O
+ long getMajorFaults() noexcept
+ {
+  rusage usage {};
+  return getrusage (RUSAGE_THREAD, &usage) == 0 ? usage.ru_majflt : 0;
+ }
+
+ // The host's audio callback: one processBlock() per block, paced to real time
+ class AudioThread : public juce::Thread
+ {
+ public:
+  AudioThread (ReverseReverbAudioProcessor& processorToRun, TestPlayHead& playHeadToAdvance, double rate)
+   : juce::Thread ("ReverseReverbRTCheck Audio"), processor (processorToRun), playHead (playHeadToAdvance), sampleRate (rate)
+  {
+  }
+
+  ~AudioThread() override
+  {
+   stopThread (4000);
+  }
+
+  void run() override
+  {
+   juce::AudioBuffer<float> buffer (2, maxBlockSize);
+   juce::MidiBuffer midi;
+   midi.ensureSize (4096);
+   juce::Random random (1);
+
+   auto nextBlockTime = juce::Time::getMillisecondCounterHiRes();
+
+   while (! threadShouldExit())
+   {
+    const int numSamples = blockSizes[random.nextInt ((int) std::size (blockSizes))];
+    buffer.setSize (2, numSamples, false, false, true); // Keeps the allocation
+
+    // The host fills the MIDI buffer before the callback, outside the checked region
+    midi.clear();
+    if (random.nextInt (6) == 0)
+     midi.addEvent (juce::MidiMessage::noteOn (1, 36 + random.nextInt (36), (juce::uint8) (40 + random.nextInt (80))), random.nextInt (numSamples));
+    if (random.nextInt (8) == 0)
+     midi.addEvent (juce::MidiMessage::noteOff (1, 36 + random.nextInt (36)), random.nextInt (numSamples));
+    if (random.nextInt (400) == 0)
+     midi.addEvent (juce::MidiMessage::allNotesOff (1), 0);
+
+    const auto majorFaultsBefore = getMajorFaults();
+
+    {
+     const RealtimeChecker::ScopedAudioThread audioThread;
+     processor.processBlock (buffer, midi);
+    }
+
+    if (getMajorFaults() != majorFaultsBefore)
+     RealtimeChecker::reportViolation ("major page fault");
+
+    ++numBlocks;
+    playHead.ppqPosition = playHead.ppqPosition.load() + numSamples / sampleRate * playHead.bpm / 60.0;
+
+    nextBlockTime += numSamples * 1000.0 / sampleRate;
+    juce::Time::waitForMillisecondCounter ((juce::uint32) nextBlockTime);
+   }
+  }
+
+  std::atomic<juce::int64> numBlocks { 0 };
+
+ private:
+  ReverseReverbAudioProcessor& processor;
+  TestPlayHead& playHead;
+  const double sampleRate;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioThread)
+ };
+
+ // A chord under a noise burst, written as a WAV for the processor to load
+ bool writeTestSample (const juce::File& file, double seconds, double sampleRate, float pitch)
+ {
+  juce::AudioBuffer<float> audio (2, (int) (seconds * sampleRate));
+  juce::Random random (42);
+
+  for (int i = 0; i < audio.getNumSamples(); ++i)
+  {
+   const double t = i / sampleRate;
+   const auto tone = (float) (0.3 * std::sin (juce::MathConstants<double>::twoPi * pitch * t));
+   const auto burst = (float) std::exp (-8.0 * t);
+
+   for (int channel = 0; channel < 2; ++channel)
+    audio.setSample (channel, i, tone + burst * (random.nextFloat() * 2.0f - 1.0f));
+  }
+
+  return RenderExport::writeWav (audio, nullptr, sampleRate, file);
+ }
+
+ // One editor action: a parameter move (re-rendering when it feeds the render), a trigger or a state restore
+ void changeSomething (ReverseReverbAudioProcessor& processor, juce::Random& random)
+ {
+  switch (random.nextInt (12))
+  {
+   case 0:  processor.setReverbSize (random.nextFloat()); processor.processReverseReverb(); break;
+   case 1:  processor.setTailDivision (random.nextInt (9)); processor.processReverseReverb(); break;
+   case 2:  processor.setStereoWidth (random.nextFloat()); processor.processReverseReverb(); break;
+   case 3:  processor.setTransitionMode (random.nextBool()); processor.processReverseReverb(); break;
+   case 4:  processor.setFadeIn (random.nextFloat() * 0.3f); break;
+   case 5:  processor.setFadeOut (random.nextFloat() * 0.3f); break;
+   case 6:  processor.setTremoloEnabled (random.nextBool()); processor.setTremoloDepth (random.nextFloat()); break;
+   case 7:  processor.setTremoloSyncEnabled (random.nextBool()); processor.setTremoloSyncDivision (random.nextInt (9)); break;
+   case 8:  processor.setTremoloRateRampEnabled (random.nextBool()); processor.setTremoloWaveform (random.nextInt (3)); break;
+   case 9:  processor.setDryWet (0.5f + random.nextFloat() * 0.5f); break;
+   case 10: processor.triggerSample(); break;
+   default:
+   {
+    juce::MemoryBlock state;
+    processor.getStateInformation (state);
+    processor.setStateInformation (state.getData(), (int) state.getSize());
+    break;
+   }
+  }
+ }
+}
+
+int main (int argc, char* argv[])
+{
+ juce::ArgumentList args (argc, argv);
+
+ if (args.containsOption ("--help|-h"))
+ {
+  std::cout << usage;
+  return 0;
+ }
+
+ const double seconds = args.containsOption ("--seconds") ? juce::jlimit (1.0, 3600.0, args.getValueForOption ("--seconds").getDoubleValue()) : 20.0;
+ const double sampleRate = args.containsOption ("--rate") ? juce::jlimit (8000.0, 384000.0, args.getValueForOption ("--rate").getDoubleValue()) : 44100.0;
+ RealtimeChecker::setAbortOnViolation (args.containsOption ("--abort"));
+
+ // Two short samples (also the bank kit) and one long enough to stream from disk
+ auto folder = juce::File::getSpecialLocation (juce::File::tempDirectory).getChildFile ("ReverseReverbRTCheck");
+ auto kit = folder.getChildFile ("Kit");
+ kit.createDirectory();
+
+ const juce::Array<juce::File> samples { kit.getChildFile ("Short A.wav"), kit.getChildFile ("Short B.wav"), folder.getChildFile ("Long.wav") };
+
+ if (! writeTestSample (samples[0], 1.5, sampleRate, 220.0f)
+     || ! writeTestSample (samples[1], 3.0, sampleRate, 330.0f)
+     || ! writeTestSample (samples[2], ReverseReverbAudioProcessor::streamingThresholdSeconds + 2.0, sampleRate, 165.0f))
+ {
+  std::cerr << "Can't write the test samples to " << folder.getFullPathName() << std::endl;
+  return 1;
+ }
+
+ int result = 0;
+
+ {
+  ReverseReverbAudioProcessor processor;
+  TestPlayHead playHead;
+
+  processor.setPlayHead (&playHead);
+  processor.setPlayConfigDetails (0, 2, sampleRate, maxBlockSize);
+  processor.prepareToPlay (sampleRate, maxBlockSize);
+  processor.loadAudioFile (samples[0]);
+
+  AudioThread audioThread (processor, playHead, sampleRate);
+  audioThread.startThread (juce::Thread::Priority::highest);
+
+  juce::Random random (7);
+  const int numSteps = (int) (seconds * 50.0); // One editor action every 20 ms
+
+  for (int step = 1; step <= numSteps; ++step)
+  {
+   juce::Thread::sleep (20);
+   changeSomething (processor, random);
+
+   if (step % 100 == 0)
+    processor.loadAudioFile (samples[(step / 100) % samples.size()]);
+
+   if (step == 150)
+    processor.loadBankFolder (kit, 60);
+
+   if (step == 400)
+    processor.clearBank();
+
+   processor.releaseRetiredRenders(); // The editor's timer does this
+  }
+
+  audioThread.stopThread (4000);
+
+  const auto numViolations = RealtimeChecker::getNumViolations();
+  std::cout << audioThread.numBlocks.load() << " blocks, " << processor.getRenderedGeneration() << " renders published, "
+            << numViolations << " violations" << std::endl;
+
+  if (numViolations > 0)
+  {
+   RealtimeChecker::printReport();
+   result = 1;
+  }
+  else if (processor.getRenderedGeneration() < 2)
+  {
+   std::cerr << "Fewer than two renders landed - the run didn't exercise the render handoff (try a longer --seconds)" << std::endl;
+   result = 1;
+  }
+
+  processor.releaseResources();
+ }
+
+ folder.deleteRecursively();
+ return result;
+}
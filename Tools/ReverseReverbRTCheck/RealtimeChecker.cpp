@@ -0,0 +1,97 @@
+#include "RealtimeChecker.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+namespace
+{
+ thread_local bool isAudioThread = false;
+ thread_local int ignoreDepth = 0; // > 0 while the checker itself is reporting
+
+ std::atomic<bool> abortOnViolation { false };
+
+ // Counts per hooked function, in a fixed table so recording never allocates
+ struct Counter
+ {
+  std::atomic<const char*> function { nullptr };
+  std::atomic<std::size_t> count { 0 };
+ };
+
+ constexpr int maxFunctions = 64;
+ Counter counters[maxFunctions];
+ std::atomic<std::size_t> numViolations { 0 };
+
+ constexpr std::size_t maxPrinted = 20; // Violations echoed to stderr as they happen
+
+ void record (const char* function) noexcept
+ {
+  for (auto& counter : counters)
+  {
+   const char* expected = nullptr;
+   if (counter.function.load() == function || counter.function.compare_exchange_strong (expected, function) || expected == function)
+   {
+    ++counter.count;
+    return;
+   }
+  }
+ }
+}
+
+RealtimeChecker::ScopedAudioThread::ScopedAudioThread() noexcept  { isAudioThread = true; }
+RealtimeChecker::ScopedAudioThread::~ScopedAudioThread() noexcept { isAudioThread = false; }
+
+void RealtimeChecker::setAbortOnViolation (bool shouldAbort) noexcept
+{
+ abortOnViolation = shouldAbort;
+}
+
+std::size_t RealtimeChecker::getNumViolations() noexcept
+{
+ return numViolations.load();
+}
+
+void RealtimeChecker::check (const char* function) noexcept
+{
+ if (! isAudioThread || ignoreDepth > 0)
+  return;
+
+ recordViolation (function, "RT violation: %s() on the audio thread\n");
+}
+
+void RealtimeChecker::reportViolation (const char* description) noexcept
+{
+ recordViolation (description, "RT violation: %s on the audio thread\n");
+}
+
+void RealtimeChecker::recordViolation (const char* name, const char* lineFormat) noexcept
+{
+ ++ignoreDepth;
+ record (name);
+
+ if (numViolations++ < maxPrinted)
+ {
+  // snprintf into the stack and a raw write: nothing here allocates
+  char line[160];
+  const int length = std::snprintf (line, sizeof (line), lineFormat, name);
+  if (length > 0)
+   (void) ::write (STDERR_FILENO, line, (std::size_t) length);
+ }
+
+ if (abortOnViolation)
+  std::abort();
+
+ --ignoreDepth;
+}
+
+void RealtimeChecker::printReport()
+{
+ ++ignoreDepth;
+
+ for (auto& counter : counters)
+  if (auto* function = counter.function.load())
+   std::printf ("  %-24s %zu time(s) on the audio thread\n", function, counter.count.load());
+
+ std::fflush (stdout);
+ --ignoreDepth;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+
+// Audio-thread safety checks for ReverseReverbRTCheck.
+//
+// The tool interposes the allocator, the pthread lock and wait primitives and
+// the common blocking system calls (see RealtimeHooks.cpp). Each hook reports
+// through check() before forwarding to the real function, and check() records
+// a violation whenever the calling thread is inside a ScopedAudioThread. The
+// checker itself never allocates or locks, so it is safe inside those hooks.
+// Problems only visible after the fact, like major page faults taken during
+// processBlock(), are filed with reportViolation().
+class RealtimeChecker
+{
+public:
+ // Marks the calling thread as the audio thread while it exists (wrap each processBlock call)
+ struct ScopedAudioThread
+ {
+  ScopedAudioThread() noexcept;
+  ~ScopedAudioThread() noexcept;
+ };
+
+ // abort() on the first violation, so a debugger or core dump shows the offending call stack
+ static void setAbortOnViolation (bool shouldAbort) noexcept;
+
+ static std::size_t getNumViolations() noexcept;
+
+ // One line per hooked function that was called on the audio thread, to stdout
+ static void printReport();
+
+ // Called by every hook with its function name (a string literal)
+ static void check (const char* function) noexcept;
+
+ // Records a violation the audio thread committed, described by a string literal, from any thread
+ static void reportViolation (const char* description) noexcept;
+
+private:
+ static void recordViolation (const char* name, const char* lineFormat) noexcept;
+};
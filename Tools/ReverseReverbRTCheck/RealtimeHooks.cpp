@@ -0,0 +1,187 @@
+// Interposed allocator, lock and system call entry points (glibc). The tool's
+// executable defines them, so every library it loads - JUCE, libstdc++'s
+// operator new, std::mutex - resolves to these first. Each one reports to
+// RealtimeChecker and then forwards to the real implementation.
+//
+// Non-blocking calls (pthread_mutex_trylock, unlocks, sem_post) are not hooked:
+// the audio thread may use them.
+
+#include "RealtimeChecker.h"
+#include <cstdarg>
+#include <cstddef>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+extern "C"
+{
+ // glibc's allocator under its public names - forwarding here needs no dlsym (which itself allocates)
+ void* __libc_malloc (std::size_t);
+ void* __libc_calloc (std::size_t, std::size_t);
+ void* __libc_realloc (void*, std::size_t);
+ void* __libc_memalign (std::size_t, std::size_t);
+ void __libc_free (void*);
+}
+
+namespace
+{
+ // The next definition of a hooked function (libc's), looked up once
+ template <typename Function>
+ Function findNext (const char* name) noexcept
+ {
+  return reinterpret_cast<Function> (dlsym (RTLD_NEXT, name));
+ }
+}
+
+#define REVERSEREVERB_FORWARD(name) \
+ static const auto next = findNext<decltype (&::name)> (#name)
+
+extern "C"
+{
+ //==============================================================================
+ void* malloc (std::size_t size) noexcept
+ {
+  RealtimeChecker::check ("malloc");
+  return __libc_malloc (size);
+ }
+
+ void* calloc (std::size_t count, std::size_t size) noexcept
+ {
+  RealtimeChecker::check ("calloc");
+  return __libc_calloc (count, size);
+ }
+
+ void* realloc (void* block, std::size_t size) noexcept
+ {
+  RealtimeChecker::check ("realloc");
+  return __libc_realloc (block, size);
+ }
+
+ void free (void* block) noexcept
+ {
+  if (block != nullptr)
+   RealtimeChecker::check ("free");
+
+  __libc_free (block);
+ }
+
+ int posix_memalign (void** result, std::size_t alignment, std::size_t size) noexcept
+ {
+  RealtimeChecker::check ("posix_memalign");
+  *result = __libc_memalign (alignment, size);
+  return *result != nullptr || size == 0 ? 0 : 12; // ENOMEM
+ }
+
+ void* aligned_alloc (std::size_t alignment, std::size_t size) noexcept
+ {
+  RealtimeChecker::check ("aligned_alloc");
+  return __libc_memalign (alignment, size);
+ }
+
+ //==============================================================================
+ int pthread_mutex_lock (pthread_mutex_t* mutex) noexcept
+ {
+  RealtimeChecker::check ("pthread_mutex_lock");
+  REVERSEREVERB_FORWARD (pthread_mutex_lock);
+  return next (mutex);
+ }
+
+ int pthread_rwlock_rdlock (pthread_rwlock_t* lock) noexcept
+ {
+  RealtimeChecker::check ("pthread_rwlock_rdlock");
+  REVERSEREVERB_FORWARD (pthread_rwlock_rdlock);
+  return next (lock);
+ }
+
+ int pthread_rwlock_wrlock (pthread_rwlock_t* lock) noexcept
+ {
+  RealtimeChecker::check ("pthread_rwlock_wrlock");
+  REVERSEREVERB_FORWARD (pthread_rwlock_wrlock);
+  return next (lock);
+ }
+
+ int pthread_cond_wait (pthread_cond_t* condition, pthread_mutex_t* mutex)
+ {
+  RealtimeChecker::check ("pthread_cond_wait");
+  REVERSEREVERB_FORWARD (pthread_cond_wait);
+  return next (condition, mutex);
+ }
+
+ int pthread_cond_timedwait (pthread_cond_t* condition, pthread_mutex_t* mutex, const struct timespec* time)
+ {
+  RealtimeChecker::check ("pthread_cond_timedwait");
+  REVERSEREVERB_FORWARD (pthread_cond_timedwait);
+  return next (condition, mutex, time);
+ }
+
+ int sem_wait (sem_t* semaphore)
+ {
+  RealtimeChecker::check ("sem_wait");
+  REVERSEREVERB_FORWARD (sem_wait);
+  return next (semaphore);
+ }
+
+ //==============================================================================
+ int open (const char* path, int flags, ...)
+ {
+  RealtimeChecker::check ("open");
+
+  mode_t mode = 0;
+  if ((flags & O_CREAT) != 0)
+  {
+   va_list args;
+   va_start (args, flags);
+   mode = (mode_t) va_arg (args, int);
+   va_end (args);
+  }
+
+  REVERSEREVERB_FORWARD (open);
+  return next (path, flags, mode);
+ }
+
+ ssize_t read (int file, void* data, std::size_t size)
+ {
+  RealtimeChecker::check ("read");
+  REVERSEREVERB_FORWARD (read);
+  return next (file, data, size);
+ }
+
+ ssize_t write (int file, const void* data, std::size_t size)
+ {
+  RealtimeChecker::check ("write");
+  REVERSEREVERB_FORWARD (write);
+  return next (file, data, size);
+ }
+
+ void* mmap (void* address, std::size_t length, int protection, int flags, int file, off_t offset) noexcept
+ {
+  RealtimeChecker::check ("mmap");
+  REVERSEREVERB_FORWARD (mmap);
+  return next (address, length, protection, flags, file, offset);
+ }
+
+ int munmap (void* address, std::size_t length) noexcept
+ {
+  RealtimeChecker::check ("munmap");
+  REVERSEREVERB_FORWARD (munmap);
+  return next (address, length);
+ }
+
+ int nanosleep (const struct timespec* duration, struct timespec* remaining)
+ {
+  RealtimeChecker::check ("nanosleep");
+  REVERSEREVERB_FORWARD (nanosleep);
+  return next (duration, remaining);
+ }
+
+ int usleep (useconds_t microseconds)
+ {
+  RealtimeChecker::check ("usleep");
+  REVERSEREVERB_FORWARD (usleep);
+  return next (microseconds);
+ }
+}